@@ -0,0 +1,337 @@
+// what:  construction, copy, swap and cast of dynamic_any and any_ref,
+//        next to boost::any and (where available) std::any
+// where: built with Google Benchmark; run the run_benchmarks target for
+//        results in JSON
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/any.hpp>
+
+#include "boost/any_ref.hpp"
+#include "boost/bounded_dynamic_any.hpp"
+#include "boost/dynamic_any.hpp"
+
+#if !defined(BOOST_NO_CXX17_HDR_ANY)
+#include <any>
+#endif
+
+namespace
+{
+    // held types, by size and category
+
+    struct small_class
+    {
+        small_class() : a(1), b(2) {}
+        long a, b;
+    };
+
+    struct large_class
+    {
+        large_class() { data[0] = 1; }
+        char data[256];
+    };
+
+    struct root
+    {
+        virtual ~root() {}
+        int id;
+    };
+
+    struct single : root
+    {
+        int extra;
+    };
+
+    struct left { int l; };
+    struct middle { int m; };
+
+    struct multiple : left, middle, root
+    {
+        int extra;
+    };
+
+    template<int N>
+    struct level : level<N - 1>
+    {
+        int data;
+    };
+
+    template<>
+    struct level<0> : root
+    {
+    };
+
+    typedef level<8> deep;
+
+    struct unrelated
+    {
+        virtual ~unrelated() {}
+    };
+
+    // one of many unregistered held types with root as a base, each with
+    // its own offset to it
+    template<int N>
+    struct many : root
+    {
+        char bytes[N + 1];
+    };
+
+    const int many_types = 100;
+
+    // the original dynamic_any held its value in a class derived from both
+    // the value's type and a polymorphic placeholder, and cast with
+    // dynamic_cast from the placeholder
+    struct placeholder
+    {
+        virtual ~placeholder() {}
+    };
+
+    template<typename T>
+    struct holder : placeholder, T
+    {
+    };
+
+    template<int N>
+    void add_many(std::vector<boost::dynamic_any> & values,
+        std::vector<std::unique_ptr<placeholder> > & holders)
+    {
+        add_many<N - 1>(values, holders);
+        values.push_back(many<N - 1>());
+        holders.emplace_back(new holder<many<N - 1> >());
+    }
+
+    template<>
+    void add_many<0>(std::vector<boost::dynamic_any> &, std::vector<std::unique_ptr<placeholder> > &)
+    {
+    }
+
+    // the base each category is cast to in the base-cast benchmarks
+    template<typename T> struct base_of { typedef T type; };
+    template<> struct base_of<single> { typedef root type; };
+    template<> struct base_of<multiple> { typedef root type; };
+    template<> struct base_of<deep> { typedef root type; };
+
+    // a type no value is held as, for the failing casts
+    template<typename T> struct miss_of { typedef unrelated type; };
+    template<> struct miss_of<int> { typedef long type; };
+
+    // the same operations on each of the compared types
+
+    template<typename Any>
+    struct any_traits;
+
+    template<>
+    struct any_traits<boost::dynamic_any>
+    {
+        template<typename T>
+        static T * cast(boost::dynamic_any & a) { return boost::dynamic_any_cast<T>(&a); }
+    };
+
+    template<>
+    struct any_traits<boost::any>
+    {
+        template<typename T>
+        static T * cast(boost::any & a) { return boost::any_cast<T>(&a); }
+    };
+
+#if !defined(BOOST_NO_CXX17_HDR_ANY)
+    template<>
+    struct any_traits<std::any>
+    {
+        template<typename T>
+        static T * cast(std::any & a) { return std::any_cast<T>(&a); }
+    };
+#endif
+
+    template<typename Any, typename T>
+    void construct(benchmark::State & state)
+    {
+        const T value = T();
+        for(auto _ : state)
+        {
+            Any a(value);
+            benchmark::DoNotOptimize(a);
+        }
+    }
+
+    template<typename Any, typename T>
+    void copy(benchmark::State & state)
+    {
+        const Any original = T();
+        for(auto _ : state)
+        {
+            Any a(original);
+            benchmark::DoNotOptimize(a);
+        }
+    }
+
+    template<typename Any, typename T>
+    void swap(benchmark::State & state)
+    {
+        Any a = T(), b = T();
+        for(auto _ : state)
+        {
+            a.swap(b);
+            benchmark::DoNotOptimize(a);
+            benchmark::DoNotOptimize(b);
+        }
+    }
+
+    template<typename Any, typename T>
+    void cast_hit(benchmark::State & state)
+    {
+        Any a = T();
+        benchmark::DoNotOptimize(a);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(any_traits<Any>::template cast<T>(a));
+    }
+
+    template<typename Any, typename T>
+    void cast_miss(benchmark::State & state)
+    {
+        typedef typename miss_of<T>::type miss;
+        Any a = T();
+        benchmark::DoNotOptimize(a);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(any_traits<Any>::template cast<miss>(a));
+    }
+
+    // only dynamic_any can cast to a base of the held type
+    template<typename T>
+    void cast_base(benchmark::State & state)
+    {
+        typedef typename base_of<T>::type base;
+        boost::dynamic_any a = T();
+        benchmark::DoNotOptimize(a);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(boost::dynamic_any_cast<base>(&a));
+    }
+
+    // the same casts, with the held types bounded at compile time
+    template<typename T>
+    void cast_base_bounded(benchmark::State & state)
+    {
+        typedef typename base_of<T>::type base;
+        boost::bounded_dynamic_any<double, T> a = T();
+        benchmark::DoNotOptimize(a);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(boost::dynamic_any_cast<base>(&a));
+    }
+
+    // Every thread casts its own values of several held types to their
+    // common base.  The casts only read shared cache state, so the time
+    // per cast should stay flat as threads are added.
+    void cast_base_threads(benchmark::State & state)
+    {
+        std::vector<boost::dynamic_any> values;
+        values.push_back(single());
+        values.push_back(multiple());
+        values.push_back(deep());
+        values.push_back(level<3>());
+        for(auto _ : state)
+            for(boost::dynamic_any & value : values)
+                benchmark::DoNotOptimize(boost::dynamic_any_cast<root>(&value));
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+
+    // More held types than the cast caches hold, cast to a base none of
+    // them registers, against the original dynamic_cast.
+    void cast_base_many(benchmark::State & state)
+    {
+        std::vector<boost::dynamic_any> values;
+        std::vector<std::unique_ptr<placeholder> > holders;
+        add_many<many_types>(values, holders);
+        for(auto _ : state)
+            for(boost::dynamic_any & value : values)
+                benchmark::DoNotOptimize(boost::dynamic_any_cast<root>(&value));
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+
+    void dynamic_cast_many(benchmark::State & state)
+    {
+        std::vector<boost::dynamic_any> values;
+        std::vector<std::unique_ptr<placeholder> > holders;
+        add_many<many_types>(values, holders);
+        for(auto _ : state)
+            for(const std::unique_ptr<placeholder> & held : holders)
+                benchmark::DoNotOptimize(dynamic_cast<root *>(held.get()));
+        state.SetItemsProcessed(state.iterations() * holders.size());
+    }
+
+    template<typename T>
+    void any_ref_const(benchmark::State & state)
+    {
+        T value = T();
+        boost::any_ref r = value;
+        benchmark::DoNotOptimize(r);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(&static_cast<const T &>(r));
+    }
+
+    template<typename T>
+    void any_ref_mutable(benchmark::State & state)
+    {
+        T value = T();
+        boost::any_ref r = value;
+        benchmark::DoNotOptimize(r);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(r.ptr<T>());
+    }
+
+    template<typename T>
+    void any_ref_miss(benchmark::State & state)
+    {
+        typedef typename miss_of<T>::type miss;
+        T value = T();
+        boost::any_ref r = value;
+        benchmark::DoNotOptimize(r);
+        for(auto _ : state)
+            benchmark::DoNotOptimize(r.const_ptr<miss>());
+    }
+}
+
+#define BOOST_DYNAMIC_ANY_BENCHMARK_ANY(Any, T) \
+    BENCHMARK_TEMPLATE(construct, Any, T); \
+    BENCHMARK_TEMPLATE(copy, Any, T); \
+    BENCHMARK_TEMPLATE(swap, Any, T); \
+    BENCHMARK_TEMPLATE(cast_hit, Any, T); \
+    BENCHMARK_TEMPLATE(cast_miss, Any, T)
+
+#if !defined(BOOST_NO_CXX17_HDR_ANY)
+#define BOOST_DYNAMIC_ANY_BENCHMARK_STD_ANY(T) BOOST_DYNAMIC_ANY_BENCHMARK_ANY(std::any, T)
+#else
+#define BOOST_DYNAMIC_ANY_BENCHMARK_STD_ANY(T)
+#endif
+
+#define BOOST_DYNAMIC_ANY_BENCHMARK(T) \
+    BOOST_DYNAMIC_ANY_BENCHMARK_ANY(boost::dynamic_any, T); \
+    BOOST_DYNAMIC_ANY_BENCHMARK_ANY(boost::any, T); \
+    BOOST_DYNAMIC_ANY_BENCHMARK_STD_ANY(T); \
+    BENCHMARK_TEMPLATE(cast_base, T); \
+    BENCHMARK_TEMPLATE(cast_base_bounded, T); \
+    BENCHMARK_TEMPLATE(any_ref_const, T); \
+    BENCHMARK_TEMPLATE(any_ref_mutable, T); \
+    BENCHMARK_TEMPLATE(any_ref_miss, T)
+
+BOOST_DYNAMIC_ANY_BENCHMARK(int);
+BOOST_DYNAMIC_ANY_BENCHMARK(std::string);
+BOOST_DYNAMIC_ANY_BENCHMARK(small_class);
+BOOST_DYNAMIC_ANY_BENCHMARK(large_class);
+BOOST_DYNAMIC_ANY_BENCHMARK(single);
+BOOST_DYNAMIC_ANY_BENCHMARK(multiple);
+BOOST_DYNAMIC_ANY_BENCHMARK(deep);
+
+BENCHMARK(cast_base_many);
+BENCHMARK(dynamic_cast_many);
+
+BENCHMARK(cast_base_threads)
+    ->ThreadRange(1, std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() : 1)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,139 @@
+// what:  parallel_reduce and parallel_transform over a large vector of
+//        dynamic_any, on 1, 2, 4, ... up to the hardware threads, against
+//        a serial loop of visit calls
+// where: built with Google Benchmark; times are wall clock, as the work
+//        is spread over several threads
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "boost/dynamic_any_parallel.hpp"
+
+namespace
+{
+    struct shape
+    {
+        virtual ~shape() {}
+        double size;
+    };
+
+    struct circle : shape
+    {
+        circle() { size = 1.5; }
+    };
+
+    struct square : shape
+    {
+        square() { size = 2.0; }
+    };
+}
+
+BOOST_DYNAMIC_ANY_BASES(circle, shape)
+BOOST_DYNAMIC_ANY_BASES(square, shape)
+
+namespace
+{
+    const std::size_t element_count = 4 * 1000 * 1000;
+
+    // runs of one held type, of pseudo-random lengths up to 64, as
+    // records of one kind tend to come in batches
+    const std::vector<boost::dynamic_any> & values()
+    {
+        static std::vector<boost::dynamic_any> values;
+        if(values.empty())
+        {
+            values.reserve(element_count);
+            unsigned seed = 12345;
+            while(values.size() != element_count)
+            {
+                seed = seed * 1103515245 + 12345;
+                const unsigned kind = (seed >> 16) % 4;
+                for(unsigned n = (seed >> 8) % 64 + 1; n != 0 && values.size() != element_count; --n)
+                    switch(kind)
+                    {
+                    case 0: values.push_back(int(n)); break;
+                    case 1: values.push_back(double(n)); break;
+                    case 2: values.push_back(circle()); break;
+                    default: values.push_back(square()); break;
+                    }
+            }
+        }
+        return values;
+    }
+
+    struct measure
+    {
+        double operator()(const int & i) const { return i; }
+        double operator()(const double & d) const { return d * 0.5; }
+        double operator()(const shape & s) const { return s.size * s.size; }
+    };
+
+    struct plus
+    {
+        double operator()(double a, double b) const { return a + b; }
+    };
+
+    double unknown(const boost::dynamic_any &)
+    {
+        return 0;
+    }
+
+    void serial_visit(benchmark::State & state)
+    {
+        const std::vector<boost::dynamic_any> & v = values();
+        for(auto _ : state)
+        {
+            double sum = 0;
+            for(std::size_t i = 0; i != v.size(); ++i)
+                sum += boost::visit<int, double, shape>(v[i], measure(), &unknown);
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * v.size());
+    }
+
+    void parallel_reduce(benchmark::State & state)
+    {
+        const std::vector<boost::dynamic_any> & v = values();
+        boost::parallel_executor executor(state.range(0));
+        for(auto _ : state)
+            benchmark::DoNotOptimize(boost::parallel_reduce<int, double, shape>(
+                executor, v.begin(), v.end(), 0.0, measure(), plus()));
+        state.SetItemsProcessed(state.iterations() * v.size());
+    }
+
+    void parallel_transform(benchmark::State & state)
+    {
+        const std::vector<boost::dynamic_any> & v = values();
+        std::vector<double> out(v.size());
+        boost::parallel_executor executor(state.range(0));
+        for(auto _ : state)
+        {
+            boost::parallel_transform<int, double, shape>(
+                executor, v.begin(), v.end(), out.begin(), measure(), &unknown);
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetItemsProcessed(state.iterations() * v.size());
+    }
+
+    // 1, 2, 4, ... threads, and the number of hardware threads
+    void thread_counts(benchmark::internal::Benchmark * b)
+    {
+        const int hardware = int((std::max)(std::thread::hardware_concurrency(), 1u));
+        for(int threads = 1; threads < hardware; threads *= 2)
+            b->Arg(threads);
+        b->Arg(hardware);
+    }
+}
+
+BENCHMARK(serial_visit)->UseRealTime();
+BENCHMARK(parallel_reduce)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(parallel_transform)->Apply(thread_counts)->UseRealTime();
+
+BENCHMARK_MAIN();
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
@@ -0,0 +1,144 @@
+// what:  dynamic_any_queue against a std::deque of boost::any behind a
+//        mutex: throughput with half the threads pushing and half popping,
+//        and the latency of a round trip between two threads
+// where: built with Google Benchmark; run with as many threads as the
+//        machine has for the contended cases to mean anything
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/any.hpp>
+
+#include "boost/dynamic_any_queue.hpp"
+
+namespace
+{
+    struct message
+    {
+        long sequence;
+        double payload[2];
+    };
+
+    // the usual alternative: a heap allocated holder per message
+    class locked_queue
+    {
+    public:
+        bool try_push(boost::any && value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_values.push_back(static_cast<boost::any &&>(value));
+            return true;
+        }
+
+        bool try_pop(boost::any & value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_values.empty())
+                return false;
+            value = static_cast<boost::any &&>(m_values.front());
+            m_values.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::deque<boost::any> m_values;
+    };
+
+    template<typename Queue>
+    Queue & shared_queue();
+
+    template<>
+    boost::dynamic_any_queue & shared_queue<boost::dynamic_any_queue>()
+    {
+        static boost::dynamic_any_queue queue(1024);
+        return queue;
+    }
+
+    template<>
+    locked_queue & shared_queue<locked_queue>()
+    {
+        static locked_queue queue;
+        return queue;
+    }
+
+    // Even threads push, odd ones pop, one message per iteration; with an
+    // even number of threads as many messages go in as come out.
+    template<typename Queue, typename Any>
+    void throughput(benchmark::State & state)
+    {
+        Queue & queue = shared_queue<Queue>();
+        const bool producer = state.thread_index() % 2 == 0;
+        message m = { 0, { 1.0, 2.0 } };
+        Any value;
+        for(auto _ : state)
+        {
+            if(producer)
+            {
+                ++m.sequence;
+                Any pushed = m;
+                while(!queue.try_push(static_cast<Any &&>(pushed)))
+                    std::this_thread::yield();
+            }
+            else
+            {
+                while(!queue.try_pop(value))
+                    std::this_thread::yield();
+                benchmark::DoNotOptimize(value);
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // one message to a thread that sends it straight back
+    template<typename Queue, typename Any>
+    void round_trip(benchmark::State & state)
+    {
+        Queue there(64), back(64);
+        std::atomic<bool> done(false);
+        std::thread echo([&] {
+            Any value;
+            while(!done.load(std::memory_order_relaxed))
+                if(there.try_pop(value))
+                    back.try_push(static_cast<Any &&>(value));
+                else
+                    std::this_thread::yield();
+        });
+
+        message m = { 0, { 1.0, 2.0 } };
+        Any value;
+        for(auto _ : state)
+        {
+            ++m.sequence;
+            there.try_push(Any(m));
+            while(!back.try_pop(value))
+                std::this_thread::yield();
+        }
+        done = true;
+        echo.join();
+    }
+
+    // the constructor the round trip needs
+    class bounded_locked_queue : public locked_queue
+    {
+    public:
+        explicit bounded_locked_queue(std::size_t) {}
+    };
+}
+
+BENCHMARK_TEMPLATE(throughput, boost::dynamic_any_queue, boost::dynamic_any)
+    ->ThreadRange(2, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(throughput, locked_queue, boost::any)
+    ->ThreadRange(2, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(round_trip, boost::dynamic_any_queue, boost::dynamic_any)->UseRealTime();
+BENCHMARK_TEMPLATE(round_trip, bounded_locked_queue, boost::any)->UseRealTime();
+
+BENCHMARK_MAIN();
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
@@ -0,0 +1,189 @@
+// what:  calls through dynamic_function, against a direct call, a
+//        std::function and unpacking the any_ref arguments by hand; and
+//        calls by name through dynamic_method_registry, against a
+//        std::map from names to functions
+// where: built with Google Benchmark
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "boost/dynamic_function.hpp"
+#include "boost/dynamic_method_registry.hpp"
+
+namespace
+{
+    BOOST_NOINLINE long scale(long x, const double & factor)
+    {
+        return long(x * factor);
+    }
+
+    BOOST_NOINLINE std::size_t measure(const std::string & s)
+    {
+        return s.size();
+    }
+
+    void direct_call(benchmark::State & state)
+    {
+        long x = 3;
+        double factor = 2.5;
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(x);
+            benchmark::DoNotOptimize(scale(x, factor));
+        }
+    }
+
+    void std_function(benchmark::State & state)
+    {
+        const std::function<long(long, const double &)> f = &scale;
+        long x = 3;
+        double factor = 2.5;
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(x);
+            benchmark::DoNotOptimize(f(x, factor));
+        }
+    }
+
+    // what a bridge does without dynamic_function: one checked
+    // conversion per argument, then the call
+    void any_ref_by_hand(benchmark::State & state)
+    {
+        long x = 3;
+        double factor = 2.5;
+        const boost::any_ref args[] = { boost::any_ref(x), boost::any_ref(factor) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            const long * a = args[0].const_ptr<long>();
+            const double * b = args[1].const_ptr<double>();
+            boost::dynamic_any result;
+            if(a && b)
+                result = scale(*a, *b);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    void dynamic_function_call(benchmark::State & state)
+    {
+        const boost::dynamic_function f = &scale;
+        long x = 3;
+        double factor = 2.5;
+        const boost::any_ref args[] = { boost::any_ref(x), boost::any_ref(factor) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            benchmark::DoNotOptimize(f(args, 2));
+        }
+    }
+
+    void dynamic_function_string(benchmark::State & state)
+    {
+        const boost::dynamic_function f = &measure;
+        const std::string s = "a string argument";
+        const boost::any_ref args[] = { boost::any_ref(s) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            benchmark::DoNotOptimize(f(args, 1));
+        }
+    }
+
+    void dynamic_function_mismatch(benchmark::State & state)
+    {
+        const boost::dynamic_function f = &scale;
+        int x = 3;
+        double factor = 2.5;
+        const boost::any_ref args[] = { boost::any_ref(x), boost::any_ref(factor) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            benchmark::DoNotOptimize(f.accepts(args, 2));
+        }
+    }
+
+    // names of a typical RPC interface, most of them unused here
+    const char * const method_names[] =
+    {
+        "account.open", "account.close", "account.balance", "account.deposit",
+        "account.withdraw", "order.place", "order.cancel", "order.status",
+        "quote.get", "quote.subscribe", "session.login", "session.logout"
+    };
+
+    // the lookup a hand-rolled dispatcher does: the name, then the first
+    // overload taking the arguments
+    void map_by_name(benchmark::State & state)
+    {
+        std::map<std::string, std::vector<boost::dynamic_function> > methods;
+        for(const char * name : method_names)
+            methods[name].push_back(&measure);
+        methods["quote.get"].push_back(&scale);
+
+        const std::string name = "quote.get";
+        long x = 3;
+        double factor = 2.5;
+        const boost::any_ref args[] = { boost::any_ref(x), boost::any_ref(factor) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            const std::vector<boost::dynamic_function> & overloads = methods.find(name)->second;
+            for(const boost::dynamic_function & f : overloads)
+                if(f.accepts(args, 2))
+                {
+                    benchmark::DoNotOptimize(f(args, 2));
+                    break;
+                }
+        }
+    }
+
+    void registry_by_name(benchmark::State & state)
+    {
+        boost::dynamic_method_registry methods;
+        for(const char * name : method_names)
+            methods.add(name, &measure);
+        methods.add("quote.get", &scale);
+
+        const std::string name = "quote.get";
+        long x = 3;
+        double factor = 2.5;
+        const boost::any_ref args[] = { boost::any_ref(x), boost::any_ref(factor) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            benchmark::DoNotOptimize(methods.call(name, args, 2));
+        }
+    }
+
+    void registry_by_id(benchmark::State & state)
+    {
+        boost::dynamic_method_registry methods;
+        for(const char * name : method_names)
+            methods.add(name, &measure);
+        const boost::dynamic_method_registry::method_id id = methods.add("quote.get", &scale);
+
+        long x = 3;
+        double factor = 2.5;
+        const boost::any_ref args[] = { boost::any_ref(x), boost::any_ref(factor) };
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(args);
+            benchmark::DoNotOptimize(methods.call(id, args, 2));
+        }
+    }
+}
+
+BENCHMARK(direct_call);
+BENCHMARK(std_function);
+BENCHMARK(any_ref_by_hand);
+BENCHMARK(dynamic_function_call);
+BENCHMARK(dynamic_function_string);
+BENCHMARK(dynamic_function_mismatch);
+BENCHMARK(map_by_name);
+BENCHMARK(registry_by_name);
+BENCHMARK(registry_by_id);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,166 @@
+// what:  streaming a mapped file of encoded records with dynamic_any_reader,
+//        against loading it all into a std::vector<dynamic_any> and against
+//        copying the file's bytes
+// where: built with Google Benchmark
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "boost/dynamic_any_reader.hpp"
+
+namespace
+{
+    struct event
+    {
+        long timestamp;
+        int source;
+        int kind;
+    };
+
+    const char * const file_name = "reader_benchmark.bin";
+
+    const boost::dynamic_any_registry & registry()
+    {
+        static const boost::dynamic_any_registry instance = []() {
+            boost::dynamic_any_registry r;
+            r.add<int>(1);
+            r.add<double>(2);
+            r.add<event>(3);
+            r.add<std::string>(4);
+            return r;
+        }();
+        return instance;
+    }
+
+    // about 32 MB of heterogeneous records, written once per run
+    struct sample_file
+    {
+        sample_file()
+        {
+            std::vector<char> buffer;
+            for(int i = 0; buffer.size() < (32u << 20); ++i)
+            {
+                switch(i % 4)
+                {
+                case 0: registry().encode(boost::dynamic_any(i), buffer); break;
+                case 1: registry().encode(boost::dynamic_any(i * 0.5), buffer); break;
+                case 2:
+                {
+                    event e = { i, i % 16, i % 5 };
+                    registry().encode(boost::dynamic_any(e), buffer);
+                    break;
+                }
+                default: registry().encode(boost::dynamic_any(std::string("message")), buffer); break;
+                }
+            }
+            std::ofstream(file_name, std::ios::binary).write(buffer.data(), buffer.size());
+        }
+
+        ~sample_file()
+        {
+            std::remove(file_name);
+        }
+    };
+
+    const boost::mapped_dynamic_any_file & mapped()
+    {
+        static const sample_file written;
+        static const boost::mapped_dynamic_any_file file(file_name);
+        return file;
+    }
+
+    long summarize(const boost::dynamic_any & value)
+    {
+        if(const int * i = boost::dynamic_any_cast<int>(&value))
+            return *i;
+        if(const double * d = boost::dynamic_any_cast<double>(&value))
+            return long(*d);
+        if(const event * e = boost::dynamic_any_cast<event>(&value))
+            return e->kind;
+        return long(boost::dynamic_any_cast<const std::string &>(value).size());
+    }
+
+    long summarize(const boost::any_ref & value)
+    {
+        if(const int * i = value.const_ptr<int>())
+            return *i;
+        if(const double * d = value.const_ptr<double>())
+            return long(*d);
+        if(const event * e = value.const_ptr<event>())
+            return e->kind;
+        return long(static_cast<const std::string &>(value).size());
+    }
+
+    void copy_bytes(benchmark::State & state)
+    {
+        const boost::mapped_dynamic_any_file & file = mapped();
+        std::vector<char> copy(file.size());
+        for(auto _ : state)
+        {
+            std::memcpy(copy.data(), file.data(), file.size());
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * file.size());
+    }
+
+    void load_vector(benchmark::State & state)
+    {
+        const boost::mapped_dynamic_any_file & file = mapped();
+        for(auto _ : state)
+        {
+            std::vector<boost::dynamic_any> values;
+            for(std::size_t position = 0; position < file.size(); )
+            {
+                values.push_back(boost::dynamic_any());
+                position = registry().decode(file.data(), file.size(), position, values.back());
+            }
+            long sum = 0;
+            for(const boost::dynamic_any & value : values)
+                sum += summarize(value);
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetBytesProcessed(state.iterations() * file.size());
+    }
+
+    void stream_decode(benchmark::State & state)
+    {
+        const boost::mapped_dynamic_any_file & file = mapped();
+        for(auto _ : state)
+        {
+            boost::dynamic_any_reader reader(registry(), file);
+            boost::dynamic_any value;
+            long sum = 0;
+            while(reader.next(value))
+                sum += summarize(value);
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetBytesProcessed(state.iterations() * file.size());
+    }
+
+    void stream_view(benchmark::State & state)
+    {
+        const boost::mapped_dynamic_any_file & file = mapped();
+        for(auto _ : state)
+        {
+            boost::dynamic_any_reader reader(registry(), file);
+            boost::any_ref value;
+            long sum = 0;
+            while(reader.next(value))
+                sum += summarize(value);
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetBytesProcessed(state.iterations() * file.size());
+    }
+}
+
+BENCHMARK(copy_bytes)->Unit(benchmark::kMillisecond);
+BENCHMARK(load_vector)->Unit(benchmark::kMillisecond);
+BENCHMARK(stream_decode)->Unit(benchmark::kMillisecond);
+BENCHMARK(stream_view)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+// what:  visit<Types...> against a chain of dynamic_any_casts
+// where: built with Google Benchmark
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "boost/dynamic_any_visit.hpp"
+
+namespace
+{
+    struct shape
+    {
+        virtual ~shape() {}
+        int id;
+    };
+
+    struct circle : shape
+    {
+        circle() { id = 1; }
+        double radius;
+    };
+
+    struct square : shape
+    {
+        square() { id = 2; }
+        double side;
+    };
+
+    struct label
+    {
+        char text[32];
+    };
+
+    // values of six held types, spread evenly over the alternatives
+    // below and interleaved so that the branch predictor cannot learn
+    // their order
+    std::vector<boost::dynamic_any> mixed_values(std::size_t count)
+    {
+        std::vector<boost::dynamic_any> values;
+        values.reserve(count);
+        unsigned seed = 12345;
+        for(std::size_t i = 0; i != count; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            switch((seed >> 16) % 6)
+            {
+            case 0: values.push_back(boost::dynamic_any(int(i))); break;
+            case 1: values.push_back(boost::dynamic_any(double(i))); break;
+            case 2: values.push_back(boost::dynamic_any(std::string("value"))); break;
+            case 3: values.push_back(boost::dynamic_any(circle())); break;
+            case 4: values.push_back(boost::dynamic_any(square())); break;
+            default: values.push_back(boost::dynamic_any(label())); break;
+            }
+        }
+        return values;
+    }
+
+    struct summarize
+    {
+        long operator()(int & i) const { return i; }
+        long operator()(double & d) const { return long(d); }
+        long operator()(std::string & s) const { return long(s.size()); }
+        long operator()(shape & s) const { return s.id; }
+        long operator()(label &) const { return 3; }
+    };
+
+    long none(boost::dynamic_any &)
+    {
+        return -1;
+    }
+
+    void if_chain(benchmark::State & state)
+    {
+        std::vector<boost::dynamic_any> values = mixed_values(state.range(0));
+        summarize f;
+        for(auto _ : state)
+        {
+            long sum = 0;
+            for(boost::dynamic_any & value : values)
+            {
+                if(int * i = boost::dynamic_any_cast<int>(&value))
+                    sum += f(*i);
+                else if(double * d = boost::dynamic_any_cast<double>(&value))
+                    sum += f(*d);
+                else if(std::string * s = boost::dynamic_any_cast<std::string>(&value))
+                    sum += f(*s);
+                else if(shape * sh = boost::dynamic_any_cast<shape>(&value))
+                    sum += f(*sh);
+                else if(label * l = boost::dynamic_any_cast<label>(&value))
+                    sum += f(*l);
+                else
+                    sum += none(value);
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+
+    void visit(benchmark::State & state)
+    {
+        std::vector<boost::dynamic_any> values = mixed_values(state.range(0));
+        for(auto _ : state)
+        {
+            long sum = 0;
+            for(boost::dynamic_any & value : values)
+                sum += boost::visit<int, double, std::string, shape, label>(
+                    value, summarize(), none);
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+}
+
+BENCHMARK(if_chain)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(visit)->Arg(1 << 10)->Arg(1 << 16);
+
+BENCHMARK_MAIN();
@@ -1,43 +1,77 @@
 #ifndef _BOOST_ANY_REF_HPP_
 #define _BOOST_ANY_REF_HPP_
 #include <typeinfo>
-#include <new>
-#include <string.h>
+#include <boost/config.hpp>
 #include <boost/throw_exception.hpp>
+#include <boost/type_index.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/core/addressof.hpp>
+#include <boost/core/enable_if.hpp>
+#include <boost/none.hpp>
+#include <boost/optional/optional.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/remove_const.hpp>
 
 namespace boost {
 
+class any_ref;
+
 namespace detail {
     namespace any_ref {
-        struct place_holder {
-            virtual ~place_holder(){}
-            virtual const std::type_info & type() const { 
-                return typeid(place_holder); 
-            }
+        /**
+            One token exists per referenced type and constness, so comparing token
+            addresses is all it takes to match a reference in the common case.
+        */
+        struct type_token {
+            const boost::typeindex::type_info& (*type)();
+            bool is_mutable;
         };
 
         template<typename T>
-        struct place_holder_impl : private place_holder {
-        };
+        inline const boost::typeindex::type_info& type_of() {
+            return boost::typeindex::type_id<T>().type_info();
+        }
 
         template<typename T>
-        struct place_holder_impl<const T&> : public place_holder {
-            place_holder_impl( const T& v ):m_ref(v){}
-            virtual const std::type_info & type() const {
-                return typeid(const T&);
-            }
-            const T& m_ref;
+        struct tokens {
+            static const type_token const_ref;
+            static const type_token mutable_ref;
         };
 
         template<typename T>
-        struct place_holder_impl<T&> : public place_holder_impl<const T&> {
-            place_holder_impl( T& v )
-            :place_holder_impl<const T&>(v){}
+        const type_token tokens<T>::const_ref = { &type_of<T>, false };
 
-            virtual const std::type_info & type() const {
-                return typeid(T&);
-            }
+        template<typename T>
+        const type_token tokens<T>::mutable_ref = { &type_of<T>, true };
+
+        // Tokens of the same type can only have different addresses when the
+        // any_ref was created in another shared object; the type ids still match.
+        inline bool same_type( const type_token* a, const type_token* b ) {
+            return a->type == b->type
+                || boost::typeindex::type_index(a->type()) == boost::typeindex::type_index(b->type());
+        }
+
+        // keeps the converting constructors and assignments from wrapping an
+        // any_ref in another one instead of copying it
+        template<typename T, typename R = void>
+        struct disable_if_any_ref
+            : boost::disable_if< boost::is_same<typename boost::remove_cv<T>::type, boost::any_ref>, R > {};
+
+        // const T may refer to a const object, T only to a mutable one
+        template<typename T, bool IsConst = boost::is_const<T>::value>
+        struct pointer {
+            template<typename Ref>
+            static T* get( const Ref& r ) { return r.template ptr<T>(); }
         };
+
+        template<typename T>
+        struct pointer<T, true> {
+            template<typename Ref>
+            static T* get( const Ref& r ) { return r.template const_ptr<typename boost::remove_const<T>::type>(); }
+        };
+
+        struct access;
    } // namespace any_ref
 } // namespace detail
 
@@ -56,25 +90,31 @@ namespace detail {
     The motivation behind creating this class was to provide a polymorphic interface
     to methods of different signatures.  This is useful for runtime invocation of
     methods.
+
+    An any_ref is two words, the address of the referenced object and a token for
+    its type and constness, and is trivially copyable.  Conversions compare tokens
+    and never go through a vtable or dynamic_cast.
 */
-class any_ref 
+class any_ref
 {
     public:
-        any_ref() {
-            new (held) detail::any_ref::place_holder();
-        }
+        any_ref()
+        :m_ptr(0),m_token(&detail::any_ref::tokens<void>::const_ref){}
 
         template<typename T>
-        any_ref( const T& v ) {
-            new (held) detail::any_ref::place_holder_impl<const T&>(v);
-        }
+        any_ref( const T& v, typename detail::any_ref::disable_if_any_ref<T>::type* = 0 )
+        :m_ptr(const_cast<T*>(boost::addressof(v))),
+         m_token(&detail::any_ref::tokens<typename boost::remove_cv<T>::type>::const_ref){}
 
         template<typename T>
-        any_ref( T& v ) {
-            new (held) detail::any_ref::place_holder_impl<T&>(v);
-        }
+        any_ref( T& v, typename detail::any_ref::disable_if_any_ref<T>::type* = 0 )
+        :m_ptr(boost::addressof(v)),
+         m_token(&detail::any_ref::tokens<T>::mutable_ref){}
+
+        const boost::typeindex::type_info& type()const { return m_token->type(); }
 
-        const std::type_info& type()const { return ((detail::any_ref::place_holder*)held)->type(); }
+        /** @return true if the referenced object may be modified through ptr<T>() */
+        bool is_mutable()const { return m_token->is_mutable; }
 
         template<typename T>
         inline operator const T&()const {
@@ -83,12 +123,14 @@ class any_ref
                 boost::throw_exception(bad_any_ref_cast());
             return *v;
         }
+        /** @return the referenced object, or NULL if it is not a T; never throws */
         template<typename T>
-        inline const T* const_ptr()const {
-            detail::any_ref::place_holder_impl<const T&>* p = 
-                dynamic_cast<detail::any_ref::place_holder_impl<const T&>* >((detail::any_ref::place_holder*)held);
-            if( p ) 
-                return &p->m_ref;
+        inline const T* const_ptr()const BOOST_NOEXCEPT {
+            typedef typename boost::remove_cv<T>::type type;
+            if( BOOST_LIKELY( m_token == &detail::any_ref::tokens<type>::mutable_ref ||
+                              m_token == &detail::any_ref::tokens<type>::const_ref ) ||
+                detail::any_ref::same_type( m_token, &detail::any_ref::tokens<type>::const_ref ) )
+                return static_cast<const T*>(m_ptr);
             return 0;
         }
 
@@ -99,36 +141,70 @@ class any_ref
                 boost::throw_exception(bad_any_ref_cast());
             return *v;
         }
+        /** @return the referenced object, or NULL if it is not a mutable T; never throws */
         template<typename T>
-        inline T* ptr()const {
-            detail::any_ref::place_holder_impl<T&>* p = 
-                dynamic_cast<detail::any_ref::place_holder_impl<T&>* >((detail::any_ref::place_holder*)held);
-            if( p ) 
-                return const_cast<T*>(&p->m_ref);
+        inline T* ptr()const BOOST_NOEXCEPT {
+            typedef typename boost::remove_cv<T>::type type;
+            if( BOOST_LIKELY( m_token == &detail::any_ref::tokens<type>::mutable_ref ) ||
+                ( m_token->is_mutable &&
+                  detail::any_ref::same_type( m_token, &detail::any_ref::tokens<type>::mutable_ref ) ) )
+                return static_cast<T*>(m_ptr);
             return 0;
         }
 
-        any_ref& operator=( const any_ref& r ) {
-            if( this != &r )
-                memcpy(held,r.held,sizeof(held));
-            return *this;
-        }
         template<typename T>
-        any_ref& operator=( const T& v ) {
-            new (held) detail::any_ref::place_holder_impl<const T&>(v);
-            return *this;
+        typename detail::any_ref::disable_if_any_ref<T, any_ref&>::type
+        operator=( const T& v ) {
+            return *this = any_ref(v);
         }
         template<typename T>
-        any_ref& operator=( T& v ) {
-            new (held) detail::any_ref::place_holder_impl<T&>(v);
-            return *this;
+        typename detail::any_ref::disable_if_any_ref<T, any_ref&>::type
+        operator=( T& v ) {
+            return *this = any_ref(v);
         }
 
     private:
+        friend struct detail::any_ref::access;
 
-        char held[sizeof(detail::any_ref::place_holder_impl<const int&>)];
+        void*                               m_ptr;
+        const detail::any_ref::type_token*  m_token;
 };
 
+namespace detail {
+    namespace any_ref {
+        /**
+            Lets code built on any_ref, such as dynamic_function, match the token
+            itself and reach the referenced object without converting.
+        */
+        struct access {
+            static const type_token* token( const ::boost::any_ref& r ) { return r.m_token; }
+            static void* address( const ::boost::any_ref& r ) { return r.m_ptr; }
+            // refers to the object at address with token, which must be one of its type's
+            static ::boost::any_ref refer( void* address, const type_token* token ) {
+                ::boost::any_ref r;
+                r.m_ptr = address;
+                r.m_token = token;
+                return r;
+            }
+        };
+    } // namespace any_ref
+} // namespace detail
+
+/**
+    @brief non-throwing counterpart of the reference conversions.
+
+    try_cast<T>(r) refers to the object only if it is a mutable T, try_cast<const T>(r)
+    to any T; otherwise the optional is empty instead of bad_any_ref_cast being thrown.
+*/
+template<typename T, typename Ref>
+inline typename boost::enable_if< boost::is_same<Ref, any_ref>, boost::optional<T&> >::type
+try_cast( const Ref& r ) BOOST_NOEXCEPT {
+    T* v = detail::any_ref::pointer<T>::get( r );
+    if( BOOST_LIKELY( v != 0 ) )
+        return boost::optional<T&>( *v );
+    return boost::none;
+}
+
 } // namespace boost
 
 #endif
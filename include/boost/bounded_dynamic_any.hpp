@@ -0,0 +1,526 @@
+#ifndef BOOST_BOUNDED_DYNAMIC_ANY_INCLUDED
+#define BOOST_BOUNDED_DYNAMIC_ANY_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <boost/config.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/none.hpp>
+#include <boost/optional/optional.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) \
+ || defined(BOOST_NO_CXX11_CONSTEXPR)
+#  error "boost/bounded_dynamic_any.hpp requires rvalue references, variadic templates and constexpr"
+#endif
+
+namespace boost
+{
+    template<typename... Types>
+    class bounded_dynamic_any;
+
+namespace detail {
+    namespace bounded_dynamic_any {
+        // position of ValueType in Types, or sizeof...(Types) if absent
+        template<typename ValueType, typename... Types>
+        struct index_of;
+
+        template<typename ValueType>
+        struct index_of<ValueType>
+          : std::integral_constant<std::size_t, 0>
+        {
+        };
+
+        template<typename ValueType, typename... Types>
+        struct index_of<ValueType, ValueType, Types...>
+          : std::integral_constant<std::size_t, 0>
+        {
+        };
+
+        template<typename ValueType, typename First, typename... Types>
+        struct index_of<ValueType, First, Types...>
+          : std::integral_constant<std::size_t, 1 + index_of<ValueType, Types...>::value>
+        {
+        };
+
+        constexpr std::size_t larger(std::size_t lhs, std::size_t rhs)
+        {
+            return lhs > rhs ? lhs : rhs;
+        }
+
+        constexpr std::size_t max_of()
+        {
+            return 1;
+        }
+
+        template<typename... Sizes>
+        constexpr std::size_t max_of(std::size_t first, Sizes... rest)
+        {
+            return larger(first, max_of(rest...));
+        }
+
+        constexpr bool any_of()
+        {
+            return false;
+        }
+
+        template<typename... Bools>
+        constexpr bool any_of(bool first, Bools... rest)
+        {
+            return first || any_of(rest...);
+        }
+
+        constexpr bool all_of()
+        {
+            return true;
+        }
+
+        template<typename... Bools>
+        constexpr bool all_of(bool first, Bools... rest)
+        {
+            return first && all_of(rest...);
+        }
+
+        // Each held type's copy, move and destruction; entry 0 stands for
+        // the empty state, so that they are indexed by the stored index
+        // without first checking for it.
+        template<typename... Types>
+        struct ops
+        {
+            typedef void (*copy_type)(const void * from, void * to);
+            typedef void (*move_type)(void * from, void * to);
+            typedef void (*destroy_type)(void * content);
+
+            template<typename ValueType>
+            static void copy(const void * from, void * to)
+            {
+                new(to) ValueType(*static_cast<const ValueType *>(from));
+            }
+
+            template<typename ValueType>
+            static void move(void * from, void * to)
+            {
+                new(to) ValueType(static_cast<ValueType &&>(*static_cast<ValueType *>(from)));
+            }
+
+            template<typename ValueType>
+            static void destroy(void * content)
+            {
+                static_cast<ValueType *>(content)->~ValueType();
+            }
+
+            static constexpr copy_type copies[] = { 0, &copy<Types>... };
+            static constexpr move_type moves[] = { 0, &move<Types>... };
+            static constexpr destroy_type destroys[] = { 0, &destroy<Types>... };
+        };
+
+        template<typename... Types>
+        constexpr typename ops<Types...>::copy_type ops<Types...>::copies[];
+
+        template<typename... Types>
+        constexpr typename ops<Types...>::move_type ops<Types...>::moves[];
+
+        template<typename... Types>
+        constexpr typename ops<Types...>::destroy_type ops<Types...>::destroys[];
+
+        template<bool Reachable>
+        struct upcast
+        {
+            template<typename Target, typename ValueType>
+            static Target * cast(void * content)
+            {
+                return static_cast<ValueType *>(content);
+            }
+
+            template<typename Target, typename ValueType>
+            static constexpr Target * (*get())(void *)
+            {
+                return &cast<Target, ValueType>;
+            }
+        };
+
+        template<>
+        struct upcast<false>
+        {
+            template<typename Target, typename ValueType>
+            static constexpr Target * (*get())(void *)
+            {
+                return 0;
+            }
+        };
+
+        // How to reach a Target from each held type, settled when the
+        // cast is compiled: a null entry where there is no unambiguous
+        // public path, otherwise a function that only adjusts the pointer
+        // by the (per held type, constant) offset of the Target subobject.
+        template<typename Target, typename... Types>
+        struct cast_table
+        {
+            typedef Target * (*cast_type)(void * content);
+
+            static constexpr bool reachable =
+                any_of(std::is_convertible<Types *, Target *>::value...);
+
+            static constexpr cast_type casts[] =
+            {
+                0,
+                upcast<std::is_convertible<Types *, Target *>::value>::
+                    template get<Target, Types>()...
+            };
+        };
+
+        template<typename Target, typename... Types>
+        constexpr bool cast_table<Target, Types...>::reachable;
+
+        template<typename Target, typename... Types>
+        constexpr typename cast_table<Target, Types...>::cast_type cast_table<Target, Types...>::casts[];
+
+        // Copies or moves the value of a dynamic_any into a bounded one,
+        // trying each bounded type in turn for exactly the held type.
+        template<typename... Types>
+        struct from_dynamic_any;
+
+        template<>
+        struct from_dynamic_any<>
+        {
+            template<typename Bounded, typename Any>
+            static void assign(Bounded &, Any &&)
+            {
+                boost::throw_exception(bad_dynamic_any_cast());
+            }
+        };
+
+        template<typename First, typename... Types>
+        struct from_dynamic_any<First, Types...>
+        {
+            template<typename Bounded, typename Any>
+            static void assign(Bounded & out, Any && in)
+            {
+                if(!detail::dynamic_any::same_type(in.type(), detail::dynamic_any::type_of<First>()))
+                    return from_dynamic_any<Types...>::assign(out, static_cast<Any &&>(in));
+
+                typedef typename std::conditional<std::is_lvalue_reference<Any>::value,
+                    const First &, First &&>::type value_type;
+                out.template emplace<First>(static_cast<value_type>(*unsafe_any_cast<First>(&in)));
+            }
+        };
+    } // namespace bounded_dynamic_any
+} // namespace detail
+
+/**
+    @brief a dynamic_any whose value is known to be of one of Types.
+
+    The value is stored in place, in storage large enough for any of Types,
+    next to a one-byte index of its type: nothing is ever allocated, and no
+    type_info is compared on a cast.  dynamic_any_cast to one of Types is a
+    comparison of the index; a cast to a base class of any of them looks the
+    index up in a table of upcasts built when the cast is compiled, so it
+    needs neither RTTI nor a BOOST_DYNAMIC_ANY_BASES registration.  Casting
+    to a type that none of Types is, or publicly derives from, does not
+    compile.
+
+    A value of exactly one of Types is accepted; anything else, such as a
+    string literal for std::string, has to be converted first.
+*/
+template<typename... Types>
+class bounded_dynamic_any
+{
+    BOOST_STATIC_ASSERT_MSG(sizeof...(Types) > 0 && sizeof...(Types) < 255,
+        "bounded_dynamic_any needs between 1 and 254 types");
+
+    typedef detail::bounded_dynamic_any::ops<Types...> ops;
+
+    // moving, and so swapping, cannot throw if no held type's move can
+    typedef std::integral_constant<bool, detail::bounded_dynamic_any::all_of(
+        std::is_nothrow_move_constructible<Types>::value...)> nothrow_move;
+
+    template<typename ValueType>
+    struct bounded
+      : std::integral_constant<bool,
+            detail::bounded_dynamic_any::index_of<ValueType, Types...>::value != sizeof...(Types)>
+    {
+    };
+
+    // keeps the forwarding constructor and assignment to values of Types
+    template<typename ValueType, typename R = void>
+    struct enable_if_bounded
+      : std::enable_if<bounded<typename std::decay<ValueType>::type>::value, R>
+    {
+    };
+
+    public: // structors
+
+        bounded_dynamic_any() BOOST_NOEXCEPT
+          : m_index(0)
+        {
+        }
+
+        template<typename ValueType>
+        bounded_dynamic_any(ValueType && value,
+            typename enable_if_bounded<ValueType>::type * = 0)
+          : m_index(0)
+        {
+            emplace<typename std::decay<ValueType>::type>(static_cast<ValueType &&>(value));
+        }
+
+        bounded_dynamic_any(const bounded_dynamic_any & other)
+          : m_index(0)
+        {
+            if(other.m_index)
+                ops::copies[other.m_index](other.address(), address());
+            m_index = other.m_index;
+        }
+
+        bounded_dynamic_any(bounded_dynamic_any && other) BOOST_NOEXCEPT_IF(nothrow_move::value)
+          : m_index(0)
+        {
+            if(other.m_index)
+                ops::moves[other.m_index](other.address(), address());
+            m_index = other.m_index;
+        }
+
+        // Copies the value held by other, which must be exactly one of
+        // Types; throws bad_dynamic_any_cast otherwise.
+        template<typename Alloc>
+        explicit bounded_dynamic_any(const basic_dynamic_any<Alloc> & other)
+          : m_index(0)
+        {
+            if(!other.empty())
+                detail::bounded_dynamic_any::from_dynamic_any<Types...>::assign(*this, other);
+        }
+
+        // moves the value held by other, under the same condition
+        template<typename Alloc>
+        explicit bounded_dynamic_any(basic_dynamic_any<Alloc> && other)
+          : m_index(0)
+        {
+            if(!other.empty())
+                detail::bounded_dynamic_any::from_dynamic_any<Types...>::assign(
+                    *this, static_cast<basic_dynamic_any<Alloc> &&>(other));
+        }
+
+        ~bounded_dynamic_any()
+        {
+            clear();
+        }
+
+    public: // modifiers
+
+        // If copying or moving throws, *this is left empty.
+        bounded_dynamic_any & operator=(const bounded_dynamic_any & rhs)
+        {
+            if(this != &rhs)
+            {
+                clear();
+                if(rhs.m_index)
+                    ops::copies[rhs.m_index](rhs.address(), address());
+                m_index = rhs.m_index;
+            }
+            return *this;
+        }
+
+        bounded_dynamic_any & operator=(bounded_dynamic_any && rhs)
+            BOOST_NOEXCEPT_IF(nothrow_move::value)
+        {
+            if(this != &rhs)
+            {
+                clear();
+                if(rhs.m_index)
+                    ops::moves[rhs.m_index](rhs.address(), address());
+                m_index = rhs.m_index;
+            }
+            return *this;
+        }
+
+        template<typename ValueType>
+        typename enable_if_bounded<ValueType, bounded_dynamic_any &>::type
+        operator=(ValueType && rhs)
+        {
+            emplace<typename std::decay<ValueType>::type>(static_cast<ValueType &&>(rhs));
+            return *this;
+        }
+
+        bounded_dynamic_any & swap(bounded_dynamic_any & rhs) BOOST_NOEXCEPT_IF(nothrow_move::value)
+        {
+            bounded_dynamic_any tmp(static_cast<bounded_dynamic_any &&>(rhs));
+            rhs = static_cast<bounded_dynamic_any &&>(*this);
+            *this = static_cast<bounded_dynamic_any &&>(tmp);
+            return *this;
+        }
+
+        // Destroys the current value and constructs a ValueType from args
+        // directly in place.  If that constructor throws, *this is empty.
+        template<typename ValueType, typename... Args>
+        ValueType & emplace(Args &&... args)
+        {
+            BOOST_STATIC_ASSERT_MSG(bounded<ValueType>::value,
+                "ValueType is not one of the bounded types");
+
+            clear();
+            ValueType * result = new(address()) ValueType(static_cast<Args &&>(args)...);
+            m_index = detail::bounded_dynamic_any::index_of<ValueType, Types...>::value + 1;
+            return *result;
+        }
+
+        void clear() BOOST_NOEXCEPT
+        {
+            if(m_index)
+            {
+                ops::destroys[m_index](address());
+                m_index = 0;
+            }
+        }
+
+    public: // queries
+
+        bool empty() const BOOST_NOEXCEPT
+        {
+            return !m_index;
+        }
+
+        // position of the held type in Types, or -1 if empty
+        int which() const BOOST_NOEXCEPT
+        {
+            return int(m_index) - 1;
+        }
+
+        const boost::typeindex::type_info & type() const
+        {
+            static const boost::typeindex::type_info * const types[] =
+            {
+                &detail::dynamic_any::type_of<void>(),
+                &detail::dynamic_any::type_of<Types>()...
+            };
+            return *types[m_index];
+        }
+
+        // a dynamic_any holding a copy of the value, empty if this is
+        template<typename Alloc = std::allocator<char> >
+        basic_dynamic_any<Alloc> to_dynamic_any(const Alloc & alloc = Alloc()) const
+        {
+            typedef basic_dynamic_any<Alloc> (*convert_type)(const void *, const Alloc &);
+            static const convert_type converts[] = { &convert<Alloc>, &convert<Alloc, Types>... };
+            return converts[m_index](address(), alloc);
+        }
+
+    private: // representation
+
+        template<typename ValueType, typename... OtherTypes>
+        friend ValueType * dynamic_any_cast(bounded_dynamic_any<OtherTypes...> *) BOOST_NOEXCEPT;
+
+        void * address() BOOST_NOEXCEPT
+        {
+            return m_storage.address();
+        }
+
+        const void * address() const BOOST_NOEXCEPT
+        {
+            return m_storage.address();
+        }
+
+        template<typename ValueType>
+        ValueType * cast() BOOST_NOEXCEPT
+        {
+            typedef typename std::remove_cv<ValueType>::type target;
+            typedef detail::bounded_dynamic_any::cast_table<target, Types...> table;
+
+            BOOST_STATIC_ASSERT_MSG(table::reachable,
+                "none of the bounded types is, or publicly derives from, ValueType");
+
+            if(bounded<target>::value
+                && m_index == detail::bounded_dynamic_any::index_of<target, Types...>::value + 1)
+                return static_cast<target *>(address());
+
+            typename table::cast_type upcast = table::casts[m_index];
+            return upcast ? upcast(address()) : 0;
+        }
+
+        template<typename Alloc>
+        static basic_dynamic_any<Alloc> convert(const void *, const Alloc & alloc)
+        {
+            return basic_dynamic_any<Alloc>(alloc);
+        }
+
+        template<typename Alloc, typename ValueType>
+        static basic_dynamic_any<Alloc> convert(const void * content, const Alloc & alloc)
+        {
+            return basic_dynamic_any<Alloc>(*static_cast<const ValueType *>(content), alloc);
+        }
+
+        typedef boost::aligned_storage<
+            detail::bounded_dynamic_any::max_of(sizeof(Types)...),
+            detail::bounded_dynamic_any::max_of(std::alignment_of<Types>::value...)> storage_type;
+
+        storage_type m_storage;
+        unsigned char m_index;
+};
+
+    template<typename... Types>
+    inline void swap(bounded_dynamic_any<Types...> & lhs, bounded_dynamic_any<Types...> & rhs)
+        BOOST_NOEXCEPT_IF(BOOST_NOEXCEPT_EXPR(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+    template<typename ValueType, typename... Types>
+    ValueType * dynamic_any_cast(bounded_dynamic_any<Types...> * operand) BOOST_NOEXCEPT
+    {
+        return operand ? operand->template cast<ValueType>() : 0;
+    }
+
+    template<typename ValueType, typename... Types>
+    inline const ValueType * dynamic_any_cast(const bounded_dynamic_any<Types...> * operand) BOOST_NOEXCEPT
+    {
+        return dynamic_any_cast<const ValueType>(const_cast<bounded_dynamic_any<Types...> *>(operand));
+    }
+
+    template<typename ValueType, typename... Types>
+    ValueType dynamic_any_cast(bounded_dynamic_any<Types...> & operand)
+    {
+        typedef typename std::remove_reference<ValueType>::type nonref;
+
+        nonref * result = dynamic_any_cast<nonref>(&operand);
+        if(!result)
+            boost::throw_exception(bad_dynamic_any_cast());
+        return *result;
+    }
+
+    template<typename ValueType, typename... Types>
+    inline ValueType dynamic_any_cast(const bounded_dynamic_any<Types...> & operand)
+    {
+        typedef typename std::remove_reference<ValueType>::type nonref;
+
+        return dynamic_any_cast<const nonref &>(const_cast<bounded_dynamic_any<Types...> &>(operand));
+    }
+
+    template<typename ValueType, typename... Types>
+    inline boost::optional<typename std::remove_reference<ValueType>::type &>
+    try_cast(bounded_dynamic_any<Types...> & operand) BOOST_NOEXCEPT
+    {
+        typedef typename std::remove_reference<ValueType>::type nonref;
+
+        nonref * result = dynamic_any_cast<nonref>(&operand);
+        if(BOOST_LIKELY(result != 0))
+            return boost::optional<nonref &>(*result);
+        return boost::none;
+    }
+
+    template<typename ValueType, typename... Types>
+    inline boost::optional<const typename std::remove_reference<ValueType>::type &>
+    try_cast(const bounded_dynamic_any<Types...> & operand) BOOST_NOEXCEPT
+    {
+        typedef typename std::remove_reference<ValueType>::type nonref;
+
+        return try_cast<const nonref>(const_cast<bounded_dynamic_any<Types...> &>(operand));
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
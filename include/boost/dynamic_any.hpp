@@ -2,87 +2,755 @@
 #define BOOST_DYNAMIC_ANY_INCLUDED
 
 #include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
 #include <typeinfo>
 
 #include "boost/config.hpp"
 #include <boost/type_traits/remove_reference.hpp>
 #include <boost/type_traits/is_reference.hpp>
 #include <boost/type_traits/is_scalar.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/type_traits/is_pointer.hpp>
+#include <boost/type_traits/is_class.hpp>
+#include <boost/core/enable_if.hpp>
+#include <boost/core/allocator_access.hpp>
+#include <boost/core/empty_value.hpp>
+#include <boost/core/no_exceptions_support.hpp>
+#include <boost/core/swap.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/type_index.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/variadic/to_seq.hpp>
+#include <boost/move/utility_core.hpp>
+#include <boost/none.hpp>
+#include <boost/optional/optional.hpp>
 #include <boost/throw_exception.hpp>
 #include <boost/static_assert.hpp>
 
+#ifndef BOOST_NO_CXX17_HDR_VARIANT
+#include <utility> // std::in_place_type_t
+#endif
+
+#ifndef BOOST_NO_CXX11_HDR_FUNCTIONAL
+#include <functional> // std::hash
+#endif
+
+// Size in bytes of the inline buffer used to store small held values
+// without a heap allocation.
+#ifndef BOOST_DYNAMIC_ANY_SMALL_BUFFER_SIZE
+#  define BOOST_DYNAMIC_ANY_SMALL_BUFFER_SIZE (3 * sizeof(void*))
+#endif
+
+// Alignment of the inline buffer; values with a stricter alignment
+// requirement always go to the heap.
+#ifndef BOOST_DYNAMIC_ANY_SMALL_BUFFER_ALIGN
+#  define BOOST_DYNAMIC_ANY_SMALL_BUFFER_ALIGN (boost::alignment_of<void*>::value)
+#endif
+
+// Number of slots (a power of two) in the per-thread, per-target-type cache
+// of base-class cast offsets used by dynamic_any_cast.  The cache relies on
+// thread_local storage and <atomic> and is disabled where those are
+// unavailable, or when BOOST_DYNAMIC_ANY_NO_CAST_CACHE is defined.
+#ifndef BOOST_DYNAMIC_ANY_CAST_CACHE_SIZE
+#  define BOOST_DYNAMIC_ANY_CAST_CACHE_SIZE 8
+#endif
+
+// Number of slots (a power of two) in the first per-target-type table
+// shared by all threads behind the per-thread cache.  Offsets found by one
+// thread are published there for the others; held types it has no room
+// for go to tables added behind it, each twice the size of the last.
+#ifndef BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE
+#  define BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE 64
+#endif
+
+#if (defined(BOOST_NO_CXX11_THREAD_LOCAL) || defined(BOOST_NO_CXX11_HDR_ATOMIC)) \
+ && !defined(BOOST_DYNAMIC_ANY_NO_CAST_CACHE)
+#  define BOOST_DYNAMIC_ANY_NO_CAST_CACHE
+#endif
+
+#ifndef BOOST_DYNAMIC_ANY_NO_CAST_CACHE
+#include <atomic>
+#endif
+
+// Define BOOST_DYNAMIC_ANY_STATS to count clones, heap allocations and
+// casts per held type; see boost/dynamic_any_stats.hpp.
+#ifdef BOOST_DYNAMIC_ANY_STATS
+#include <boost/dynamic_any_stats.hpp>
+#  define BOOST_DYNAMIC_ANY_AUX_COUNT(ValueType, Event)                        \
+    ::boost::detail::dynamic_any_stats::count(                                  \
+        ::boost::detail::dynamic_any_stats::counters_for< ValueType >(),        \
+        ::boost::detail::dynamic_any_stats::Event)
+#else
+#  define BOOST_DYNAMIC_ANY_AUX_COUNT(ValueType, Event) ((void)0)
+#endif
+
+// Bases that are not registered with BOOST_DYNAMIC_ANY_BASES are found, as
+// dynamic_cast would find them, by walking the bases the held type's
+// type_info lists under the Itanium C++ ABI (GCC, Clang).  Under other
+// ABIs they are found by throwing the held value's address and catching
+// it as a pointer to the target.  Both need RTTI; the throw also needs
+// exceptions.
+#if !defined(BOOST_NO_RTTI) && defined(__GXX_ABI_VERSION)
+#  define BOOST_DYNAMIC_ANY_AUX_ABI_BASE_SEARCH
+#  include <cxxabi.h>
+#endif
+#if !defined(BOOST_NO_RTTI) && !defined(BOOST_NO_EXCEPTIONS) \
+ && !defined(BOOST_DYNAMIC_ANY_AUX_ABI_BASE_SEARCH)
+#  define BOOST_DYNAMIC_ANY_AUX_THROW_SEARCH
+#endif
+
 // See boost/python/type_id.hpp
 // TODO: add BOOST_TYPEID_COMPARE_BY_NAME to config.hpp
-# if (defined(__GNUC__) && __GNUC__ >= 3) \
+# if !defined(BOOST_NO_RTTI) && !defined(BOOST_TYPE_INDEX_FORCE_NO_RTTI_COMPATIBILITY) \
+ && ((defined(__GNUC__) && __GNUC__ >= 3) \
  || defined(_AIX) \
  || (   defined(__sgi) && defined(__host_mips)) \
  || (defined(__hpux) && defined(__HP_aCC)) \
- || (defined(linux) && defined(__INTEL_COMPILER) && defined(__ICC))
+ || (defined(linux) && defined(__INTEL_COMPILER) && defined(__ICC)))
 #  define BOOST_AUX_DYNAMIC_ANY_TYPE_ID_NAME
 #include <cstring>
 # endif 
 
 namespace boost
 {
+    // Lists the base classes of Derived that dynamic_any_cast can reach
+    // by static casts alone.  Specialize it with BOOST_DYNAMIC_ANY_BASES;
+    // when RTTI or exceptions are disabled this is the only way to cast to
+    // a base.
+    template<typename Derived>
+    struct dynamic_any_bases
+    {
+        static void * cast(Derived *, const boost::typeindex::type_info &)
+        {
+            return 0;
+        }
+    };
+
+namespace detail {
+    namespace dynamic_any {
+        template<typename ValueType>
+        struct builtin_comparable
+          : boost::integral_constant<bool,
+                boost::is_arithmetic<ValueType>::value
+             || boost::is_enum<ValueType>::value
+             || boost::is_pointer<ValueType>::value>
+        {
+        };
+
+        template<typename CharT, typename Traits, typename Alloc>
+        struct builtin_comparable<std::basic_string<CharT, Traits, Alloc> >
+          : boost::true_type
+        {
+        };
+    } // namespace dynamic_any
+} // namespace detail
+
+    // Which comparisons dynamic_any offers for values of ValueType: ==
+    // (equality), < (ordering) and boost::hash (hashing).  All three are on
+    // for arithmetic, enumeration and pointer types and std::basic_string;
+    // other types opt in with BOOST_DYNAMIC_ANY_COMPARABLE or by
+    // specializing this.  Comparing values of a type that has not opted in
+    // throws bad_dynamic_any_comparison.
+    template<typename ValueType>
+    struct dynamic_any_comparison
+    {
+        BOOST_STATIC_CONSTANT(bool, equality =
+            detail::dynamic_any::builtin_comparable<ValueType>::value);
+        BOOST_STATIC_CONSTANT(bool, ordering =
+            detail::dynamic_any::builtin_comparable<ValueType>::value);
+        BOOST_STATIC_CONSTANT(bool, hashing =
+            detail::dynamic_any::builtin_comparable<ValueType>::value);
+    };
+
+namespace detail {
+    namespace dynamic_any {
+        // Compares and hashes held values of one type, given their
+        // addresses; a null entry means the type did not opt in.
+        struct comparison_ops
+        {
+            typedef bool (*compare_type)(const void * lhs, const void * rhs);
+            typedef std::size_t (*hash_type)(const void * held);
+
+            compare_type equal;
+            compare_type less;
+            hash_type    hash;
+        };
+
+        // Only takes the address of the comparisons a type opted in to,
+        // so that the others are never instantiated.
+        template<bool Enabled>
+        struct enable_comparison
+        {
+            template<typename Ops>
+            static comparison_ops::compare_type equal() { return &Ops::equal; }
+
+            template<typename Ops>
+            static comparison_ops::compare_type less() { return &Ops::less; }
+
+            template<typename Ops>
+            static comparison_ops::hash_type hash() { return &Ops::hash; }
+        };
+
+        template<>
+        struct enable_comparison<false>
+        {
+            template<typename Ops>
+            static comparison_ops::compare_type equal() { return 0; }
+
+            template<typename Ops>
+            static comparison_ops::compare_type less() { return 0; }
+
+            template<typename Ops>
+            static comparison_ops::hash_type hash() { return 0; }
+        };
+
+        template<typename ValueType>
+        struct comparisons_of
+        {
+            typedef boost::dynamic_any_comparison<ValueType> enabled;
+
+            static const ValueType & value(const void * held)
+            {
+                return *static_cast<const ValueType *>(held);
+            }
+
+            static bool equal(const void * lhs, const void * rhs)
+            {
+                return value(lhs) == value(rhs);
+            }
+
+            static bool less(const void * lhs, const void * rhs)
+            {
+                return value(lhs) < value(rhs);
+            }
+
+            static std::size_t hash(const void * held)
+            {
+                return boost::hash<ValueType>()(value(held));
+            }
+
+            static const comparison_ops & table()
+            {
+                typedef enable_comparison<enabled::equality> equality;
+                typedef enable_comparison<enabled::ordering> ordering;
+                typedef enable_comparison<enabled::hashing> hashing;
+
+                static const comparison_ops ops =
+                {
+                    equality::template equal<comparisons_of>(),
+                    ordering::template less<comparisons_of>(),
+                    hashing::template hash<comparisons_of>()
+                };
+                return ops;
+            }
+        };
+
+        // The most derived type of a held value is fixed by its table, so
+        // the distance from the value to any base subobject, virtual or
+        // not, is a per-type constant.
+        struct cast_cache_slot
+        {
+            const void *   key;
+            std::ptrdiff_t offset;
+        };
+
+        // type_info objects are normally unique per type, making the
+        // address comparison conclusive; different addresses for the same
+        // type only occur across shared object boundaries, where the names
+        // still match.
+        inline bool same_type(
+            const boost::typeindex::type_info & held,
+            const boost::typeindex::type_info & wanted)
+        {
+            if(BOOST_LIKELY(&held == &wanted))
+                return true;
+#ifdef BOOST_AUX_DYNAMIC_ANY_TYPE_ID_NAME
+            return std::strcmp(held.name(), wanted.name()) == 0;
+#else
+            return boost::typeindex::type_index(held) == boost::typeindex::type_index(wanted);
+#endif
+        }
+
+        template<typename ValueType>
+        inline const boost::typeindex::type_info & type_of()
+        {
+            return boost::typeindex::type_id<ValueType>().type_info();
+        }
+
+        // Upcasts statically, then lets Base's own registration continue
+        // the search so that indirect bases are found too.
+        template<typename Derived, typename Base>
+        inline void * cast_to_base(Derived * derived, const boost::typeindex::type_info & target)
+        {
+            Base * base = derived;
+            return same_type(type_of<Base>(), target)
+                ? static_cast<void *>(base)
+                : dynamic_any_bases<Base>::cast(base, target);
+        }
+
+#ifdef BOOST_DYNAMIC_ANY_AUX_ABI_BASE_SEARCH
+        // Looks for the target among the public bases of the object of
+        // class type at object, recording in found the address of each
+        // base subobject of that type; ambiguous is set if there are two
+        // at different addresses.  Bases that are not public, and the
+        // bases reached only through them, are not accessible to a
+        // dynamic_cast and are skipped.
+        inline void find_base(const abi::__class_type_info * type, const char * object,
+            const std::type_info & target, const char * & found, bool & ambiguous)
+        {
+            if(*type == target)
+            {
+                if(found && found != object)
+                    ambiguous = true;
+                found = object;
+                return;
+            }
+            // the ABI describes classes with bases by exactly these two
+            // types of type_info
+            const std::type_info & kind = typeid(*type);
+            if(kind == typeid(abi::__si_class_type_info))
+                find_base(static_cast<const abi::__si_class_type_info *>(type)->__base_type,
+                    object, target, found, ambiguous);
+            else if(kind == typeid(abi::__vmi_class_type_info))
+            {
+                const abi::__vmi_class_type_info * several =
+                    static_cast<const abi::__vmi_class_type_info *>(type);
+                for(unsigned i = 0; i != several->__base_count && !ambiguous; ++i)
+                {
+                    const abi::__base_class_type_info & base = several->__base_info[i];
+                    if(!(base.__offset_flags & abi::__base_class_type_info::__public_mask))
+                        continue;
+                    // a virtual base's offset is kept in the vtable, at
+                    // the position the flags hold instead
+                    std::ptrdiff_t offset = base.__offset_flags >> abi::__base_class_type_info::__offset_shift;
+                    if(base.__offset_flags & abi::__base_class_type_info::__virtual_mask)
+                        offset = *reinterpret_cast<const std::ptrdiff_t *>(
+                            *reinterpret_cast<const char * const *>(object) + offset);
+                    find_base(base.__base_type, object + offset, target, found, ambiguous);
+                }
+            }
+        }
+
+        // the unique public base subobject of type target, which must be a
+        // class, of the object of class type Derived, or null
+        template<typename Derived>
+        inline void * find_base(Derived * derived, const std::type_info & target)
+        {
+            const char * found = 0;
+            bool ambiguous = false;
+            find_base(static_cast<const abi::__class_type_info *>(&typeid(Derived)),
+                reinterpret_cast<const char *>(derived), target, found, ambiguous);
+            return ambiguous ? 0 : const_cast<char *>(found);
+        }
+#endif
+
+        // keeps the forwarding constructors from hijacking copies of
+        // non-const lvalues and the allocator-only constructor
+        template<typename Any, typename ValueType>
+        struct disable_if_self
+          : boost::disable_if_c<
+                boost::is_same<Any, typename boost::decay<ValueType>::type>::value
+             || boost::is_same<typename Any::allocator_type,
+                               typename boost::decay<ValueType>::type>::value>
+        {
+        };
+
+        inline std::ptrdiff_t no_conversion()
+        {
+            return (std::numeric_limits<std::ptrdiff_t>::min)();
+        }
+
+#ifndef BOOST_DYNAMIC_ANY_NO_CAST_CACHE
+        // An entry of the shared store.  Entries are written once: the
+        // thread that claims key fills in value and then sets ready, after
+        // which the entry never changes.  Readers therefore only load, so
+        // the store's cache lines stay shared between cores instead of
+        // bouncing between them.
+        template<typename Slot>
+        struct shared_cache_entry
+        {
+            std::atomic<const void *> key;
+            std::atomic<bool>         ready;
+            Slot                      value;
+        };
+
+        // A table the shared store grows by once the tables before it
+        // have no room for a key; each is twice the size of the one
+        // before, and none is ever freed, so readers need no locks.
+        template<typename Slot>
+        struct shared_cache_table
+        {
+            explicit shared_cache_table(std::size_t size_)
+              : size(size_), entries(new shared_cache_entry<Slot>[size_]()), next(0)
+            {
+            }
+
+            const std::size_t                        size;
+            shared_cache_entry<Slot> * const         entries;
+            std::atomic<shared_cache_table<Slot> *>  next;
+        };
+
+        // Slot may be any struct whose first member is the const void * key.
+        //
+        // Lookups go to the thread's own direct-mapped cache first, then to
+        // a store shared by all threads, and only then to the caller's
+        // search, whose result the caller hands to publish.  The store is
+        // a fixed open-addressed table followed by tables added as it
+        // fills, so every held type is searched for about once per target,
+        // however many there are.
+        template<typename Target, typename Table, typename Slot = cast_cache_slot>
+        struct cast_cache
+        {
+            BOOST_STATIC_ASSERT(
+                (BOOST_DYNAMIC_ANY_CAST_CACHE_SIZE & (BOOST_DYNAMIC_ANY_CAST_CACHE_SIZE - 1)) == 0);
+            BOOST_STATIC_ASSERT(
+                (BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE
+                    & (BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE - 1)) == 0);
+
+            // entries of a table a key may take before it goes to the next
+            static const std::size_t probes = 16;
+
+            static std::size_t hash(const void * key)
+            {
+                std::size_t hash = reinterpret_cast<std::size_t>(key);
+                return hash ^ (hash >> 9);
+            }
+
+            static Slot & slot(const void * key)
+            {
+                static thread_local Slot slots[BOOST_DYNAMIC_ANY_CAST_CACHE_SIZE];
+                return slots[(hash(key) >> 4) & (BOOST_DYNAMIC_ANY_CAST_CACHE_SIZE - 1)];
+            }
+
+            // Copies another thread's result for key into slot.  Wait-free:
+            // an entry still being filled in counts as a miss.
+            static bool fetch(Slot & slot, const void * key)
+            {
+                shared_cache_entry<Slot> * entries = first();
+                std::size_t size = BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE;
+                shared_cache_table<Slot> * next = grown().load(std::memory_order_acquire);
+                for(;;)
+                {
+                    std::size_t i = hash(key) >> 4;
+                    for(std::size_t probe = 0; probe != probes && probe != size; ++probe, ++i)
+                    {
+                        shared_cache_entry<Slot> & entry = entries[i & (size - 1)];
+                        const void * found = entry.key.load(std::memory_order_acquire);
+                        if(found == key)
+                        {
+                            if(!entry.ready.load(std::memory_order_acquire))
+                                return false;
+                            slot = entry.value;
+                            return true;
+                        }
+                        if(!found)
+                            return false;
+                    }
+                    if(!next)
+                        return false;
+                    entries = next->entries;
+                    size = next->size;
+                    next = next->next.load(std::memory_order_acquire);
+                }
+            }
+
+            // Makes slot, filled in by this thread, visible to the others.
+            // An entry lost to another thread for the same key is left to
+            // that thread; one lost to another key sends this one on to
+            // the following entries, and to the next table, added here if
+            // there is none yet, once this table has no room for it.
+            static void publish(const Slot & slot)
+            {
+                shared_cache_entry<Slot> * entries = first();
+                std::size_t size = BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE;
+                std::atomic<shared_cache_table<Slot> *> * next = &grown();
+                for(;;)
+                {
+                    std::size_t i = hash(slot.key) >> 4;
+                    for(std::size_t probe = 0; probe != probes && probe != size; ++probe, ++i)
+                    {
+                        shared_cache_entry<Slot> & entry = entries[i & (size - 1)];
+                        const void * found = entry.key.load(std::memory_order_relaxed);
+                        if(!found && entry.key.compare_exchange_strong(found, slot.key,
+                               std::memory_order_acq_rel, std::memory_order_relaxed))
+                        {
+                            entry.value = slot;
+                            entry.ready.store(true, std::memory_order_release);
+                            return;
+                        }
+                        if(found == slot.key)
+                            return;
+                    }
+
+                    shared_cache_table<Slot> * table = next->load(std::memory_order_acquire);
+                    if(!table)
+                    {
+                        shared_cache_table<Slot> * added = new shared_cache_table<Slot>(2 * size);
+                        if(next->compare_exchange_strong(table, added,
+                               std::memory_order_acq_rel, std::memory_order_acquire))
+                            table = added;
+                        else
+                        {
+                            delete[] added->entries;
+                            delete added;
+                        }
+                    }
+                    entries = table->entries;
+                    size = table->size;
+                    next = &table->next;
+                }
+            }
+
+        private:
+            static shared_cache_entry<Slot> * first()
+            {
+                // zero-initialized before any dynamic initialization, so
+                // usable from other static constructors
+                static shared_cache_entry<Slot> table[BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE];
+                return table;
+            }
+
+            static std::atomic<shared_cache_table<Slot> *> & grown()
+            {
+                // constant-initialized, like the first table
+                static std::atomic<shared_cache_table<Slot> *> table(0);
+                return table;
+            }
+        };
+
+        template<typename Target, typename Table, typename Slot>
+        const std::size_t cast_cache<Target, Table, Slot>::probes;
+#endif
+    } // namespace dynamic_any
+} // namespace detail
+
+    template<typename Alloc = std::allocator<char> >
+    class basic_dynamic_any;
+
+    typedef basic_dynamic_any<> dynamic_any;
+
     template<bool IsFundamental, typename ValueType>
     struct if_scalar{};
 
-    class dynamic_any
+namespace detail {
+    namespace dynamic_any {
+        struct access;
+    } // namespace dynamic_any
+} // namespace detail
+
+    // Alloc supplies the storage of values too large for the inline
+    // buffer.  Copies are allocated with the allocator of the object being
+    // constructed; a move takes the allocator along with the value.
+    // Assignment and swap follow std::allocator_traits: the allocator is
+    // only replaced where its propagate_on_container_* trait says so, and
+    // otherwise values are moved or copied into memory from the allocator
+    // they end up with.
+    template<typename Alloc>
+    class basic_dynamic_any : private boost::empty_value<Alloc>
     {
+    public: // types
+
+        typedef Alloc allocator_type;
+
     public: // structors
 
-        dynamic_any()
-          : content(0)
+        basic_dynamic_any()
+          : table(0)
+        {
+        }
+
+        explicit basic_dynamic_any(const allocator_type & alloc)
+          : boost::empty_value<Alloc>(boost::empty_init_t(), alloc), table(0)
         {
         }
 
         template<typename ValueType>
-        dynamic_any(const ValueType & value)
-          : content(new holder<ValueType, boost::is_scalar<ValueType>::value >(value))
+        basic_dynamic_any(const ValueType & value)
+          : table(create<ValueType>(buffer(), allocator(), value))
         {
         }
 
-        dynamic_any(const dynamic_any & other)
-          : content(other.content ? other.content->clone() : 0)
+        template<typename ValueType>
+        basic_dynamic_any(const ValueType & value, const allocator_type & alloc)
+          : boost::empty_value<Alloc>(boost::empty_init_t(), alloc)
+          , table(create<ValueType>(buffer(), allocator(), value))
         {
         }
 
-        ~dynamic_any()
+        basic_dynamic_any(const basic_dynamic_any & other)
+          : boost::empty_value<Alloc>(boost::empty_init_t(),
+                boost::allocator_select_on_container_copy_construction(other.allocator()))
+          , table(clone(other, buffer(), allocator()))
         {
-            delete content;
+        }
+
+        basic_dynamic_any(const basic_dynamic_any & other, const allocator_type & alloc)
+          : boost::empty_value<Alloc>(boost::empty_init_t(), alloc)
+          , table(clone(other, buffer(), allocator()))
+        {
+        }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        // Steals the held value: heap values change owner, inline ones
+        // are moved, and other is left empty.
+        basic_dynamic_any(basic_dynamic_any && other) BOOST_NOEXCEPT
+          : boost::empty_value<Alloc>(boost::empty_init_t(), other.allocator())
+          , table(other.table)
+        {
+            if(table)
+                table->move(other.buffer(), buffer());
+            other.table = 0;
+        }
+
+        // As the move constructor, except that a value the allocators do
+        // not share is moved into memory from alloc.  other is left empty.
+        basic_dynamic_any(basic_dynamic_any && other, const allocator_type & alloc)
+          : boost::empty_value<Alloc>(boost::empty_init_t(), alloc)
+          , table(other.table)
+        {
+            if(!table)
+                return;
+            if(allocator() == other.allocator())
+                table->move(other.buffer(), buffer());
+            else
+                table->transfer(other.buffer(), other.allocator(), buffer(), allocator());
+            other.table = 0;
+        }
+
+        // The constraints are template arguments rather than defaulted
+        // pointer parameters, which a pointer passed as a second argument
+        // (such as a std::pmr::memory_resource *) would bind to.
+        template<typename ValueType
+            , typename = typename detail::dynamic_any::disable_if_self<basic_dynamic_any, ValueType>::type
+            , typename = typename boost::disable_if<boost::is_const<ValueType> >::type>
+        basic_dynamic_any(ValueType && value)
+          : table(create<typename boost::decay<ValueType>::type>(
+                buffer(), allocator(), static_cast<ValueType &&>(value)))
+        {
+        }
+
+        template<typename ValueType
+            , typename = typename detail::dynamic_any::disable_if_self<basic_dynamic_any, ValueType>::type
+            , typename = typename boost::disable_if<boost::is_const<ValueType> >::type>
+        basic_dynamic_any(ValueType && value, const allocator_type & alloc)
+          : boost::empty_value<Alloc>(boost::empty_init_t(), alloc)
+          , table(create<typename boost::decay<ValueType>::type>(
+                buffer(), allocator(), static_cast<ValueType &&>(value)))
+        {
+        }
+#endif
+
+#if !defined(BOOST_NO_CXX17_HDR_VARIANT) && !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+        template<typename ValueType, typename... Args>
+        explicit basic_dynamic_any(std::in_place_type_t<ValueType>, Args &&... args)
+          : table(create<ValueType>(buffer(), allocator(), static_cast<Args &&>(args)...))
+        {
+        }
+#endif
+
+        ~basic_dynamic_any()
+        {
+            if(table)
+                table->destroy(buffer(), allocator());
         }
 
     public: // modifiers
 
-        dynamic_any & swap(dynamic_any & rhs)
+        // Nothrow unless the allocators differ and do not propagate on
+        // swap.  Values then have to be moved into memory from the other
+        // allocator, and if that throws either operand may be left empty.
+        basic_dynamic_any & swap(basic_dynamic_any & rhs)
         {
-            std::swap(content, rhs.content);
+            if(this != &rhs)
+                swap(rhs, propagate_on_swap());
             return *this;
         }
 
+        basic_dynamic_any & operator=(const basic_dynamic_any & rhs)
+        {
+            if(this != &rhs)
+                copy_assign(rhs, propagate_on_copy_assignment());
+            return *this;
+        }
+
+#ifdef BOOST_NO_CXX11_RVALUE_REFERENCES
         template<typename ValueType>
-        dynamic_any & operator=(const ValueType & rhs)
+        basic_dynamic_any & operator=(const ValueType & rhs)
         {
-            dynamic_any(rhs).swap(*this);
+            basic_dynamic_any(rhs, allocator()).swap_values(*this);
+            return *this;
+        }
+#else
+        basic_dynamic_any & operator=(basic_dynamic_any && rhs)
+            BOOST_NOEXCEPT_IF(propagate_on_move_assignment::value || allocator_always_equal::value)
+        {
+            if(this != &rhs)
+                move_assign(rhs, propagate_on_move_assignment());
             return *this;
         }
 
-        dynamic_any & operator=(dynamic_any rhs)
+        // copies of non-const lvalues go to the copy assignment
+        template<typename ValueType>
+        typename boost::disable_if<
+            boost::is_same<basic_dynamic_any, typename boost::decay<ValueType>::type>,
+            basic_dynamic_any &>::type
+        operator=(ValueType && rhs)
         {
-            rhs.swap(*this);
+            basic_dynamic_any(static_cast<ValueType &&>(rhs), allocator()).swap_values(*this);
             return *this;
         }
+#endif
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+        // Destroys the current value and constructs a ValueType from args
+        // directly in place.  If that constructor throws, *this is empty.
+        template<typename ValueType, typename... Args>
+        ValueType & emplace(Args &&... args)
+        {
+            clear();
+            table = create<ValueType>(buffer(), allocator(), static_cast<Args &&>(args)...);
+            return *vtable_of<ValueType>::value(buffer());
+        }
+#endif
+
+        void clear() BOOST_NOEXCEPT
+        {
+            if(table)
+            {
+                table->destroy(buffer(), allocator());
+                table = 0;
+            }
+        }
 
     public: // queries
 
         bool empty() const
         {
-            return !content;
+            return !table;
         }
 
-        const std::type_info & type() const
+        const boost::typeindex::type_info & type() const
         {
-            return content ? content->type() : typeid(void);
+            return table ? table->type() : detail::dynamic_any::type_of<void>();
+        }
+
+        allocator_type get_allocator() const
+        {
+            return allocator();
         }
 
 #ifndef BOOST_NO_MEMBER_TEMPLATE_FRIENDS
@@ -91,101 +759,410 @@ namespace boost
     public: // types (public so dynamic_any_cast can be non-friend)
 #endif
 
-        class placeholder
+        typedef boost::aligned_storage<
+            BOOST_DYNAMIC_ANY_SMALL_BUFFER_SIZE,
+            BOOST_DYNAMIC_ANY_SMALL_BUFFER_ALIGN> storage_type;
+
+        typedef boost::integral_constant<bool,
+            boost::allocator_propagate_on_container_swap<Alloc>::type::value> propagate_on_swap;
+        typedef boost::integral_constant<bool,
+            boost::allocator_propagate_on_container_copy_assignment<Alloc>::type::value>
+            propagate_on_copy_assignment;
+        typedef boost::integral_constant<bool,
+            boost::allocator_propagate_on_container_move_assignment<Alloc>::type::value>
+            propagate_on_move_assignment;
+        typedef boost::integral_constant<bool,
+            boost::allocator_is_always_equal<Alloc>::type::value> allocator_always_equal;
+
+        // What the held type would otherwise provide through virtual
+        // functions, as one constant table per held type.  The value is
+        // stored as it is, with nothing added to it, either in the inline
+        // buffer or behind a pointer kept there.
+        struct vtable
+        {
+            const boost::typeindex::type_info & (*type)();
+
+            // address of the value's base subobject of type target, as far
+            // as dynamic_any_bases knows it
+            void * (*cast_to_base)(void * value, const boost::typeindex::type_info & target);
+
+            // address of the value's unique public base subobject of the
+            // class type target, found through the type_info; null unless
+            // the held type is a class and the table was built for the
+            // Itanium ABI with RTTI
+            void * (*find_base)(void * value, const boost::typeindex::type_info & target);
+
+            // throws the value's address, to find bases that are not
+            // registered where find_base is not available; null where the
+            // table was built without RTTI or exceptions (these members
+            // are always there, so that the layout is the same in every
+            // translation unit)
+            void (*throw_value)(void * value);
+
+            // copies the value into buffer when it fits there, otherwise
+            // into memory obtained from alloc; alloc is taken by value
+            // because the copy constructor passes the allocator of an
+            // object still under construction, which gcc reports as
+            // maybe-uninitialized when it is empty
+            void (*clone)(const void * value, void * buffer, allocator_type alloc);
+
+            // hands the value held in buffer from over to buffer to; heap
+            // values only change owner
+            void (*move)(void * from, void * to);
+
+            // as move, for a buffer to whose allocator cannot free the
+            // memory of from: heap values are moved into memory from
+            // to_alloc, and the old memory goes back to from_alloc
+            void (*transfer)(void * from, const allocator_type & from_alloc,
+                void * to, const allocator_type & to_alloc);
+
+            void (*destroy)(void * buffer, const allocator_type & alloc);
+
+            const detail::dynamic_any::comparison_ops & (*comparisons)();
+
+#ifdef BOOST_DYNAMIC_ANY_STATS
+            // this thread's counters for the held type
+            detail::dynamic_any_stats::counters & (*stats)();
+#endif
+
+            // whether the value is stored in the buffer itself
+            bool local;
+        };
+
+        // Values are stored inline when they fit the buffer and can be
+        // moved without throwing, so that swap stays nothrow.
+        template<typename ValueType>
+        struct use_small_buffer
+          : boost::integral_constant<bool,
+                sizeof(ValueType) <= sizeof(storage_type)
+             && boost::alignment_of<storage_type>::value
+                    % boost::alignment_of<ValueType>::value == 0
+             && boost::is_nothrow_move_constructible<ValueType>::value>
+        {
+        };
+
+        template<typename ValueType>
+        struct value_allocator
+        {
+            typedef BOOST_DEDUCED_TYPENAME boost::allocator_rebind<allocator_type, ValueType>::type type;
+        };
+
+        template<typename ValueType>
+        struct vtable_of
         {
-        public: // structors
+            typedef use_small_buffer<ValueType> local;
 
-            virtual ~placeholder()
+            static ValueType * value(void * buffer)
             {
+                return local::value
+                    ? static_cast<ValueType *>(buffer)
+                    : *static_cast<ValueType **>(buffer);
             }
 
-        public: // queries
+            static void * cast_to_base(void * value, const boost::typeindex::type_info & target)
+            {
+                return dynamic_any_bases<ValueType>::cast(static_cast<ValueType *>(value), target);
+            }
 
-            virtual const std::type_info & type() const = 0;
+#ifdef BOOST_DYNAMIC_ANY_AUX_ABI_BASE_SEARCH
+            static void * find_base(void * value, const boost::typeindex::type_info & target)
+            {
+                return detail::dynamic_any::find_base(static_cast<ValueType *>(value), target);
+            }
+#endif
 
-            virtual placeholder * clone() const = 0;
+#ifdef BOOST_DYNAMIC_ANY_AUX_THROW_SEARCH
+            static void throw_value(void * value)
+            {
+                throw static_cast<ValueType *>(value);
+            }
+#endif
 
-        };
+            static void clone(const void * value, void * buffer, allocator_type alloc)
+            {
+                BOOST_DYNAMIC_ANY_AUX_COUNT(ValueType, clones);
+                construct<ValueType>(local(), buffer, alloc, *static_cast<const ValueType *>(value));
+            }
 
-        template<typename ValueType, bool IsFundamental>
-        class holder{};
+            static void move(void * from, void * to)
+            {
+                relocate(from, to, local());
+            }
 
-        template<typename ValueType>
-        class holder<ValueType,false> : public ValueType, public placeholder
-        {
-        public: // structors
+            static void transfer(void * from, const allocator_type & from_alloc,
+                void * to, const allocator_type & to_alloc)
+            {
+                transfer(from, from_alloc, to, to_alloc, local());
+            }
 
-            holder(const ValueType & value)
-              : ValueType(value)
+            static void destroy(void * buffer, const allocator_type & alloc)
             {
+                ValueType * held = value(buffer);
+                held->~ValueType();
+                if(!local::value)
+                {
+                    typename value_allocator<ValueType>::type value_alloc(alloc);
+                    boost::allocator_deallocate(value_alloc, held, 1);
+                }
             }
 
-        public: // queries
+            static const vtable table;
 
-            virtual const std::type_info & type() const
+        private:
+            static void relocate(void * from, void * to, boost::true_type)
             {
-                return typeid(ValueType);
+                ValueType * held = static_cast<ValueType *>(from);
+                new(to) ValueType(boost::move(*held));
+                held->~ValueType();
             }
 
-            virtual placeholder * clone() const
+            static void relocate(void * from, void * to, boost::false_type)
             {
-                return dynamic_cast<placeholder*>(new holder(*this));
+                *static_cast<ValueType **>(to) = *static_cast<ValueType **>(from);
             }
 
+            static void transfer(void * from, const allocator_type &,
+                void * to, const allocator_type &, boost::true_type)
+            {
+                relocate(from, to, boost::true_type());
+            }
 
-        private: // intentionally left unimplemented
-            holder & operator=(const holder &);
+            static void transfer(void * from, const allocator_type & from_alloc,
+                void * to, const allocator_type & to_alloc, boost::false_type)
+            {
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+                construct<ValueType>(boost::false_type(), to, to_alloc,
+                    static_cast<ValueType &&>(*value(from)));
+#else
+                construct<ValueType>(boost::false_type(), to, to_alloc, *value(from));
+#endif
+                destroy(from, from_alloc);
+            }
         };
 
-        template<typename ValueType>
-        class holder<ValueType,true> : public placeholder
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+        // constructs a ValueType for buffer and returns its table
+        template<typename ValueType, typename... Args>
+        static const vtable * create(void * buffer, const allocator_type & alloc, Args &&... args)
+        {
+            construct<ValueType>(use_small_buffer<ValueType>(),
+                buffer, alloc, static_cast<Args &&>(args)...);
+            return &vtable_of<ValueType>::table;
+        }
+
+        template<typename ValueType, typename... Args>
+        static void construct(boost::true_type, void * buffer, const allocator_type &,
+            Args &&... args)
         {
-        public: // structors
+            new(buffer) ValueType(static_cast<Args &&>(args)...);
+        }
 
-            holder(const ValueType & value)
-              : held(value)
+        template<typename ValueType, typename... Args>
+        static void construct(boost::false_type, void * buffer, const allocator_type & alloc,
+            Args &&... args)
+        {
+            BOOST_DYNAMIC_ANY_AUX_COUNT(ValueType, allocations);
+            typename value_allocator<ValueType>::type value_alloc(alloc);
+            ValueType * result = boost::allocator_allocate(value_alloc, 1);
+            BOOST_TRY
             {
+                new(static_cast<void *>(result)) ValueType(static_cast<Args &&>(args)...);
             }
+            BOOST_CATCH(...)
+            {
+                boost::allocator_deallocate(value_alloc, result, 1);
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+            *static_cast<ValueType **>(buffer) = result;
+        }
+#else
+        template<typename ValueType, typename Arg>
+        static const vtable * create(void * buffer, const allocator_type & alloc, const Arg & arg)
+        {
+            construct<ValueType>(use_small_buffer<ValueType>(), buffer, alloc, arg);
+            return &vtable_of<ValueType>::table;
+        }
 
-        public: // queries
+        template<typename ValueType, typename Arg>
+        static void construct(boost::true_type, void * buffer, const allocator_type &,
+            const Arg & arg)
+        {
+            new(buffer) ValueType(arg);
+        }
 
-            virtual const std::type_info & type() const
+        template<typename ValueType, typename Arg>
+        static void construct(boost::false_type, void * buffer, const allocator_type & alloc,
+            const Arg & arg)
+        {
+            BOOST_DYNAMIC_ANY_AUX_COUNT(ValueType, allocations);
+            typename value_allocator<ValueType>::type value_alloc(alloc);
+            ValueType * result = boost::allocator_allocate(value_alloc, 1);
+            BOOST_TRY
+            {
+                new(static_cast<void *>(result)) ValueType(arg);
+            }
+            BOOST_CATCH(...)
             {
-                return typeid(ValueType);
+                boost::allocator_deallocate(value_alloc, result, 1);
+                BOOST_RETHROW
             }
+            BOOST_CATCH_END
+            *static_cast<ValueType **>(buffer) = result;
+        }
+#endif
+
+        static const vtable * clone(const basic_dynamic_any & other, void * buffer,
+            const allocator_type & alloc)
+        {
+            if(other.table)
+                other.table->clone(other.value(), buffer, alloc);
+            return other.table;
+        }
+
+        // Exchanges the held values only.  Heap held values just trade
+        // pointers; inline ones are moved through a temporary buffer,
+        // which cannot throw because only nothrow-movable values are ever
+        // stored inline.  The allocators must be able to free each
+        // other's memory.
+        void swap_values(basic_dynamic_any & rhs) BOOST_NOEXCEPT
+        {
+            storage_type tmp;
+            const vtable * held = table;
+            if(held)
+                held->move(buffer(), tmp.address());
+            if(rhs.table)
+                rhs.table->move(rhs.buffer(), buffer());
+            table = rhs.table;
+            if(held)
+                held->move(tmp.address(), rhs.buffer());
+            rhs.table = held;
+        }
+
+        void swap(basic_dynamic_any & rhs, boost::true_type)
+        {
+            swap_values(rhs);
+            boost::swap(allocator(), rhs.allocator());
+        }
 
-            virtual placeholder * clone() const
+        void swap(basic_dynamic_any & rhs, boost::false_type)
+        {
+            if(allocator() == rhs.allocator())
             {
-                return new holder(held);
+                swap_values(rhs);
+                return;
             }
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+            basic_dynamic_any to_lhs(static_cast<basic_dynamic_any &&>(rhs), allocator());
+            basic_dynamic_any to_rhs(static_cast<basic_dynamic_any &&>(*this), rhs.allocator());
+#else
+            basic_dynamic_any to_lhs(rhs, allocator());
+            basic_dynamic_any to_rhs(*this, rhs.allocator());
+#endif
+            swap_values(to_lhs);
+            rhs.swap_values(to_rhs);
+        }
 
-        public: // representation
+        // The copy is made with the allocator *this ends up with; the old
+        // value leaves with the old allocator.
+        void copy_assign(const basic_dynamic_any & rhs, boost::true_type)
+        {
+            basic_dynamic_any copy(rhs, rhs.allocator());
+            swap(copy, boost::true_type());
+        }
 
-            ValueType held;
+        void copy_assign(const basic_dynamic_any & rhs, boost::false_type)
+        {
+            basic_dynamic_any(rhs, allocator()).swap_values(*this);
+        }
 
-        private: // intentionally left unimplemented
-            holder & operator=(const holder &);
-        };
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        void move_assign(basic_dynamic_any & rhs, boost::true_type) BOOST_NOEXCEPT
+        {
+            basic_dynamic_any moved(static_cast<basic_dynamic_any &&>(rhs));
+            swap(moved, boost::true_type());
+        }
+
+        void move_assign(basic_dynamic_any & rhs, boost::false_type)
+        {
+            basic_dynamic_any(static_cast<basic_dynamic_any &&>(rhs), allocator()).swap_values(*this);
+        }
+#endif
+
+        void * buffer() const
+        {
+            return const_cast<storage_type &>(storage).address();
+        }
+
+        // address of the held value; the table must not be null
+        void * value() const
+        {
+            return table->local ? buffer() : *static_cast<void **>(buffer());
+        }
+
+        allocator_type & allocator()
+        {
+            return boost::empty_value<Alloc>::get();
+        }
+
+        const allocator_type & allocator() const
+        {
+            return boost::empty_value<Alloc>::get();
+        }
 
 #ifndef BOOST_NO_MEMBER_TEMPLATE_FRIENDS
 
     private: // representation
 
-        template<typename ValueType>
-        friend ValueType * dynamic_any_cast(dynamic_any *);
+        template<typename ValueType, typename OtherAlloc>
+        friend ValueType * dynamic_any_cast(basic_dynamic_any<OtherAlloc> *) BOOST_NOEXCEPT;
 
-        template<typename ValueType>
-        friend ValueType * unsafe_any_cast(dynamic_any *);
+        template<typename ValueType, typename OtherAlloc>
+        friend ValueType * unsafe_any_cast(basic_dynamic_any<OtherAlloc> *) BOOST_NOEXCEPT;
+
+        template<bool,typename> friend struct if_scalar;
 
-        template<bool,typename> friend class if_scalar;
+        friend struct detail::dynamic_any::access;
 #else
 
     public: // representation (public so dynamic_any_cast can be non-friend)
 
 #endif
 
-        placeholder * content;
+        storage_type storage;
+        const vtable * table;
+
+    };
 
+    // constant-initialized: every entry is an address constant
+    template<typename Alloc>
+    template<typename ValueType>
+    const BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::vtable
+    basic_dynamic_any<Alloc>::vtable_of<ValueType>::table =
+    {
+        &detail::dynamic_any::type_of<ValueType>,
+        &basic_dynamic_any<Alloc>::vtable_of<ValueType>::cast_to_base,
+#ifdef BOOST_DYNAMIC_ANY_AUX_ABI_BASE_SEARCH
+        boost::is_class<ValueType>::value
+            ? &basic_dynamic_any<Alloc>::vtable_of<ValueType>::find_base
+            : 0,
+#else
+        0,
+#endif
+#ifdef BOOST_DYNAMIC_ANY_AUX_THROW_SEARCH
+        &basic_dynamic_any<Alloc>::vtable_of<ValueType>::throw_value,
+#else
+        0,
+#endif
+        &basic_dynamic_any<Alloc>::vtable_of<ValueType>::clone,
+        &basic_dynamic_any<Alloc>::vtable_of<ValueType>::move,
+        &basic_dynamic_any<Alloc>::vtable_of<ValueType>::transfer,
+        &basic_dynamic_any<Alloc>::vtable_of<ValueType>::destroy,
+        &detail::dynamic_any::comparisons_of<ValueType>::table,
+#ifdef BOOST_DYNAMIC_ANY_STATS
+        &detail::dynamic_any_stats::counters_for<ValueType>,
+#endif
+        basic_dynamic_any<Alloc>::use_small_buffer<ValueType>::value
     };
 
     class bad_dynamic_any_cast : public std::bad_cast
@@ -198,45 +1175,282 @@ namespace boost
         }
     };
 
+    class bad_dynamic_any_comparison : public std::exception
+    {
+    public:
+        virtual const char * what() const throw()
+        {
+            return "boost::bad_dynamic_any_comparison: "
+                   "held type does not support the comparison";
+        }
+    };
+
     template<typename ValueType>
     struct if_scalar<false,ValueType>{
-        static inline ValueType * dynamic_any_cast(dynamic_any * operand)
+        template<typename Alloc>
+        static inline ValueType * dynamic_any_cast(basic_dynamic_any<Alloc> * operand)
         {
-            return operand 
-                ? dynamic_cast<ValueType*>(operand->content)
-                : 0;
+            typedef BOOST_DEDUCED_TYPENAME remove_cv<ValueType>::type target;
+            typedef BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::template vtable_of<target> exact;
+
+            if(!operand || !operand->table)
+                return 0;
+
+            // Most casts ask for exactly the held type, whose table entry
+            // identifies it, and for which it is known statically where
+            // the value is stored.
+            if(BOOST_LIKELY(operand->table->type == &detail::dynamic_any::type_of<target>))
+            {
+                BOOST_DYNAMIC_ANY_AUX_COUNT(target, casts);
+                return exact::value(operand->buffer());
+            }
+            return cast<Alloc>(operand->table, operand->value());
+        }
+
+        template<typename Alloc>
+        static inline ValueType * cast(
+            const BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::vtable * table, void * value)
+        {
+            typedef BOOST_DEDUCED_TYPENAME remove_cv<ValueType>::type target;
+
+            if(BOOST_LIKELY(table->type == &detail::dynamic_any::type_of<target>))
+            {
+                BOOST_DYNAMIC_ANY_AUX_COUNT(target, casts);
+                return static_cast<target *>(value);
+            }
+
+#ifdef BOOST_DYNAMIC_ANY_NO_CAST_CACHE
+            return counted(table, search(table, value));
+#else
+            // Only the first cast from a given held type pays for the
+            // base-class search; later ones reuse its offset.
+            typedef BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::vtable vtable;
+            typedef detail::dynamic_any::cast_cache<target, vtable> cache;
+
+            const void * key = &table->type();
+            detail::dynamic_any::cast_cache_slot & slot = cache::slot(key);
+            if(slot.key != key && !cache::fetch(slot, key))
+            {
+                ValueType * result = search(table, value);
+                slot.offset = result
+                    ? reinterpret_cast<const volatile char *>(result)
+                        - static_cast<const volatile char *>(value)
+                    : detail::dynamic_any::no_conversion();
+                slot.key = key;
+                cache::publish(slot);
+                return counted(table, result);
+            }
+            return counted(table, slot.offset == detail::dynamic_any::no_conversion()
+                ? 0
+                : static_cast<ValueType *>(static_cast<void *>(
+                      static_cast<char *>(value) + slot.offset)));
+#endif
+        }
+
+    private:
+#ifdef BOOST_DYNAMIC_ANY_STATS
+        // counts a cast that did not ask for exactly the held type
+        template<typename Table>
+        static ValueType * counted(const Table * table, ValueType * result)
+        {
+            detail::dynamic_any_stats::counters & stats = table->stats();
+            if(result)
+            {
+                detail::dynamic_any_stats::count(stats, detail::dynamic_any_stats::casts);
+                detail::dynamic_any_stats::count(stats, detail::dynamic_any_stats::base_casts);
+            }
+            else
+                detail::dynamic_any_stats::count(stats, detail::dynamic_any_stats::failed_casts);
+            return result;
+        }
+#else
+        template<typename Table>
+        static ValueType * counted(const Table *, ValueType * result)
+        {
+            return result;
+        }
+#endif
+
+        // The held type may still be the target itself, seen through a
+        // type_info from another shared object.  Otherwise registered
+        // bases are tried first as they only need static casts.  With
+        // RTTI, any other public base is then found where dynamic_cast
+        // would find it: through the bases the held type's type_info
+        // lists under the Itanium ABI, and elsewhere by throwing the
+        // value's address and catching it as a pointer to the target.
+        // The cast cache, where there is one, keeps this to about once per
+        // held type.
+        template<typename Table>
+        static ValueType * search(const Table * table, void * value)
+        {
+            typedef BOOST_DEDUCED_TYPENAME remove_cv<ValueType>::type target;
+
+            if(detail::dynamic_any::same_type(table->type(), detail::dynamic_any::type_of<target>()))
+                return static_cast<target *>(value);
+            void * base = table->cast_to_base(value, detail::dynamic_any::type_of<target>());
+            if(base)
+                return static_cast<ValueType *>(base);
+#ifdef BOOST_DYNAMIC_ANY_AUX_ABI_BASE_SEARCH
+            if(boost::is_class<target>::value && table->find_base)
+                return static_cast<ValueType *>(
+                    table->find_base(value, detail::dynamic_any::type_of<target>()));
+#endif
+#ifdef BOOST_DYNAMIC_ANY_AUX_THROW_SEARCH
+            if(!table->throw_value)
+                return 0;
+            try
+            {
+                table->throw_value(value);
+            }
+            catch(target * found)
+            {
+                return found;
+            }
+            catch(...)
+            {
+            }
+#endif
+            return 0;
         }
     };
     template<typename ValueType>
     struct if_scalar<true,ValueType>{
-        static inline ValueType * dynamic_any_cast(dynamic_any * operand)
+        template<typename Alloc>
+        static inline ValueType * dynamic_any_cast(basic_dynamic_any<Alloc> * operand)
         {
-            return operand && 
-    #ifdef BOOST_AUX_ANY_TYPE_ID_NAME
-                std::strcmp(operand->type().name(), typeid(ValueType).name()) == 0
-    #else
-                operand->type() == typeid(ValueType)
-    #endif
-                ? &static_cast<dynamic_any::holder<ValueType,true> *>(operand->content)->held
-                : 0;
+            return operand && operand->table ? cast<Alloc>(operand->table, operand->value()) : 0;
+        }
+
+        // Scalars have no bases, so only their type is compared: the
+        // table entry identifies it, except across shared object
+        // boundaries, where the type_info is consulted.
+        template<typename Alloc>
+        static inline ValueType * cast(
+            const BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::vtable * table, void * value)
+        {
+            typedef BOOST_DEDUCED_TYPENAME remove_cv<ValueType>::type target;
+
+            if(table->type == &detail::dynamic_any::type_of<target>
+                || detail::dynamic_any::same_type(table->type(), detail::dynamic_any::type_of<target>()))
+            {
+                BOOST_DYNAMIC_ANY_AUX_COUNT(target, casts);
+                return static_cast<target *>(value);
+            }
+#ifdef BOOST_DYNAMIC_ANY_STATS
+            detail::dynamic_any_stats::count(table->stats(), detail::dynamic_any_stats::failed_casts);
+#endif
+            return 0;
         }
     };
 
-    template<typename ValueType>
-    ValueType * dynamic_any_cast(dynamic_any * operand)
+namespace detail {
+    namespace dynamic_any {
+        // The one door through which containers and algorithms built on
+        // top of basic_dynamic_any reach its values.  A value stored
+        // elsewhere (e.g. packed into a container's own buffer) is cast by
+        // exactly the same rules as one owned by a dynamic_any, given the
+        // table of its type and its address.
+        struct access
+        {
+            template<typename Alloc>
+            struct types
+            {
+                typedef BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::vtable vtable;
+
+                // type::table is the table of ValueType
+                template<typename ValueType>
+                struct vtable_of
+                {
+                    typedef BOOST_DEDUCED_TYPENAME basic_dynamic_any<Alloc>::template vtable_of<ValueType> type;
+                };
+            };
+
+            template<typename Alloc>
+            static const BOOST_DEDUCED_TYPENAME types<Alloc>::vtable *
+            table(const basic_dynamic_any<Alloc> & operand)
+            {
+                return operand.table;
+            }
+
+            // address of the held value, or null if operand is empty
+            template<typename Alloc>
+            static void * value(const basic_dynamic_any<Alloc> & operand)
+            {
+                return operand.table ? operand.value() : 0;
+            }
+
+            template<typename ValueType, typename Alloc>
+            static ValueType * cast(const BOOST_DEDUCED_TYPENAME types<Alloc>::vtable * table, void * value)
+            {
+                return if_scalar<boost::is_scalar<ValueType>::value, ValueType>::
+                    template cast<Alloc>(table, value);
+            }
+
+            // Values of different held types are never equal, which is
+            // settled by their types alone.
+            template<typename Alloc>
+            static bool equal(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+            {
+                if(!lhs.table || !rhs.table)
+                    return !lhs.table && !rhs.table;
+                if(!same_type(lhs.table->type(), rhs.table->type()))
+                    return false;
+                const comparison_ops & ops = lhs.table->comparisons();
+                if(!ops.equal)
+                    boost::throw_exception(bad_dynamic_any_comparison());
+                return ops.equal(lhs.value(), rhs.value());
+            }
+
+            // Empty values come first, then values are ordered by held
+            // type, then by value.
+            template<typename Alloc>
+            static bool less(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+            {
+                if(!lhs.table || !rhs.table)
+                    return !lhs.table && rhs.table;
+                if(!same_type(lhs.table->type(), rhs.table->type()))
+                    return boost::typeindex::type_index(lhs.table->type())
+                         < boost::typeindex::type_index(rhs.table->type());
+                const comparison_ops & ops = lhs.table->comparisons();
+                if(!ops.less)
+                    boost::throw_exception(bad_dynamic_any_comparison());
+                return ops.less(lhs.value(), rhs.value());
+            }
+
+            // the hash of the held value alone, 0 when empty, so that a
+            // ValueType hashes the same as a dynamic_any holding it
+            template<typename Alloc>
+            static std::size_t hash(const basic_dynamic_any<Alloc> & operand)
+            {
+                if(!operand.table)
+                    return 0;
+                const comparison_ops & ops = operand.table->comparisons();
+                if(!ops.hash)
+                    boost::throw_exception(bad_dynamic_any_comparison());
+                return ops.hash(operand.value());
+            }
+        };
+    } // namespace dynamic_any
+} // namespace detail
+
+    // The pointer forms never throw: a failed cast, or a null or empty
+    // operand, yields a null pointer.  Use them, or try_cast below, where
+    // misses are expected or exceptions are disabled.
+    template<typename ValueType, typename Alloc>
+    ValueType * dynamic_any_cast(basic_dynamic_any<Alloc> * operand) BOOST_NOEXCEPT
     {
         return  if_scalar<boost::is_scalar<ValueType>::value,ValueType>::dynamic_any_cast(operand);
     }
 
 
-    template<typename ValueType>
-    inline const ValueType * dynamic_any_cast(const dynamic_any * operand)
+    template<typename ValueType, typename Alloc>
+    inline const ValueType * dynamic_any_cast(const basic_dynamic_any<Alloc> * operand) BOOST_NOEXCEPT
     {
-        return dynamic_any_cast<ValueType>(const_cast<dynamic_any *>(operand));
+        return dynamic_any_cast<ValueType>(const_cast<basic_dynamic_any<Alloc> *>(operand));
     }
 
-    template<typename ValueType>
-    ValueType dynamic_any_cast(dynamic_any & operand)
+    template<typename ValueType, typename Alloc>
+    ValueType dynamic_any_cast(basic_dynamic_any<Alloc> & operand)
     {
         typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
 
@@ -256,8 +1470,8 @@ namespace boost
         return *result;
     }
 
-    template<typename ValueType>
-    inline ValueType dynamic_any_cast(const dynamic_any & operand)
+    template<typename ValueType, typename Alloc>
+    inline ValueType dynamic_any_cast(const basic_dynamic_any<Alloc> & operand)
     {
         typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
 
@@ -267,7 +1481,7 @@ namespace boost
         BOOST_STATIC_ASSERT(!is_reference<nonref>::value);
 #endif
 
-        return dynamic_any_cast<const nonref &>(const_cast<dynamic_any &>(operand));
+        return dynamic_any_cast<const nonref &>(const_cast<basic_dynamic_any<Alloc> &>(operand));
     }
 
     // Note: The "unsafe" versions of dynamic_any_cast are not part of the
@@ -275,18 +1489,232 @@ namespace boost
     // required where we know what type is stored in the dynamic_any and can't
     // use typeid() comparison, e.g., when our types may travel across
     // different shared libraries.
-    template<typename ValueType>
-    inline ValueType * unsafe_any_cast(dynamic_any * operand)
+    template<typename ValueType, typename Alloc>
+    inline ValueType * unsafe_any_cast(basic_dynamic_any<Alloc> * operand) BOOST_NOEXCEPT
     {
         return dynamic_any_cast<ValueType>(operand);
     }
 
-    template<typename ValueType>
-    inline const ValueType * unsafe_any_cast(const dynamic_any * operand)
+    template<typename ValueType, typename Alloc>
+    inline const ValueType * unsafe_any_cast(const basic_dynamic_any<Alloc> * operand) BOOST_NOEXCEPT
     {
-        return unsafe_any_cast<ValueType>(const_cast<dynamic_any *>(operand));
+        return unsafe_any_cast<ValueType>(const_cast<basic_dynamic_any<Alloc> *>(operand));
     }
+
+    // The held value as a ValueType (or ValueType &), or an empty optional
+    // where the reference form of dynamic_any_cast would throw.
+    template<typename ValueType, typename Alloc>
+    inline boost::optional<BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type &>
+    try_cast(basic_dynamic_any<Alloc> & operand) BOOST_NOEXCEPT
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        nonref * result = dynamic_any_cast<nonref>(&operand);
+        if(BOOST_LIKELY(result != 0))
+            return boost::optional<nonref &>(*result);
+        return boost::none;
+    }
+
+    template<typename ValueType, typename Alloc>
+    inline boost::optional<const BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type &>
+    try_cast(const basic_dynamic_any<Alloc> & operand) BOOST_NOEXCEPT
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        return try_cast<const nonref>(const_cast<basic_dynamic_any<Alloc> &>(operand));
+    }
+
+    // Comparisons throw bad_dynamic_any_comparison for held types that
+    // have not opted in through dynamic_any_comparison.
+    template<typename Alloc>
+    inline bool operator==(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+    {
+        return detail::dynamic_any::access::equal(lhs, rhs);
+    }
+
+    template<typename Alloc>
+    inline bool operator!=(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+    {
+        return !detail::dynamic_any::access::equal(lhs, rhs);
+    }
+
+    template<typename Alloc>
+    inline bool operator<(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+    {
+        return detail::dynamic_any::access::less(lhs, rhs);
+    }
+
+    template<typename Alloc>
+    inline bool operator>(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+    {
+        return detail::dynamic_any::access::less(rhs, lhs);
+    }
+
+    template<typename Alloc>
+    inline bool operator<=(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+    {
+        return !detail::dynamic_any::access::less(rhs, lhs);
+    }
+
+    template<typename Alloc>
+    inline bool operator>=(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs)
+    {
+        return !detail::dynamic_any::access::less(lhs, rhs);
+    }
+
+    template<typename Alloc>
+    inline std::size_t hash_value(const basic_dynamic_any<Alloc> & operand)
+    {
+        return detail::dynamic_any::access::hash(operand);
+    }
+
+    // Hash, equality and ordering for containers keyed by dynamic_any.
+    // They are transparent, so a plain value can be looked up without
+    // first being put into a dynamic_any: it hashes like a dynamic_any
+    // holding it and only equals one holding exactly its type.
+
+    struct dynamic_any_hash
+    {
+        typedef void is_transparent;
+
+        template<typename Alloc>
+        std::size_t operator()(const basic_dynamic_any<Alloc> & operand) const
+        {
+            return detail::dynamic_any::access::hash(operand);
+        }
+
+        template<typename ValueType>
+        std::size_t operator()(const ValueType & value) const
+        {
+            return boost::hash<ValueType>()(value);
+        }
+    };
+
+    struct dynamic_any_equal_to
+    {
+        typedef void is_transparent;
+
+        template<typename Alloc>
+        bool operator()(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs) const
+        {
+            return detail::dynamic_any::access::equal(lhs, rhs);
+        }
+
+        template<typename Alloc, typename ValueType>
+        bool operator()(const basic_dynamic_any<Alloc> & lhs, const ValueType & rhs) const
+        {
+            return held(lhs, rhs);
+        }
+
+        template<typename ValueType, typename Alloc>
+        bool operator()(const ValueType & lhs, const basic_dynamic_any<Alloc> & rhs) const
+        {
+            return held(rhs, lhs);
+        }
+
+    private:
+        template<typename Alloc, typename ValueType>
+        static bool held(const basic_dynamic_any<Alloc> & operand, const ValueType & value)
+        {
+            return !operand.empty()
+                && detail::dynamic_any::same_type(operand.type(), detail::dynamic_any::type_of<ValueType>())
+                && *unsafe_any_cast<ValueType>(&operand) == value;
+        }
+    };
+
+    struct dynamic_any_less
+    {
+        typedef void is_transparent;
+
+        template<typename Alloc>
+        bool operator()(const basic_dynamic_any<Alloc> & lhs, const basic_dynamic_any<Alloc> & rhs) const
+        {
+            return detail::dynamic_any::access::less(lhs, rhs);
+        }
+
+        template<typename Alloc, typename ValueType>
+        bool operator()(const basic_dynamic_any<Alloc> & lhs, const ValueType & rhs) const
+        {
+            if(lhs.empty())
+                return true;
+            if(!detail::dynamic_any::same_type(lhs.type(), detail::dynamic_any::type_of<ValueType>()))
+                return boost::typeindex::type_index(lhs.type()) < boost::typeindex::type_id<ValueType>();
+            return *unsafe_any_cast<ValueType>(&lhs) < rhs;
+        }
+
+        template<typename ValueType, typename Alloc>
+        bool operator()(const ValueType & lhs, const basic_dynamic_any<Alloc> & rhs) const
+        {
+            if(rhs.empty())
+                return false;
+            if(!detail::dynamic_any::same_type(rhs.type(), detail::dynamic_any::type_of<ValueType>()))
+                return boost::typeindex::type_id<ValueType>() < boost::typeindex::type_index(rhs.type());
+            return lhs < *unsafe_any_cast<ValueType>(&rhs);
+        }
+    };
+}
+
+#ifndef BOOST_NO_CXX11_HDR_FUNCTIONAL
+namespace std
+{
+    template<typename Alloc>
+    struct hash<boost::basic_dynamic_any<Alloc> >
+    {
+        std::size_t operator()(const boost::basic_dynamic_any<Alloc> & operand) const
+        {
+            return boost::hash_value(operand);
+        }
+    };
 }
+#endif
+
+// Opts a type in to all of dynamic_any's comparisons; it needs ==, < and
+// boost::hash support.  Use at global scope.
+#define BOOST_DYNAMIC_ANY_COMPARABLE(ValueType)                                 \
+    namespace boost {                                                           \
+        template<>                                                              \
+        struct dynamic_any_comparison< ValueType >                              \
+        {                                                                       \
+            BOOST_STATIC_CONSTANT(bool, equality = true);                       \
+            BOOST_STATIC_CONSTANT(bool, ordering = true);                       \
+            BOOST_STATIC_CONSTANT(bool, hashing = true);                        \
+        };                                                                      \
+    }
+
+// Registers the base classes of a class so that dynamic_any_cast can reach
+// them by static casts alone, which makes base casts available in builds
+// without RTTI or exceptions.  Use at global scope, before the first cast from Derived:
+//
+//     BOOST_DYNAMIC_ANY_BASES(derived, base, base1)
+//     BOOST_DYNAMIC_ANY_BASES_SEQ(derived, (base)(base1)) // without variadic macros
+//
+// Bases that have their own registration are searched recursively.
+#define BOOST_DYNAMIC_ANY_BASES_SEQ(Derived, Bases)                             \
+    namespace boost {                                                           \
+        template<>                                                              \
+        struct dynamic_any_bases< Derived >                                     \
+        {                                                                       \
+            static void * cast(Derived * boost_dynamic_any_derived,             \
+                const ::boost::typeindex::type_info & boost_dynamic_any_target) \
+            {                                                                   \
+                void * boost_dynamic_any_result = 0;                            \
+                BOOST_PP_SEQ_FOR_EACH(BOOST_DYNAMIC_ANY_AUX_TRY_BASE, Derived,  \
+                    Bases)                                                      \
+                return boost_dynamic_any_result;                                \
+            }                                                                   \
+        };                                                                      \
+    }
+
+#define BOOST_DYNAMIC_ANY_AUX_TRY_BASE(r, Derived, Base)                        \
+    if(!boost_dynamic_any_result)                                               \
+        boost_dynamic_any_result =                                              \
+            ::boost::detail::dynamic_any::cast_to_base< Derived, Base >(        \
+                boost_dynamic_any_derived, boost_dynamic_any_target);
+
+#if BOOST_PP_VARIADICS
+#  define BOOST_DYNAMIC_ANY_BASES(Derived, ...)                                 \
+    BOOST_DYNAMIC_ANY_BASES_SEQ(Derived, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+#endif
 
 // Copyright Kevlin Henney, 2000, 2001, 2002. All rights reserved.
 //
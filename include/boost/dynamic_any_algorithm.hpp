@@ -0,0 +1,470 @@
+#ifndef BOOST_DYNAMIC_ANY_ALGORITHM_INCLUDED
+#define BOOST_DYNAMIC_ANY_ALGORITHM_INCLUDED
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+
+// Number of slots (a power of two) in the table of held types a batch cast
+// keeps while it runs.  Ranges holding more types than this still work,
+// only with more repeated decisions.
+#ifndef BOOST_DYNAMIC_ANY_BATCH_CAST_SLOTS
+#  define BOOST_DYNAMIC_ANY_BATCH_CAST_SLOTS 16
+#endif
+
+// Casts through a dynamic_any_type_index scan its ids sixteen (SSE2) or
+// thirty-two (AVX2) at a time where the target has those instructions,
+// unless BOOST_DYNAMIC_ANY_NO_SIMD is defined; elsewhere one at a time.
+#ifndef BOOST_DYNAMIC_ANY_NO_SIMD
+#  if defined(__AVX2__)
+#    include <immintrin.h>
+#    define BOOST_DYNAMIC_ANY_AUX_SCAN_AVX2
+#  elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define BOOST_DYNAMIC_ANY_AUX_SCAN_SSE2
+#  endif
+#  if defined(BOOST_MSVC) && (defined(BOOST_DYNAMIC_ANY_AUX_SCAN_AVX2) || defined(BOOST_DYNAMIC_ANY_AUX_SCAN_SSE2))
+#    include <intrin.h>
+#  endif
+#endif
+
+namespace boost
+{
+    template<typename Alloc>
+    class basic_dynamic_any_type_index;
+
+namespace detail {
+    namespace dynamic_any_algorithm {
+        typedef boost::detail::dynamic_any::access access;
+
+        template<typename Iterator>
+        struct operand
+        {
+            typedef BOOST_DEDUCED_TYPENAME boost::remove_reference<
+                BOOST_DEDUCED_TYPENAME std::iterator_traits<Iterator>::reference>::type type;
+        };
+
+        template<typename Any>
+        struct allocator_of
+        {
+            typedef BOOST_DEDUCED_TYPENAME Any::allocator_type type;
+        };
+
+        template<typename Any>
+        struct allocator_of<const Any> : allocator_of<Any>
+        {
+        };
+
+        // Whether a held type casts to ValueType, and at which offset from
+        // the value, depends on the held type alone, whose table pointer
+        // every element carries.  So over a whole range the cast is only
+        // worked out once per held type; every other element costs a load
+        // and compare of its table pointer, and the payload of an element
+        // that does not match is never touched.
+        template<typename ValueType, typename Alloc>
+        class batch_cast
+        {
+        public:
+            typedef BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable vtable;
+
+            batch_cast()
+            {
+                for(std::size_t i = 0; i != BOOST_DYNAMIC_ANY_BATCH_CAST_SLOTS; ++i)
+                {
+                    m_slots[i].table = 0;
+                    m_slots[i].offset = detail::dynamic_any::no_conversion();
+                }
+            }
+
+            ValueType * operator()(const basic_dynamic_any<Alloc> & operand)
+            {
+                const vtable * table = access::table(operand);
+                if(!table)
+                    return 0;
+
+                slot & s = m_slots[(reinterpret_cast<std::size_t>(table) >> 4)
+                    & (BOOST_DYNAMIC_ANY_BATCH_CAST_SLOTS - 1)];
+                if(BOOST_UNLIKELY(s.table != table))
+                {
+                    void * value = access::value(operand);
+                    ValueType * result = access::cast<ValueType, Alloc>(table, value);
+                    s.table = table;
+                    s.offset = result
+                        ? reinterpret_cast<const volatile char *>(result)
+                            - static_cast<const volatile char *>(value)
+                        : detail::dynamic_any::no_conversion();
+                    return result;
+                }
+                if(s.offset == detail::dynamic_any::no_conversion())
+                    return 0;
+                return static_cast<ValueType *>(static_cast<void *>(
+                    static_cast<char *>(access::value(operand)) + s.offset));
+            }
+
+        private:
+            struct slot
+            {
+                const vtable * table;
+                std::ptrdiff_t offset;
+            };
+
+            slot m_slots[BOOST_DYNAMIC_ANY_BATCH_CAST_SLOTS];
+        };
+
+        // Ids of a dynamic_any_type_index: empty elements have id 0, the
+        // held types it has met ids 1 up to overflow_id - 1, in the order
+        // met, and all the types after those share overflow_id.
+        typedef boost::uint8_t type_id;
+
+        enum
+        {
+            empty_id = 0,
+            overflow_id = 255,
+            // the most ids the SIMD scan compares each block against
+            simd_ids = 4
+        };
+
+        struct index_access
+        {
+            template<typename Alloc>
+            struct types_of
+            {
+                typedef BOOST_DEDUCED_TYPENAME basic_dynamic_any_type_index<Alloc>::types type;
+            };
+
+            template<typename Alloc>
+            static const std::vector<type_id> & ids(const basic_dynamic_any_type_index<Alloc> & index)
+            {
+                return index.m_ids;
+            }
+
+            template<typename Alloc>
+            static const BOOST_DEDUCED_TYPENAME types_of<Alloc>::type &
+            types(const basic_dynamic_any_type_index<Alloc> & index)
+            {
+                return index.m_types;
+            }
+        };
+
+#if defined(BOOST_DYNAMIC_ANY_AUX_SCAN_AVX2) || defined(BOOST_DYNAMIC_ANY_AUX_SCAN_SSE2)
+        inline std::size_t lowest_bit(unsigned mask)
+        {
+#  ifdef BOOST_MSVC
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return index;
+#  else
+            return __builtin_ctz(mask);
+#  endif
+        }
+#endif
+
+        // Calls f(i) for every i in [0, size) for which ids[i] is one of
+        // the count (one up to simd_ids) ids in wanted.
+        template<typename F>
+        void scan_ids(const type_id * ids, std::size_t size,
+            const type_id * wanted, std::size_t count, F & f)
+        {
+            std::size_t i = 0;
+#if defined(BOOST_DYNAMIC_ANY_AUX_SCAN_AVX2)
+            __m256i keys[simd_ids];
+            for(std::size_t k = 0; k != count; ++k)
+                keys[k] = _mm256_set1_epi8(static_cast<char>(wanted[k]));
+            for(; i + 32 <= size; i += 32)
+            {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ids + i));
+                __m256i hits = _mm256_cmpeq_epi8(block, keys[0]);
+                for(std::size_t k = 1; k < count; ++k)
+                    hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, keys[k]));
+                for(unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)); mask; mask &= mask - 1)
+                    f(i + lowest_bit(mask));
+            }
+#elif defined(BOOST_DYNAMIC_ANY_AUX_SCAN_SSE2)
+            __m128i keys[simd_ids];
+            for(std::size_t k = 0; k != count; ++k)
+                keys[k] = _mm_set1_epi8(static_cast<char>(wanted[k]));
+            for(; i + 16 <= size; i += 16)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ids + i));
+                __m128i hits = _mm_cmpeq_epi8(block, keys[0]);
+                for(std::size_t k = 1; k < count; ++k)
+                    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, keys[k]));
+                for(unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits)); mask; mask &= mask - 1)
+                    f(i + lowest_bit(mask));
+            }
+#endif
+            for(; i != size; ++i)
+                for(std::size_t k = 0; k != count; ++k)
+                    if(ids[i] == wanted[k])
+                    {
+                        f(i);
+                        break;
+                    }
+        }
+
+        // the same for any number of wanted ids, marked in a table
+        template<typename F>
+        void scan_ids(const type_id * ids, std::size_t size, const bool (&wanted)[256], F & f)
+        {
+            for(std::size_t i = 0; i != size; ++i)
+                if(wanted[ids[i]])
+                    f(i);
+        }
+
+        // Writes the element at i out, cast as the offset of its id says;
+        // elements with overflow_id are cast one by one.
+        template<typename ValueType, typename Alloc, typename Iterator, typename OutputIterator>
+        class indexed_cast
+        {
+        public:
+            indexed_cast(const type_id * ids, const std::ptrdiff_t * offsets,
+                    Iterator first, OutputIterator & out)
+              : m_ids(ids), m_offsets(offsets), m_first(first), m_out(out)
+            {
+            }
+
+            void operator()(std::size_t i)
+            {
+                const type_id id = m_ids[i];
+                if(BOOST_UNLIKELY(id == overflow_id))
+                {
+                    if(ValueType * value = m_overflow(m_first[i]))
+                        *m_out++ = value;
+                }
+                else
+                    *m_out++ = static_cast<ValueType *>(static_cast<void *>(
+                        static_cast<char *>(access::value(m_first[i])) + m_offsets[id]));
+            }
+
+        private:
+            const type_id * m_ids;
+            const std::ptrdiff_t * m_offsets;
+            Iterator m_first;
+            OutputIterator & m_out;
+            batch_cast<ValueType, Alloc> m_overflow;
+        };
+
+        // const elements only give out const values
+        template<typename ValueType, typename Any>
+        struct result_of_cast
+        {
+            typedef ValueType type;
+        };
+
+        template<typename ValueType, typename Any>
+        struct result_of_cast<ValueType, const Any>
+        {
+            typedef const ValueType type;
+        };
+    } // namespace dynamic_any_algorithm
+} // namespace detail
+
+    // One-byte ids of the held types of a sequence of dynamic_any, one per
+    // element in the same order, for casts over the sequence that scan the
+    // ids instead of reading every element.  It is built from the sequence
+    // and has to be kept up to date with it: push_back what is appended to
+    // the sequence, and build it again when elements change type.  The
+    // first 254 held types met get an id of their own; elements of any
+    // further type are still found, only cast one by one.
+    template<typename Alloc = std::allocator<char> >
+    class basic_dynamic_any_type_index
+    {
+    public:
+        typedef detail::dynamic_any_algorithm::type_id id_type;
+        typedef std::size_t size_type;
+
+        basic_dynamic_any_type_index()
+          : m_last(detail::dynamic_any_algorithm::empty_id)
+        {
+        }
+
+        template<typename InputIterator>
+        basic_dynamic_any_type_index(InputIterator first, InputIterator last)
+          : m_last(detail::dynamic_any_algorithm::empty_id)
+        {
+            append(first, last);
+        }
+
+        void push_back(const basic_dynamic_any<Alloc> & value)
+        {
+            m_ids.push_back(id_of(value));
+        }
+
+        template<typename InputIterator>
+        void append(InputIterator first, InputIterator last)
+        {
+            for(; first != last; ++first)
+                push_back(*first);
+        }
+
+        void clear()
+        {
+            m_ids.clear();
+            m_types.clear();
+            m_last = detail::dynamic_any_algorithm::empty_id;
+        }
+
+        size_type size() const
+        {
+            return m_ids.size();
+        }
+
+        bool empty() const
+        {
+            return m_ids.empty();
+        }
+
+        // the id of the element at position i
+        id_type operator[](size_type i) const
+        {
+            return m_ids[i];
+        }
+
+    private:
+        friend struct detail::dynamic_any_algorithm::index_access;
+
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any::access::types<Alloc>::vtable vtable;
+
+        // a held type, and the first element that holds it, through which
+        // casts work out the offset of the result for all the others
+        struct held
+        {
+            const vtable * table;
+            size_type first;
+        };
+
+        typedef std::vector<held> types;
+
+        id_type id_of(const basic_dynamic_any<Alloc> & value)
+        {
+            using namespace detail::dynamic_any_algorithm;
+
+            const vtable * table = detail::dynamic_any::access::table(value);
+            if(!table)
+                return empty_id;
+            if(m_last != empty_id && m_types[m_last - 1].table == table)
+                return m_last;
+            for(std::size_t k = 0; k != m_types.size(); ++k)
+                if(m_types[k].table == table)
+                    return m_last = static_cast<id_type>(k + 1);
+            if(m_types.size() == overflow_id - 1)
+                return overflow_id;
+            const held type = { table, m_ids.size() };
+            m_types.push_back(type);
+            return m_last = static_cast<id_type>(m_types.size());
+        }
+
+        std::vector<id_type> m_ids;
+        types m_types;  // the held type with id k at k - 1
+        id_type m_last; // the id found last, tried first
+    };
+
+    typedef basic_dynamic_any_type_index<> dynamic_any_type_index;
+
+    // Writes to out, in order, a pointer to every element of [first, last)
+    // that dynamic_any_cast<ValueType> accepts, as that cast would return
+    // it (so a const pointer for const elements); returns the end of out.
+    template<typename ValueType, typename InputIterator, typename OutputIterator>
+    OutputIterator cast_all(InputIterator first, InputIterator last, OutputIterator out)
+    {
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_algorithm::operand<InputIterator>::type any_type;
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_algorithm::allocator_of<any_type>::type alloc_type;
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_algorithm::result_of_cast<ValueType, any_type>::type result_type;
+
+        detail::dynamic_any_algorithm::batch_cast<result_type, alloc_type> cast;
+        for(; first != last; ++first)
+            if(result_type * value = cast(*first))
+                *out++ = value;
+        return out;
+    }
+
+    // The same over a random access range that index was built from: the
+    // cast is worked out once per id, then the ids are scanned, with SSE2
+    // or AVX2 compares where there are at most four that match, and only
+    // the matching elements are read.
+    template<typename ValueType, typename RandomAccessIterator, typename Alloc, typename OutputIterator>
+    OutputIterator cast_all(const basic_dynamic_any_type_index<Alloc> & index,
+        RandomAccessIterator first, RandomAccessIterator last, OutputIterator out)
+    {
+        using namespace detail::dynamic_any_algorithm;
+        typedef BOOST_DEDUCED_TYPENAME operand<RandomAccessIterator>::type any_type;
+        typedef BOOST_DEDUCED_TYPENAME result_of_cast<ValueType, any_type>::type result_type;
+        typedef BOOST_DEDUCED_TYPENAME index_access::types_of<Alloc>::type types;
+
+        BOOST_ASSERT(index.size() == static_cast<std::size_t>(last - first));
+        (void)last;
+
+        const types & held = index_access::types(index);
+        std::ptrdiff_t offsets[overflow_id];
+        type_id wanted[overflow_id];
+        std::size_t count = 0;
+        for(std::size_t k = 0; k != held.size(); ++k)
+        {
+            void * value = access::value(first[held[k].first]);
+            if(result_type * result = access::cast<result_type, Alloc>(held[k].table, value))
+            {
+                offsets[k + 1] = reinterpret_cast<const volatile char *>(result)
+                    - static_cast<const volatile char *>(value);
+                wanted[count++] = static_cast<type_id>(k + 1);
+            }
+        }
+        if(held.size() == overflow_id - 1)
+            wanted[count++] = overflow_id;
+        if(count == 0)
+            return out;
+
+        const std::vector<type_id> & ids = index_access::ids(index);
+        indexed_cast<result_type, Alloc, RandomAccessIterator, OutputIterator>
+            cast(&ids[0], offsets, first, out);
+        if(count <= simd_ids)
+            scan_ids(&ids[0], ids.size(), wanted, count, cast);
+        else
+        {
+            bool match[256] = {};
+            for(std::size_t k = 0; k != count; ++k)
+                match[wanted[k]] = true;
+            scan_ids(&ids[0], ids.size(), match, cast);
+        }
+        return out;
+    }
+
+    // the pointers cast_all would write, as a vector
+    template<typename ValueType, typename InputIterator>
+    std::vector<BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::result_of_cast<ValueType,
+        BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::operand<InputIterator>::type>::type *>
+    filter(InputIterator first, InputIterator last)
+    {
+        std::vector<BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::result_of_cast<ValueType,
+            BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::operand<InputIterator>::type>::type *> result;
+        cast_all<ValueType>(first, last, std::back_inserter(result));
+        return result;
+    }
+
+    template<typename ValueType, typename RandomAccessIterator, typename Alloc>
+    std::vector<BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::result_of_cast<ValueType,
+        BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::operand<RandomAccessIterator>::type>::type *>
+    filter(const basic_dynamic_any_type_index<Alloc> & index,
+        RandomAccessIterator first, RandomAccessIterator last)
+    {
+        std::vector<BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::result_of_cast<ValueType,
+            BOOST_DEDUCED_TYPENAME detail::dynamic_any_algorithm::operand<RandomAccessIterator>::type>::type *> result;
+        cast_all<ValueType>(index, first, last, std::back_inserter(result));
+        return result;
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef BOOST_DYNAMIC_ANY_COLLECTION_INCLUDED
+#define BOOST_DYNAMIC_ANY_COLLECTION_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/dynamic_any_vector.hpp>
+#include <boost/core/no_exceptions_support.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_collection {
+        typedef detail::dynamic_any_vector::element_ops element_ops;
+
+        inline bool same_type(const element_ops * a, const element_ops * b)
+        {
+            return a == b || detail::dynamic_any::same_type(a->type(), b->type());
+        }
+
+        // The values of one concrete type, as an array.
+        class segment
+        {
+        public: // structors
+
+            explicit segment(const element_ops * ops)
+              : m_ops(ops), m_storage(0), m_size(0), m_capacity(0)
+            {
+            }
+
+            segment(const segment & other)
+              : m_ops(other.m_ops), m_storage(0), m_size(0), m_capacity(0)
+            {
+                if(other.m_size == 0)
+                    return;
+
+                m_storage = detail::dynamic_any_vector::allocate(other.m_size * m_ops->size);
+                m_capacity = other.m_size;
+                BOOST_TRY
+                {
+                    for(; m_size != other.m_size; ++m_size)
+                        m_ops->copy(other.at(m_size), at(m_size));
+                }
+                BOOST_CATCH(...)
+                {
+                    clear();
+                    detail::dynamic_any_vector::deallocate(m_storage, m_capacity * m_ops->size);
+                    BOOST_RETHROW
+                }
+                BOOST_CATCH_END
+            }
+
+            segment(segment && other) BOOST_NOEXCEPT
+              : m_ops(other.m_ops), m_storage(other.m_storage),
+                m_size(other.m_size), m_capacity(other.m_capacity)
+            {
+                other.m_storage = 0;
+                other.m_size = other.m_capacity = 0;
+            }
+
+            ~segment()
+            {
+                clear();
+                detail::dynamic_any_vector::deallocate(m_storage, m_capacity * m_ops->size);
+            }
+
+        public: // modifiers
+
+            // constructs a ValueType from args after the last element; when
+            // the segment is full the value is built in the new storage
+            // before the others move out of the old one, so args may refer
+            // to an element of this segment
+            template<typename ValueType, typename... Args>
+            ValueType * emplace(Args &&... args)
+            {
+                if(m_size != m_capacity)
+                {
+                    ValueType * result = new(at(m_size)) ValueType(static_cast<Args &&>(args)...);
+                    ++m_size;
+                    return result;
+                }
+
+                const std::size_t capacity = m_capacity ? 2 * m_capacity : 4;
+                std::max_align_t * storage =
+                    detail::dynamic_any_vector::allocate(capacity * m_ops->size);
+                ValueType * result;
+                BOOST_TRY
+                {
+                    result = new(reinterpret_cast<char *>(storage) + m_size * m_ops->size)
+                        ValueType(static_cast<Args &&>(args)...);
+                    BOOST_TRY
+                    {
+                        relocate(storage);
+                    }
+                    BOOST_CATCH(...)
+                    {
+                        result->~ValueType();
+                        BOOST_RETHROW
+                    }
+                    BOOST_CATCH_END
+                }
+                BOOST_CATCH(...)
+                {
+                    detail::dynamic_any_vector::deallocate(storage, capacity * m_ops->size);
+                    BOOST_RETHROW
+                }
+                BOOST_CATCH_END
+
+                for(std::size_t i = 0; i != m_size; ++i)
+                    m_ops->destroy(at(i));
+                detail::dynamic_any_vector::deallocate(m_storage, m_capacity * m_ops->size);
+                m_storage = storage;
+                m_capacity = capacity;
+                ++m_size;
+                return result;
+            }
+
+            void clear() BOOST_NOEXCEPT
+            {
+                while(m_size)
+                    m_ops->destroy(at(--m_size));
+            }
+
+        public: // queries
+
+            const element_ops * ops() const
+            {
+                return m_ops;
+            }
+
+            std::size_t size() const
+            {
+                return m_size;
+            }
+
+            void * at(std::size_t index) const
+            {
+                return reinterpret_cast<char *>(m_storage) + index * m_ops->size;
+            }
+
+        private:
+
+            // Constructs the elements at the same indices in storage,
+            // leaving the old storage as it was if one of them throws.
+            void relocate(std::max_align_t * storage)
+            {
+                char * to = reinterpret_cast<char *>(storage);
+                std::size_t i = 0;
+                BOOST_TRY
+                {
+                    for(; i != m_size; ++i)
+                        m_ops->relocate(at(i), to + i * m_ops->size);
+                }
+                BOOST_CATCH(...)
+                {
+                    while(i--)
+                        m_ops->destroy(to + i * m_ops->size);
+                    BOOST_RETHROW
+                }
+                BOOST_CATCH_END
+            }
+
+            const element_ops * m_ops;
+            std::max_align_t * m_storage;
+            std::size_t m_size;
+            std::size_t m_capacity;
+
+        private: // intentionally left unimplemented
+            segment & operator=(const segment &);
+        };
+    } // namespace dynamic_any_collection
+} // namespace detail
+
+/**
+    @brief an unordered collection of values of any copyable type, grouped by type.
+
+    Values are kept in one contiguous segment per concrete type, in insertion
+    order within a segment.  Visiting them goes segment by segment, so the
+    type of the held value is looked at once per segment rather than once per
+    element:
+
+    - for_each<T>(f) calls f on every value of exactly type T, with the calls
+      resolved statically;
+    - for_each_base<Base>(f) casts the first value of each segment to Base as
+      dynamic_any_cast would, and reaches the rest of the segment through the
+      same offset, so no dynamic_cast is done per element.
+*/
+class dynamic_any_collection
+{
+    public: // types
+
+        typedef std::size_t size_type;
+
+    public: // structors
+
+        dynamic_any_collection() BOOST_NOEXCEPT
+        {
+        }
+
+        dynamic_any_collection(const dynamic_any_collection & other)
+          : m_segments(other.m_segments)
+        {
+        }
+
+        dynamic_any_collection(dynamic_any_collection && other) BOOST_NOEXCEPT
+        {
+            swap(other);
+        }
+
+    public: // modifiers
+
+        dynamic_any_collection & swap(dynamic_any_collection & rhs) BOOST_NOEXCEPT
+        {
+            m_segments.swap(rhs.m_segments);
+            return *this;
+        }
+
+        dynamic_any_collection & operator=(const dynamic_any_collection & rhs)
+        {
+            dynamic_any_collection(rhs).swap(*this);
+            return *this;
+        }
+
+        dynamic_any_collection & operator=(dynamic_any_collection && rhs) BOOST_NOEXCEPT
+        {
+            rhs.swap(*this);
+            dynamic_any_collection().swap(rhs);
+            return *this;
+        }
+
+        template<typename ValueType>
+        void insert(ValueType && value)
+        {
+            emplace<BOOST_DEDUCED_TYPENAME decay<ValueType>::type>(
+                static_cast<ValueType &&>(value));
+        }
+
+        // constructs a ValueType from args at the end of its segment
+        template<typename ValueType, typename... Args>
+        ValueType & emplace(Args &&... args)
+        {
+            detail::dynamic_any_collection::segment & s =
+                segment_for(&detail::dynamic_any_vector::ops_of<ValueType>::table);
+            return *s.emplace<ValueType>(static_cast<Args &&>(args)...);
+        }
+
+        // destroys every value; segments keep their storage
+        void clear() BOOST_NOEXCEPT
+        {
+            for(std::size_t i = 0; i != m_segments.size(); ++i)
+                m_segments[i].clear();
+        }
+
+    public: // queries
+
+        bool empty() const BOOST_NOEXCEPT
+        {
+            return size() == 0;
+        }
+
+        size_type size() const BOOST_NOEXCEPT
+        {
+            size_type result = 0;
+            for(std::size_t i = 0; i != m_segments.size(); ++i)
+                result += m_segments[i].size();
+            return result;
+        }
+
+        // number of values of exactly type ValueType
+        template<typename ValueType>
+        size_type count() const
+        {
+            size_type result = 0;
+            for(std::size_t i = 0; i != m_segments.size(); ++i)
+                if(holds<ValueType>(m_segments[i]))
+                    result += m_segments[i].size();
+            return result;
+        }
+
+    public: // visitation
+
+        template<typename ValueType, typename F>
+        void for_each(F f)
+        {
+            visit<ValueType>(f);
+        }
+
+        template<typename ValueType, typename F>
+        void for_each(F f) const
+        {
+            const_cast<dynamic_any_collection *>(this)->visit<const ValueType>(f);
+        }
+
+        template<typename Base, typename F>
+        void for_each_base(F f)
+        {
+            visit_base<Base>(f);
+        }
+
+        template<typename Base, typename F>
+        void for_each_base(F f) const
+        {
+            const_cast<dynamic_any_collection *>(this)->visit_base<const Base>(f);
+        }
+
+    private: // representation
+
+        // only compares types, so that visiting a type that can never be
+        // held (an abstract class, say) compiles and finds nothing
+        template<typename ValueType>
+        static bool holds(const detail::dynamic_any_collection::segment & s)
+        {
+            return detail::dynamic_any::same_type(s.ops()->type(),
+                detail::dynamic_any::type_of<BOOST_DEDUCED_TYPENAME remove_cv<ValueType>::type>());
+        }
+
+        detail::dynamic_any_collection::segment &
+        segment_for(const detail::dynamic_any_collection::element_ops * ops)
+        {
+            for(std::size_t i = 0; i != m_segments.size(); ++i)
+                if(detail::dynamic_any_collection::same_type(m_segments[i].ops(), ops))
+                    return m_segments[i];
+            m_segments.push_back(detail::dynamic_any_collection::segment(ops));
+            return m_segments.back();
+        }
+
+        template<typename ValueType, typename F>
+        void visit(F & f)
+        {
+            for(std::size_t i = 0; i != m_segments.size(); ++i)
+            {
+                if(!holds<ValueType>(m_segments[i]))
+                    continue;
+                ValueType * first = static_cast<ValueType *>(m_segments[i].at(0));
+                ValueType * last = first + m_segments[i].size();
+                for(; first != last; ++first)
+                    f(*first);
+            }
+        }
+
+        template<typename Base, typename F>
+        void visit_base(F & f)
+        {
+            for(std::size_t i = 0; i != m_segments.size(); ++i)
+            {
+                const detail::dynamic_any_collection::segment & s = m_segments[i];
+                if(s.size() == 0)
+                    continue;
+
+                // The offset of a base within a value depends only on the
+                // value's type, so one cast serves the whole segment.
+                Base * base = detail::dynamic_any_vector::access::
+                    cast<Base, std::allocator<char> >(s.ops()->table, s.at(0));
+                if(!base)
+                    continue;
+
+                char * value = reinterpret_cast<char *>(const_cast<
+                    BOOST_DEDUCED_TYPENAME remove_cv<Base>::type *>(base));
+                const std::size_t stride = s.ops()->size;
+                for(char * last = value + s.size() * stride; value != last; value += stride)
+                    f(*static_cast<Base *>(static_cast<void *>(value)));
+            }
+        }
+
+        std::vector<detail::dynamic_any_collection::segment> m_segments;
+};
+
+    inline void swap(dynamic_any_collection & lhs, dynamic_any_collection & rhs) BOOST_NOEXCEPT
+    {
+        lhs.swap(rhs);
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
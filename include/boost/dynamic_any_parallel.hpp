@@ -0,0 +1,632 @@
+#ifndef BOOST_DYNAMIC_ANY_PARALLEL_INCLUDED
+#define BOOST_DYNAMIC_ANY_PARALLEL_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/dynamic_any_algorithm.hpp>
+#include <boost/dynamic_any_visit.hpp>
+#include <boost/optional/optional.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+
+#if defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) || defined(BOOST_NO_CXX11_THREAD_LOCAL) \
+ || defined(BOOST_NO_CXX11_HDR_ATOMIC) || defined(BOOST_NO_CXX11_HDR_THREAD) \
+ || defined(BOOST_NO_CXX11_HDR_MUTEX) || defined(BOOST_NO_CXX11_HDR_CONDITION_VARIABLE)
+#  error "boost/dynamic_any_parallel.hpp requires variadic templates, thread_local, <atomic>, <thread>, <mutex> and <condition_variable>"
+#endif
+
+// Number of elements the parallel algorithms hand to a thread at a time:
+// 32 KB of dynamic_any with the default buffer size, enough for the cost of
+// taking a chunk to vanish next to the work done on it.
+#ifndef BOOST_DYNAMIC_ANY_PARALLEL_CHUNK
+#  define BOOST_DYNAMIC_ANY_PARALLEL_CHUNK 1024
+#endif
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_parallel {
+        typedef boost::detail::dynamic_any::access access;
+
+        // one call of run, over chunks [0, chunks)
+        struct job
+        {
+            void (*call)(void * body, std::size_t chunk);
+            void * body;
+            std::atomic<std::size_t> remaining; // chunks not yet done
+            std::atomic<bool> failed;
+            std::exception_ptr error;
+        };
+
+        // chunks [begin, end) of the job being run, not yet started
+        struct task
+        {
+            std::size_t begin, end;
+        };
+
+        // The tasks of one participant: it pushes and pops at the back,
+        // others steal from the front, where the largest ranges are.
+        // Padded so that neighbouring queues share no cache line.
+        struct queue
+        {
+            std::mutex lock;
+            std::deque<task> tasks;
+            char padding[64];
+        };
+
+        template<typename Body>
+        void call(void * body, std::size_t chunk)
+        {
+            (*static_cast<Body *>(body))(chunk);
+        }
+
+        // the executor whose worker runs on this thread, if any
+        template<typename Executor>
+        struct current
+        {
+            static thread_local const Executor * value;
+        };
+
+        template<typename Executor>
+        thread_local const Executor * current<Executor>::value = 0;
+    } // namespace dynamic_any_parallel
+} // namespace detail
+
+/**
+    @brief a fixed set of threads sharing work by stealing.
+
+    run(chunks, body) calls body(i) for every i in [0, chunks), spread over
+    the threads of the executor and the calling thread, and returns when
+    all calls are done.  Each participant splits the ranges of chunks it
+    holds in halves, keeping one and queueing the other; a participant
+    with nothing left steals the largest queued range of another one.
+
+    One run is active at a time; callers on other threads wait for their
+    turn, and a run started from within a body is done on the spot by the
+    thread that starts it.  If a body throws, the remaining chunks are
+    skipped and the first exception is rethrown from run.
+*/
+class parallel_executor
+{
+    public: // structors
+
+        // concurrency is the number of threads taking part in a run, the
+        // calling one included
+        explicit parallel_executor(
+            std::size_t concurrency = (std::max)(std::thread::hardware_concurrency(), 1u))
+          : m_concurrency((std::max)(concurrency, std::size_t(1)))
+          , m_queues(new detail::dynamic_any_parallel::queue[m_concurrency])
+          , m_job(0), m_generation(0), m_busy(0), m_stop(false)
+        {
+            m_threads.reserve(m_concurrency - 1);
+            for(std::size_t i = 1; i != m_concurrency; ++i)
+                m_threads.push_back(std::thread(&parallel_executor::work, this, i));
+        }
+
+        ~parallel_executor()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for(std::size_t i = 0; i != m_threads.size(); ++i)
+                m_threads[i].join();
+        }
+
+    public: // queries
+
+        std::size_t concurrency() const BOOST_NOEXCEPT
+        {
+            return m_concurrency;
+        }
+
+    public: // runs
+
+        template<typename Body>
+        void run(std::size_t chunks, Body & body)
+        {
+            if(chunks == 0)
+                return;
+            if(chunks == 1 || m_concurrency == 1
+                || detail::dynamic_any_parallel::current<parallel_executor>::value == this)
+            {
+                for(std::size_t i = 0; i != chunks; ++i)
+                    body(i);
+                return;
+            }
+
+            std::lock_guard<std::mutex> turn(m_turn);
+            detail::dynamic_any_parallel::job j;
+            j.call = &detail::dynamic_any_parallel::call<Body>;
+            j.body = &body;
+            j.remaining.store(chunks, std::memory_order_relaxed);
+            j.failed.store(false, std::memory_order_relaxed);
+
+            push(0, 0, chunks);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_job = &j;
+                ++m_generation;
+                m_busy = m_threads.size();
+            }
+            m_wake.notify_all();
+
+            const parallel_executor * const previous =
+                detail::dynamic_any_parallel::current<parallel_executor>::value;
+            detail::dynamic_any_parallel::current<parallel_executor>::value = this;
+            help(0, j);
+            detail::dynamic_any_parallel::current<parallel_executor>::value = previous;
+
+            // j lives here, so no worker may still be looking at it
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this] { return m_busy == 0; });
+                m_job = 0;
+            }
+            if(j.failed.load(std::memory_order_acquire))
+                std::rethrow_exception(j.error);
+        }
+
+    private: // representation
+
+        void push(std::size_t self, std::size_t begin, std::size_t end)
+        {
+            const detail::dynamic_any_parallel::task t = { begin, end };
+            std::lock_guard<std::mutex> lock(m_queues[self].lock);
+            m_queues[self].tasks.push_back(t);
+        }
+
+        bool pop(std::size_t self, detail::dynamic_any_parallel::task & t)
+        {
+            detail::dynamic_any_parallel::queue & q = m_queues[self];
+            std::lock_guard<std::mutex> lock(q.lock);
+            if(q.tasks.empty())
+                return false;
+            t = q.tasks.back();
+            q.tasks.pop_back();
+            return true;
+        }
+
+        bool steal(std::size_t self, detail::dynamic_any_parallel::task & t)
+        {
+            for(std::size_t n = 1; n != m_concurrency; ++n)
+            {
+                detail::dynamic_any_parallel::queue & q = m_queues[(self + n) % m_concurrency];
+                std::lock_guard<std::mutex> lock(q.lock);
+                if(!q.tasks.empty())
+                {
+                    t = q.tasks.front();
+                    q.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // takes part in j until all of its chunks are done
+        void help(std::size_t self, detail::dynamic_any_parallel::job & j)
+        {
+            detail::dynamic_any_parallel::task t;
+            while(j.remaining.load(std::memory_order_acquire) != 0)
+            {
+                if(!pop(self, t) && !steal(self, t))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                // keep the first chunk, leave the rest to be stolen
+                while(t.end - t.begin > 1)
+                {
+                    const std::size_t middle = t.begin + (t.end - t.begin) / 2;
+                    push(self, middle, t.end);
+                    t.end = middle;
+                }
+                execute(j, t.begin);
+            }
+        }
+
+        static void execute(detail::dynamic_any_parallel::job & j, std::size_t chunk)
+        {
+            if(!j.failed.load(std::memory_order_relaxed))
+            {
+#ifndef BOOST_NO_EXCEPTIONS
+                try
+                {
+#endif
+                    j.call(j.body, chunk);
+#ifndef BOOST_NO_EXCEPTIONS
+                }
+                catch(...)
+                {
+                    if(!j.failed.exchange(true, std::memory_order_acq_rel))
+                        j.error = std::current_exception();
+                }
+#endif
+            }
+            j.remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        void work(std::size_t self)
+        {
+            detail::dynamic_any_parallel::current<parallel_executor>::value = this;
+            std::size_t seen = 0;
+            for(;;)
+            {
+                detail::dynamic_any_parallel::job * j;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                    if(m_stop)
+                        return;
+                    seen = m_generation;
+                    j = m_job;
+                }
+                help(self, *j);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if(--m_busy != 0)
+                        continue;
+                }
+                m_done.notify_one();
+            }
+        }
+
+        const std::size_t m_concurrency;
+        std::unique_ptr<detail::dynamic_any_parallel::queue[]> m_queues;
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_turn;  // one run at a time
+        std::mutex m_mutex; // guards what follows
+        std::condition_variable m_wake, m_done;
+        detail::dynamic_any_parallel::job * m_job;
+        std::size_t m_generation;
+        std::size_t m_busy; // workers still taking part in m_job
+        bool m_stop;
+
+    private: // intentionally left unimplemented
+        parallel_executor(const parallel_executor &);
+        parallel_executor & operator=(const parallel_executor &);
+};
+
+    // shared by the algorithms below when they are not given an executor;
+    // one thread per hardware thread
+    inline parallel_executor & default_parallel_executor()
+    {
+        static parallel_executor executor;
+        return executor;
+    }
+
+namespace detail {
+    namespace dynamic_any_parallel {
+        // Element index of the start of a chunk.  Nominally a multiple of
+        // BOOST_DYNAMIC_ANY_PARALLEL_CHUNK, it is moved forward, by at most
+        // half a chunk, past elements of the same held type as the one
+        // before, so that a run of one type is not split between chunks.
+        template<typename Iterator>
+        std::size_t chunk_start(Iterator first, std::size_t size, std::size_t chunk)
+        {
+            std::size_t start = chunk * BOOST_DYNAMIC_ANY_PARALLEL_CHUNK;
+            if(chunk == 0 || start >= size)
+                return (std::min)(start, size);
+            const std::size_t limit = (std::min)(start + BOOST_DYNAMIC_ANY_PARALLEL_CHUNK / 2, size);
+            while(start != limit && access::table(first[start]) == access::table(first[start - 1]))
+                ++start;
+            return start;
+        }
+
+        template<typename Iterator>
+        std::size_t chunk_count(Iterator first, Iterator last)
+        {
+            return (std::size_t(last - first) + BOOST_DYNAMIC_ANY_PARALLEL_CHUNK - 1)
+                / BOOST_DYNAMIC_ANY_PARALLEL_CHUNK;
+        }
+
+        template<typename ValueType, typename Any>
+        ValueType & at(Any & element, std::ptrdiff_t offset)
+        {
+            return *static_cast<ValueType *>(static_cast<void *>(
+                static_cast<char *>(access::value(element)) + offset));
+        }
+
+        template<typename Segment, typename Iterator, typename ValueType>
+        void call_run(Segment & segment, Iterator first, Iterator last, std::ptrdiff_t offset)
+        {
+            segment.template run<ValueType>(first, last, offset);
+        }
+
+        // Splits [first, last) into runs of one held type, picks the
+        // alternative of Types for each run once, and hands the run to
+        // segment.run<Type>, whose loop then knows the type of every value
+        // it touches; runs matching none go to segment.unmatched.
+        template<typename Alloc, typename Segment, typename Iterator, typename... Types>
+        void for_each_run(Iterator first, Iterator last, Segment & segment)
+        {
+            typedef void (*run_type)(Segment &, Iterator, Iterator, std::ptrdiff_t);
+            static const run_type runs[] = { &call_run<Segment, Iterator, Types>... };
+
+            while(first != last)
+            {
+                const BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable * table = access::table(*first);
+                Iterator end = first + 1;
+                while(end != last && access::table(*end) == table)
+                    ++end;
+
+                void * held = access::value(*first);
+                void * value = 0;
+                const std::size_t i = dynamic_any_visit::index<Alloc,
+                    BOOST_DEDUCED_TYPENAME remove_cv<Types>::type...>(table, held, value);
+                if(i != sizeof...(Types))
+                    runs[i](segment, first, end, static_cast<char *>(value) - static_cast<char *>(held));
+                else
+                    segment.unmatched(first, end);
+                first = end;
+            }
+        }
+
+        // calls body(begin, end) on the element range of each chunk
+        template<typename Iterator, typename Body>
+        struct chunked
+        {
+            Iterator first;
+            std::size_t size;
+            Body & body;
+
+            void operator()(std::size_t chunk)
+            {
+                body(chunk, chunk_start(first, size, chunk), chunk_start(first, size, chunk + 1));
+            }
+        };
+
+        template<typename Iterator, typename Body>
+        void run_chunks(parallel_executor & executor, Iterator first, Iterator last, Body & body)
+        {
+            chunked<Iterator, Body> chunks = { first, std::size_t(last - first), body };
+            executor.run(chunk_count(first, last), chunks);
+        }
+
+        template<typename Any, typename... Types>
+        struct runner
+        {
+            typedef BOOST_DEDUCED_TYPENAME dynamic_any_algorithm::allocator_of<Any>::type alloc_type;
+
+            template<typename Segment, typename Iterator>
+            static void run(Iterator first, Iterator last, Segment & segment)
+            {
+                for_each_run<alloc_type, Segment, Iterator,
+                    BOOST_DEDUCED_TYPENAME dynamic_any_algorithm::result_of_cast<Types, Any>::type...>(
+                        first, last, segment);
+            }
+        };
+
+        template<typename Iterator, typename Function, typename... Types>
+        struct for_each_body
+        {
+            typedef BOOST_DEDUCED_TYPENAME dynamic_any_algorithm::operand<Iterator>::type any_type;
+
+            Iterator first;
+            Function & f;
+
+            template<typename ValueType>
+            void run(Iterator begin, Iterator end, std::ptrdiff_t offset)
+            {
+                for(; begin != end; ++begin)
+                    f(at<ValueType>(*begin, offset));
+            }
+
+            void unmatched(Iterator, Iterator)
+            {
+            }
+
+            void operator()(std::size_t, std::size_t begin, std::size_t end)
+            {
+                runner<any_type, Types...>::run(first + begin, first + end, *this);
+            }
+        };
+
+        template<typename Iterator, typename OutputIterator, typename Function,
+                 typename Fallback, typename... Types>
+        struct transform_body
+        {
+            typedef BOOST_DEDUCED_TYPENAME dynamic_any_algorithm::operand<Iterator>::type any_type;
+
+            Iterator first;
+            OutputIterator out;
+            Function & f;
+            Fallback & fallback;
+
+            template<typename ValueType>
+            void run(Iterator begin, Iterator end, std::ptrdiff_t offset)
+            {
+                OutputIterator to = out + (begin - first);
+                for(; begin != end; ++begin, ++to)
+                    *to = f(at<ValueType>(*begin, offset));
+            }
+
+            void unmatched(Iterator begin, Iterator end)
+            {
+                OutputIterator to = out + (begin - first);
+                for(; begin != end; ++begin, ++to)
+                    *to = fallback(*begin);
+            }
+
+            void operator()(std::size_t, std::size_t begin, std::size_t end)
+            {
+                runner<any_type, Types...>::run(first + begin, first + end, *this);
+            }
+        };
+
+        // a partial result, empty until the chunk meets an element it
+        // reduces, and kept apart from its neighbours so that chunks
+        // finishing at once do not share a cache line
+        template<typename T>
+        struct partial
+        {
+            boost::optional<T> value;
+            char padding[64];
+        };
+
+        template<typename Iterator, typename T, typename Transform, typename Combine,
+                 typename... Types>
+        struct reduce_body
+        {
+            typedef BOOST_DEDUCED_TYPENAME dynamic_any_algorithm::operand<Iterator>::type any_type;
+
+            Iterator first;
+            Transform & transform;
+            Combine & combine;
+            std::vector<partial<T> > & partials;
+            boost::optional<T> * result;
+
+            template<typename ValueType>
+            void run(Iterator begin, Iterator end, std::ptrdiff_t offset)
+            {
+                if(begin != end && !*result)
+                {
+                    *result = T(transform(at<ValueType>(*begin, offset)));
+                    ++begin;
+                }
+                for(; begin != end; ++begin)
+                    **result = combine(**result, transform(at<ValueType>(*begin, offset)));
+            }
+
+            void unmatched(Iterator, Iterator)
+            {
+            }
+
+            void operator()(std::size_t chunk, std::size_t begin, std::size_t end)
+            {
+                reduce_body local = *this;
+                local.result = &partials[chunk].value;
+                runner<any_type, Types...>::run(first + begin, first + end, local);
+            }
+        };
+
+        template<typename R>
+        struct throw_bad_cast
+        {
+            template<typename Operand>
+            R operator()(Operand &) const
+            {
+                boost::throw_exception(bad_dynamic_any_cast());
+            }
+        };
+    } // namespace dynamic_any_parallel
+} // namespace detail
+
+    // Calls f, possibly on several threads at once, with the value of each
+    // element of the random access range [first, last) that holds one of
+    // Types, cast to the first of them that dynamic_any_cast would accept,
+    // as visit<Types...> does; other elements are skipped.  Elements are
+    // taken in chunks of consecutive ones, and within a chunk each run of
+    // one held type is dispatched once, so f is called for the whole run
+    // from a loop over values of a known type.
+    template<typename... Types, typename RandomAccessIterator, typename Function>
+    void parallel_for_each(parallel_executor & executor,
+        RandomAccessIterator first, RandomAccessIterator last, Function f)
+    {
+        detail::dynamic_any_parallel::for_each_body<RandomAccessIterator, Function, Types...>
+            body = { first, f };
+        detail::dynamic_any_parallel::run_chunks(executor, first, last, body);
+    }
+
+    template<typename... Types, typename RandomAccessIterator, typename Function>
+    void parallel_for_each(RandomAccessIterator first, RandomAccessIterator last, Function f)
+    {
+        parallel_for_each<Types...>(default_parallel_executor(), first, last, f);
+    }
+
+    // Assigns to out[i] the result of f on the value of first[i], chosen
+    // as by parallel_for_each, or of fallback on first[i] itself when it
+    // holds none of Types; returns the end of out.
+    template<typename... Types, typename RandomAccessIterator, typename OutputIterator,
+             typename Function, typename Fallback>
+    OutputIterator parallel_transform(parallel_executor & executor,
+        RandomAccessIterator first, RandomAccessIterator last, OutputIterator out,
+        Function f, Fallback fallback)
+    {
+        detail::dynamic_any_parallel::transform_body<RandomAccessIterator, OutputIterator,
+            Function, Fallback, Types...> body = { first, out, f, fallback };
+        detail::dynamic_any_parallel::run_chunks(executor, first, last, body);
+        return out + (last - first);
+    }
+
+    template<typename... Types, typename RandomAccessIterator, typename OutputIterator,
+             typename Function, typename Fallback>
+    OutputIterator parallel_transform(RandomAccessIterator first, RandomAccessIterator last,
+        OutputIterator out, Function f, Fallback fallback)
+    {
+        return parallel_transform<Types...>(default_parallel_executor(), first, last, out, f, fallback);
+    }
+
+    // as above, throwing bad_dynamic_any_cast for an element holding none
+    // of Types; elements of other chunks may then be left unassigned
+    template<typename... Types, typename RandomAccessIterator, typename OutputIterator,
+             typename Function>
+    OutputIterator parallel_transform(parallel_executor & executor,
+        RandomAccessIterator first, RandomAccessIterator last, OutputIterator out, Function f)
+    {
+        typedef BOOST_DEDUCED_TYPENAME std::iterator_traits<OutputIterator>::value_type result;
+        return parallel_transform<Types...>(executor, first, last, out, f,
+            detail::dynamic_any_parallel::throw_bad_cast<result>());
+    }
+
+    template<typename... Types, typename RandomAccessIterator, typename OutputIterator,
+             typename Function>
+    OutputIterator parallel_transform(RandomAccessIterator first, RandomAccessIterator last,
+        OutputIterator out, Function f)
+    {
+        return parallel_transform<Types...>(default_parallel_executor(), first, last, out, f);
+    }
+
+    // Combines, with combine, init and the results of transform on the
+    // value of each element holding one of Types, chosen as by
+    // parallel_for_each.  Each chunk starts from the result for its first
+    // such element, and the results of the chunks are combined in order on
+    // the calling thread, after init, which is thus combined exactly once;
+    // combine need be associative but not commutative.
+    template<typename... Types, typename RandomAccessIterator, typename T,
+             typename Transform, typename Combine>
+    T parallel_reduce(parallel_executor & executor,
+        RandomAccessIterator first, RandomAccessIterator last, T init,
+        Transform transform, Combine combine)
+    {
+        std::vector<detail::dynamic_any_parallel::partial<T> > partials(
+            detail::dynamic_any_parallel::chunk_count(first, last));
+        detail::dynamic_any_parallel::reduce_body<RandomAccessIterator, T, Transform, Combine,
+            Types...> body = { first, transform, combine, partials, 0 };
+        detail::dynamic_any_parallel::run_chunks(executor, first, last, body);
+
+        T result = init;
+        for(std::size_t i = 0; i != partials.size(); ++i)
+            if(partials[i].value)
+                result = combine(result, *partials[i].value);
+        return result;
+    }
+
+    template<typename... Types, typename RandomAccessIterator, typename T,
+             typename Transform, typename Combine>
+    T parallel_reduce(RandomAccessIterator first, RandomAccessIterator last, T init,
+        Transform transform, Combine combine)
+    {
+        return parallel_reduce<Types...>(default_parallel_executor(), first, last, init,
+            transform, combine);
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
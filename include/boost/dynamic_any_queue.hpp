@@ -0,0 +1,319 @@
+#ifndef BOOST_DYNAMIC_ANY_QUEUE_INCLUDED
+#define BOOST_DYNAMIC_ANY_QUEUE_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+
+#include <boost/config.hpp>
+#include <boost/core/allocator_access.hpp>
+#include <boost/core/no_exceptions_support.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_HDR_ATOMIC) \
+ || defined(BOOST_NO_CXX11_HDR_THREAD)
+#  error "boost/dynamic_any_queue.hpp requires rvalue references, <atomic> and <thread>"
+#endif
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_queue {
+        const std::size_t cache_line = 64;
+
+        // A cell of the ring: the value, inline in the dynamic_any buffer
+        // when it is small, and the position the cell is ready for.  Cells
+        // start on cache line boundaries and fill whole lines, so that
+        // threads working on neighbouring cells do not contend for one.
+        template<typename Alloc>
+        struct alignas(cache_line) cell
+        {
+            cell(std::size_t position, const Alloc & alloc)
+              : sequence(position), value(alloc)
+            {
+            }
+
+            std::atomic<std::size_t> sequence;
+            boost::basic_dynamic_any<Alloc> value;
+        };
+
+        // a position counter on a cache line of its own, away from the
+        // members that every push and pop reads
+        struct alignas(cache_line) position
+        {
+            std::atomic<std::size_t> value;
+        };
+
+        inline std::size_t round_up_to_power_of_two(std::size_t n)
+        {
+            std::size_t result = 2;
+            while(result < n)
+                result *= 2;
+            return result;
+        }
+    } // namespace dynamic_any_queue
+} // namespace detail
+
+/**
+    @brief a bounded queue of dynamic_any values for many producers and
+    many consumers.
+
+    The queue is a ring of cells, each holding a basic_dynamic_any, so a
+    value small enough for the dynamic_any buffer is moved into its cell
+    and out again without any allocation, and a larger one only has its
+    heap pointer passed along.  Producers and consumers claim cells by
+    compare-and-swap on a position counter each, and every cell carries a
+    sequence number saying whether it is ready to be written or read (after
+    D. Vyukov's bounded MPMC queue), so no locks are taken.  A thread that
+    stalls between claiming a cell and filling or emptying it holds up only
+    the threads that come round to that cell next.
+
+    The cells, and the buffer they live in, use the queue's allocator.  A
+    value whose allocator differs from it is moved over to the queue's
+    allocator before a cell is claimed, and a popped value is moved out of
+    its cell before being handed to the caller's allocator, so that nothing
+    that can throw happens while a cell is claimed.
+*/
+template<typename Alloc = std::allocator<char> >
+class basic_dynamic_any_queue
+{
+    public: // types
+
+        typedef basic_dynamic_any<Alloc> value_type;
+        typedef Alloc allocator_type;
+
+    public: // structors
+
+        // capacity is rounded up to a power of two, and at least two
+        explicit basic_dynamic_any_queue(std::size_t capacity,
+            const allocator_type & alloc = allocator_type())
+          : m_mask(detail::dynamic_any_queue::round_up_to_power_of_two(capacity) - 1)
+          , m_alloc(alloc)
+          , m_storage(boost::allocator_allocate(m_alloc.storage, storage_size()))
+          , m_cells(align(m_storage))
+        {
+            std::size_t constructed = 0;
+            BOOST_TRY
+            {
+                for(; constructed != m_mask + 1; ++constructed)
+                    new(static_cast<void *>(m_cells + constructed)) cell_type(constructed, alloc);
+            }
+            BOOST_CATCH(...)
+            {
+                destroy(constructed);
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+            m_push.value.store(0, std::memory_order_relaxed);
+            m_pop.value.store(0, std::memory_order_relaxed);
+        }
+
+        ~basic_dynamic_any_queue()
+        {
+            destroy(m_mask + 1);
+        }
+
+    public: // modifiers
+
+        // Moves value into the queue and returns true, or returns false,
+        // leaving value as it was, if the queue is full.  A value with
+        // another allocator is moved to the queue's first, and back again
+        // if the queue is full, either of which can throw.
+        bool try_push(value_type && value)
+        {
+            if(!nothrow_transfer::value && !(value.get_allocator() == m_alloc.allocator))
+            {
+                value_type moved(static_cast<value_type &&>(value), m_alloc.allocator);
+                if(claim_and_push(moved))
+                    return true;
+                value = static_cast<value_type &&>(moved);
+                return false;
+            }
+            return claim_and_push(value);
+        }
+
+        // copies value into the queue, unless it is full
+        bool try_push(const value_type & value)
+        {
+            value_type copy(value);
+            return try_push(static_cast<value_type &&>(copy));
+        }
+
+        // Moves the oldest value out of the queue into value and returns
+        // true, or returns false, leaving value as it was, if the queue is
+        // empty.  If value has another allocator, the value popped is moved
+        // over to it once its cell is released; should that throw, the
+        // value popped is lost.
+        bool try_pop(value_type & value)
+        {
+            if(!nothrow_transfer::value && !(value.get_allocator() == m_alloc.allocator))
+            {
+                value_type popped(m_alloc.allocator);
+                if(!claim_and_pop(popped))
+                    return false;
+                value = static_cast<value_type &&>(popped);
+                return true;
+            }
+            return claim_and_pop(value);
+        }
+
+        // as try_push, yielding to other threads until there is room
+        void push(value_type && value)
+        {
+            while(!try_push(static_cast<value_type &&>(value)))
+                std::this_thread::yield();
+        }
+
+        void push(const value_type & value)
+        {
+            value_type copy(value);
+            push(static_cast<value_type &&>(copy));
+        }
+
+        // as try_pop, yielding to other threads until there is a value
+        value_type pop()
+        {
+            value_type value;
+            while(!try_pop(value))
+                std::this_thread::yield();
+            return value;
+        }
+
+    public: // queries
+
+        std::size_t capacity() const BOOST_NOEXCEPT
+        {
+            return m_mask + 1;
+        }
+
+        // Only a snapshot while other threads push or pop.
+        bool empty() const BOOST_NOEXCEPT
+        {
+            return m_pop.value.load(std::memory_order_acquire)
+                == m_push.value.load(std::memory_order_acquire);
+        }
+
+    private: // types
+
+        typedef detail::dynamic_any_queue::cell<Alloc> cell_type;
+        typedef BOOST_DEDUCED_TYPENAME boost::allocator_rebind<Alloc, char>::type storage_allocator;
+
+        // moving a value between two allocators of this type never
+        // allocates, so it cannot throw
+        typedef boost::integral_constant<bool,
+            boost::allocator_propagate_on_container_move_assignment<Alloc>::type::value
+         || boost::allocator_is_always_equal<Alloc>::type::value> nothrow_transfer;
+
+        // the allocator as given, for the cells, and rebound, for the buffer
+        struct allocators
+        {
+            explicit allocators(const Alloc & alloc) : allocator(alloc), storage(alloc) {}
+
+            Alloc allocator;
+            storage_allocator storage;
+        };
+
+    private: // implementation
+
+        // Claims the next cell to write and moves value into it, or returns
+        // false if the queue is full.  The move cannot throw, as value has
+        // the queue's allocator.
+        bool claim_and_push(value_type & value) BOOST_NOEXCEPT
+        {
+            cell_type * c;
+            std::size_t position = m_push.value.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                c = &m_cells[position & m_mask];
+                const std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t lag = std::ptrdiff_t(sequence - position);
+                if(lag == 0)
+                {
+                    if(m_push.value.compare_exchange_weak(position, position + 1,
+                            std::memory_order_relaxed))
+                        break;
+                }
+                else if(lag < 0)
+                    return false;
+                else
+                    position = m_push.value.load(std::memory_order_relaxed);
+            }
+            c->value = static_cast<value_type &&>(value);
+            c->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Claims the oldest cell to read and moves its value into value,
+        // or returns false if the queue is empty.  As for claim_and_push,
+        // value has the queue's allocator.
+        bool claim_and_pop(value_type & value) BOOST_NOEXCEPT
+        {
+            cell_type * c;
+            std::size_t position = m_pop.value.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                c = &m_cells[position & m_mask];
+                const std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t lag = std::ptrdiff_t(sequence - (position + 1));
+                if(lag == 0)
+                {
+                    if(m_pop.value.compare_exchange_weak(position, position + 1,
+                            std::memory_order_relaxed))
+                        break;
+                }
+                else if(lag < 0)
+                    return false;
+                else
+                    position = m_pop.value.load(std::memory_order_relaxed);
+            }
+            value = static_cast<value_type &&>(c->value);
+            c->sequence.store(position + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        std::size_t storage_size() const BOOST_NOEXCEPT
+        {
+            return (m_mask + 1) * sizeof(cell_type) + detail::dynamic_any_queue::cache_line - 1;
+        }
+
+        // allocators need not honour alignments beyond the fundamental
+        // one, so the cells are placed in a buffer with a line to spare
+        static cell_type * align(char * storage) BOOST_NOEXCEPT
+        {
+            const std::size_t line = detail::dynamic_any_queue::cache_line;
+            const std::size_t address = reinterpret_cast<std::size_t>(storage);
+            return reinterpret_cast<cell_type *>((address + line - 1) & ~(line - 1));
+        }
+
+        // destroys the first count cells and frees the buffer
+        void destroy(std::size_t count) BOOST_NOEXCEPT
+        {
+            while(count)
+                m_cells[--count].~cell_type();
+            boost::allocator_deallocate(m_alloc.storage, m_storage, storage_size());
+        }
+
+    private: // representation
+
+        const std::size_t m_mask;
+        allocators m_alloc;
+        char * const m_storage;
+        cell_type * const m_cells;
+        detail::dynamic_any_queue::position m_push, m_pop;
+
+    private: // intentionally left unimplemented
+        basic_dynamic_any_queue(const basic_dynamic_any_queue &);
+        basic_dynamic_any_queue & operator=(const basic_dynamic_any_queue &);
+};
+
+    typedef basic_dynamic_any_queue<> dynamic_any_queue;
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef BOOST_DYNAMIC_ANY_READER_INCLUDED
+#define BOOST_DYNAMIC_ANY_READER_INCLUDED
+
+#include <cstddef>
+#include <limits>
+
+#include <boost/config.hpp>
+#include <boost/any_ref.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/dynamic_any_serialization.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#if defined(BOOST_WINDOWS)
+#  include <windows.h>
+#else
+#  include <sys/stat.h>
+#endif
+
+#if defined(BOOST_HAS_UNISTD_H)
+#  include <sys/mman.h>
+#  if defined(MADV_WILLNEED) && defined(MADV_DONTNEED)
+#    define BOOST_DYNAMIC_ANY_AUX_HAS_MADVISE
+#  endif
+#endif
+
+// Size in bytes of the windows in which a dynamic_any_reader asks for a
+// mapped file to be read ahead of it and releases what lies behind it;
+// the pages of about three windows are resident at a time.
+#ifndef BOOST_DYNAMIC_ANY_READ_AHEAD
+#  define BOOST_DYNAMIC_ANY_READ_AHEAD (4u << 20)
+#endif
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_reader {
+        // the size of the open file behind handle, or false if it cannot
+        // be read
+        inline bool file_size(boost::interprocess::mapping_handle_t handle,
+            boost::interprocess::offset_t & size)
+        {
+#if defined(BOOST_WINDOWS)
+            LARGE_INTEGER result;
+            if(!::GetFileSizeEx(handle.handle, &result))
+                return false;
+            size = result.QuadPart;
+#else
+            struct ::stat status;
+            if(::fstat(handle.handle, &status) != 0)
+                return false;
+            size = status.st_size;
+#endif
+            return true;
+        }
+    } // namespace dynamic_any_reader
+} // namespace detail
+
+/**
+    @brief a read-only memory mapping of a file of encoded dynamic_any records.
+
+    Only the pages being read need to be resident: a dynamic_any_reader over
+    the file asks for the next window to be read ahead and lets the pages it
+    has passed be dropped, so files far larger than memory are read in
+    constant space.
+*/
+class mapped_dynamic_any_file
+{
+    public: // structors
+
+        // Throws boost::interprocess::interprocess_exception if the file
+        // cannot be opened or mapped.
+        explicit mapped_dynamic_any_file(const char * path)
+          : m_file(path, boost::interprocess::read_only)
+        {
+            // an empty file cannot be mapped, and is read as no records
+            boost::interprocess::offset_t size = 0;
+            if(!detail::dynamic_any_reader::file_size(m_file.get_mapping_handle(), size))
+                boost::throw_exception(boost::interprocess::interprocess_exception(
+                    boost::interprocess::error_info(boost::interprocess::system_error_code())));
+            if(size > 0)
+            {
+                boost::interprocess::mapped_region(m_file, boost::interprocess::read_only).swap(m_region);
+                m_region.advise(boost::interprocess::mapped_region::advice_sequential);
+            }
+        }
+
+    public: // queries
+
+        const char * data() const
+        {
+            return static_cast<const char *>(m_region.get_address());
+        }
+
+        std::size_t size() const
+        {
+            return m_region.get_size();
+        }
+
+        // hints that the bytes in [first, last) will be read soon
+        void will_need(std::size_t first, std::size_t last) const
+        {
+#ifdef BOOST_DYNAMIC_ANY_AUX_HAS_MADVISE
+            advise(first, last, MADV_WILLNEED);
+#endif
+        }
+
+        // Hints that the bytes in [first, last) will not be read again.
+        // They stay mapped; touching them again reads them back in.
+        void done_with(std::size_t first, std::size_t last) const
+        {
+#ifdef BOOST_DYNAMIC_ANY_AUX_HAS_MADVISE
+            advise(first, last, MADV_DONTNEED);
+#endif
+        }
+
+    private: // representation
+
+#ifdef BOOST_DYNAMIC_ANY_AUX_HAS_MADVISE
+        // rounds to whole pages, only ever releasing pages entirely within
+        // [first, last)
+        void advise(std::size_t first, std::size_t last, int advice) const
+        {
+            const std::size_t page = boost::interprocess::mapped_region::get_page_size();
+            if(last > size())
+                last = size();
+            first = advice == MADV_DONTNEED ? (first + page - 1) / page * page : first / page * page;
+            if(advice == MADV_DONTNEED)
+                last = last / page * page;
+            if(first < last)
+                ::madvise(const_cast<char *>(data()) + first, last - first, advice);
+        }
+#endif
+
+        boost::interprocess::file_mapping m_file;
+        boost::interprocess::mapped_region m_region;
+};
+
+/**
+    @brief reads encoded dynamic_any records one at a time.
+
+    Nothing is decoded ahead of the caller and nothing is kept behind it:
+    next either decodes the following record into a dynamic_any supplied by
+    the caller, which can be reused so that trivially copyable values are
+    never allocated, or refers an any_ref to it.  Views of trivially copyable
+    values point into the buffer itself; others point to a value the reader
+    decodes into and are valid until the next call.
+*/
+class dynamic_any_reader
+{
+    public: // structors
+
+        // reads the records in [data, data + size)
+        dynamic_any_reader(const dynamic_any_registry & registry, const char * data, std::size_t size)
+          : m_registry(&registry), m_file(0), m_data(data), m_size(size),
+            m_position(0), m_window(std::numeric_limits<std::size_t>::max()), m_released(0)
+        {
+        }
+
+        // reads the records of file, managing which of its pages are resident
+        dynamic_any_reader(const dynamic_any_registry & registry, const mapped_dynamic_any_file & file)
+          : m_registry(&registry), m_file(&file), m_data(file.data()), m_size(file.size()),
+            m_position(0), m_window(0), m_released(0)
+        {
+            page();
+        }
+
+    public: // modifiers
+
+        // Decodes the next record into out; false if there are none left.
+        // Throws bad_dynamic_any_encoding for malformed records.
+        bool next(dynamic_any & out)
+        {
+            if(done())
+                return false;
+            m_position = m_registry->decode(m_data, m_size, m_position, out);
+            if(BOOST_UNLIKELY(m_position >= m_window))
+                page();
+            return true;
+        }
+
+        // Refers out to the next record's value; false if there are none
+        // left.
+        bool next(any_ref & out)
+        {
+            if(done())
+                return false;
+            m_position = m_registry->view(m_data, m_size, m_position, out, m_scratch);
+            if(BOOST_UNLIKELY(m_position >= m_window))
+                page();
+            return true;
+        }
+
+    public: // queries
+
+        bool done() const
+        {
+            return m_position >= m_size;
+        }
+
+        // offset of the next record from the start of the buffer
+        std::size_t position() const
+        {
+            return m_position;
+        }
+
+    private: // representation
+
+        // On entering each window, asks for the next one and releases all
+        // but the one just left.  Readers of a plain buffer never enter
+        // another window.
+        void page()
+        {
+            const std::size_t window = BOOST_DYNAMIC_ANY_READ_AHEAD;
+            const std::size_t current = m_position / window * window;
+            if(current >= window)
+            {
+                m_file->done_with(m_released, current - window);
+                m_released = current - window;
+            }
+            m_file->will_need(current + window, current + 2 * window);
+            m_window = current + window;
+        }
+
+        const dynamic_any_registry * m_registry;
+        const mapped_dynamic_any_file * m_file;
+        const char * m_data;
+        std::size_t m_size;
+        std::size_t m_position;
+        std::size_t m_window;
+        std::size_t m_released;
+        dynamic_any m_scratch;
+};
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef BOOST_DYNAMIC_ANY_SERIALIZATION_INCLUDED
+#define BOOST_DYNAMIC_ANY_SERIALIZATION_INCLUDED
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/any_ref.hpp>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_index.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/type_traits/is_trivially_copyable.hpp>
+
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) \
+ || defined(BOOST_NO_CXX11_HDR_UNORDERED_MAP)
+#  error "boost/dynamic_any_serialization.hpp requires rvalue references, variadic templates and <unordered_map>"
+#endif
+
+namespace boost
+{
+    class bad_dynamic_any_encoding : public std::runtime_error
+    {
+    public:
+        explicit bad_dynamic_any_encoding(const std::string & what)
+          : std::runtime_error("boost::bad_dynamic_any_encoding: " + what)
+        {
+        }
+    };
+
+namespace detail {
+    namespace dynamic_any_serialization {
+        // Codecs deriving from this store ValueType as its bytes, which
+        // lets readers refer to an aligned payload in place.
+        template<typename ValueType>
+        struct bitwise_codec
+        {
+            BOOST_STATIC_ASSERT_MSG(boost::is_trivially_copyable<ValueType>::value,
+                "dynamic_any_codec must be specialized for types that are not trivially copyable");
+
+            static const std::size_t alignment = boost::alignment_of<ValueType>::value;
+
+            // appends the payload for value to out
+            static void save(const ValueType & value, std::vector<char> & out)
+            {
+                const char * bytes = reinterpret_cast<const char *>(&value);
+                out.insert(out.end(), bytes, bytes + sizeof(ValueType));
+            }
+
+            // overwrites value with the size bytes of payload at data
+            static void load(const char * data, std::size_t size, ValueType & value)
+            {
+                if(size != sizeof(ValueType))
+                    boost::throw_exception(bad_dynamic_any_encoding("payload size does not match the type"));
+                std::memcpy(static_cast<void *>(&value), data, sizeof(ValueType));
+            }
+        };
+    } // namespace dynamic_any_serialization
+} // namespace detail
+
+    // How values of ValueType are written to and read back from an encoded
+    // buffer.  Trivially copyable types are stored as their bytes, aligned
+    // for ValueType within the buffer; specialize it for any other type,
+    // giving the payload alignment that load relies on.
+    template<typename ValueType>
+    struct dynamic_any_codec
+      : detail::dynamic_any_serialization::bitwise_codec<ValueType>
+    {
+    };
+
+    template<typename CharT, typename Traits, typename Alloc>
+    struct dynamic_any_codec<std::basic_string<CharT, Traits, Alloc> >
+    {
+        BOOST_STATIC_ASSERT(boost::is_trivially_copyable<CharT>::value);
+
+        static const std::size_t alignment = boost::alignment_of<CharT>::value;
+
+        static void save(const std::basic_string<CharT, Traits, Alloc> & value, std::vector<char> & out)
+        {
+            const char * bytes = reinterpret_cast<const char *>(value.data());
+            out.insert(out.end(), bytes, bytes + value.size() * sizeof(CharT));
+        }
+
+        static void load(const char * data, std::size_t size, std::basic_string<CharT, Traits, Alloc> & value)
+        {
+            if(size % sizeof(CharT) != 0)
+                boost::throw_exception(bad_dynamic_any_encoding("payload size does not match the type"));
+            value.resize(size / sizeof(CharT));
+            if(size)
+                std::memcpy(&value[0], data, size);
+        }
+    };
+
+namespace detail {
+    namespace dynamic_any_serialization {
+        // Every record starts with this header, at a multiple of its
+        // alignment from the start of the buffer.  The payload follows,
+        // padded to its codec's alignment, again counted from the start
+        // of the buffer.  Id 0 with no payload stands for an empty
+        // dynamic_any.
+        struct record_header
+        {
+            boost::uint32_t id;
+            boost::uint32_t size;
+        };
+
+        const std::size_t header_alignment = boost::alignment_of<record_header>::value;
+
+        // alignments are powers of two
+        inline std::size_t align(std::size_t position, std::size_t alignment)
+        {
+            return (position + alignment - 1) & ~(alignment - 1);
+        }
+
+        struct codec_ops
+        {
+            boost::uint32_t id;
+            std::size_t alignment;
+            std::size_t size;
+            const boost::typeindex::type_info & (*type)();
+            void (*save)(const boost::dynamic_any & value, std::vector<char> & out);
+            void (*load)(const char * data, std::size_t size, boost::dynamic_any & out);
+            // whether the payload is the value's bytes, so that it can be
+            // referred to in place
+            bool bitwise;
+            // the any_ref token of a const value, so that views are made
+            // without a call per record
+            const boost::detail::any_ref::type_token * token;
+        };
+
+        template<typename ValueType>
+        struct ops_of
+        {
+            static void save(const boost::dynamic_any & value, std::vector<char> & out)
+            {
+                dynamic_any_codec<ValueType>::save(*dynamic_any_cast<ValueType>(&value), out);
+            }
+
+            // A value already of exactly this type is overwritten in
+            // place, so decoding a stream into the same dynamic_any only
+            // allocates when the held type changes.
+            static void load(const char * data, std::size_t size, boost::dynamic_any & out)
+            {
+                ValueType * value = boost::detail::dynamic_any::same_type(
+                        out.type(), boost::detail::dynamic_any::type_of<ValueType>())
+                    ? dynamic_any_cast<ValueType>(&out)
+                    : &out.emplace<ValueType>();
+                dynamic_any_codec<ValueType>::load(data, size, *value);
+            }
+
+            static const codec_ops table;
+        };
+
+        template<typename ValueType>
+        const codec_ops ops_of<ValueType>::table =
+        {
+            0,
+            dynamic_any_codec<ValueType>::alignment,
+            sizeof(ValueType),
+            &boost::detail::dynamic_any::type_of<ValueType>,
+            &ops_of<ValueType>::save,
+            &ops_of<ValueType>::load,
+            boost::is_base_of<bitwise_codec<ValueType>, dynamic_any_codec<ValueType> >::value,
+            &boost::detail::any_ref::tokens<ValueType>::const_ref
+        };
+
+        // Small ids, the common case, are looked up by index.
+        const boost::uint32_t dense_ids = 1024;
+    } // namespace dynamic_any_serialization
+} // namespace detail
+
+/**
+    @brief maps held types to stable numeric ids and encodes dynamic_any values with them.
+
+    Each type a dynamic_any may hold when it is encoded or decoded is added
+    once, under an id that stays the same across builds and processes.  A
+    record is the id, the payload size and the payload written by the type's
+    dynamic_any_codec.  The encoding uses the byte order and layout of the
+    machine, so that trivially copyable values are decoded with a single copy
+    from the buffer, or read in place where it is suitably aligned.
+
+    A registry is set up before use; after that, any number of threads may
+    encode and decode with it concurrently.
+*/
+class dynamic_any_registry
+{
+    public: // modifiers
+
+        // Registers ValueType, which must be default constructible, under
+        // id, which must not be 0.
+        template<typename ValueType>
+        void add(boost::uint32_t id)
+        {
+            if(id == 0)
+                boost::throw_exception(bad_dynamic_any_encoding("id 0 is reserved for the empty value"));
+            if(m_ids.count(id))
+                boost::throw_exception(bad_dynamic_any_encoding("id registered twice"));
+
+            codec_ops ops = detail::dynamic_any_serialization::ops_of<ValueType>::table;
+            ops.id = id;
+            if(!m_types.insert(std::make_pair(boost::typeindex::type_index(ops.type()), ops)).second)
+                boost::throw_exception(bad_dynamic_any_encoding("type registered twice"));
+            m_ids.insert(std::make_pair(id, ops));
+            if(id < detail::dynamic_any_serialization::dense_ids)
+            {
+                if(m_dense.size() <= id)
+                    m_dense.resize(id + 1, codec_ops());
+                m_dense[id] = ops;
+            }
+        }
+
+    public: // queries
+
+        // the id of type, or 0 if it has not been added
+        boost::uint32_t id_of(const boost::typeindex::type_info & type) const
+        {
+            types_map::const_iterator found = m_types.find(boost::typeindex::type_index(type));
+            return found == m_types.end() ? 0 : found->second.id;
+        }
+
+        // Appends the record for value to out, which holds the records
+        // encoded before it.  Throws bad_dynamic_any_encoding, leaving out
+        // as it was, if the held type has not been added or its payload
+        // does not fit the 32-bit size of a record.
+        void encode(const dynamic_any & value, std::vector<char> & out) const
+        {
+            using namespace detail::dynamic_any_serialization;
+
+            const std::size_t before = out.size();
+            const std::size_t start = align(out.size(), header_alignment);
+            record_header header = { 0, 0 };
+            if(value.empty())
+            {
+                out.resize(start + sizeof header);
+                std::memcpy(&out[start], &header, sizeof header);
+                return;
+            }
+
+            types_map::const_iterator found = m_types.find(boost::typeindex::type_index(value.type()));
+            if(found == m_types.end())
+                boost::throw_exception(bad_dynamic_any_encoding(
+                    std::string("type not registered: ") + boost::typeindex::type_index(value.type()).pretty_name()));
+            const codec_ops & ops = found->second;
+
+            const std::size_t payload = align(start + sizeof header, ops.alignment);
+            out.resize(payload);
+            ops.save(value, out);
+
+            if(out.size() - payload > (std::numeric_limits<boost::uint32_t>::max)())
+            {
+                out.resize(before);
+                boost::throw_exception(bad_dynamic_any_encoding("payload larger than 4 GiB"));
+            }
+            header.id = ops.id;
+            header.size = static_cast<boost::uint32_t>(out.size() - payload);
+            std::memcpy(&out[start], &header, sizeof header);
+        }
+
+        // Decodes the record at position in the encoded buffer
+        // [data, data + size) into out and returns the position of the
+        // next record.  Throws bad_dynamic_any_encoding for unknown ids
+        // and truncated records.
+        std::size_t decode(const char * data, std::size_t size, std::size_t position,
+            dynamic_any & out) const
+        {
+            const record r = locate(data, size, position);
+            if(r.ops)
+                r.ops->load(data + r.payload, r.size, out);
+            else
+                out.clear();
+            return r.payload + r.size;
+        }
+
+        // Like decode, but refers out to the value instead of copying it
+        // where possible: a trivially copyable value whose payload is
+        // aligned in memory is referred to in place in the buffer.  Other
+        // values are decoded into scratch, and out refers to that.  An
+        // empty record gives an empty any_ref.
+        std::size_t view(const char * data, std::size_t size, std::size_t position,
+            any_ref & out, dynamic_any & scratch) const
+        {
+            typedef detail::any_ref::access any_ref_access;
+
+            const record r = locate(data, size, position);
+            if(!r.ops)
+                out = any_ref();
+            else if(r.ops->bitwise && r.size == r.ops->size
+                 && (reinterpret_cast<std::size_t>(data + r.payload) & (r.ops->alignment - 1)) == 0)
+                out = any_ref_access::refer(const_cast<char *>(data + r.payload), r.ops->token);
+            else
+            {
+                r.ops->load(data + r.payload, r.size, scratch);
+                out = any_ref_access::refer(detail::dynamic_any::access::value(scratch), r.ops->token);
+            }
+            return r.payload + r.size;
+        }
+
+    private: // representation
+
+        typedef detail::dynamic_any_serialization::codec_ops codec_ops;
+        typedef std::unordered_map<boost::typeindex::type_index, codec_ops,
+            boost::hash<boost::typeindex::type_index> > types_map;
+        typedef std::unordered_map<boost::uint32_t, codec_ops> ids_map;
+
+        // a record's codec (null if it is empty) and where its payload is
+        struct record
+        {
+            const codec_ops * ops;
+            std::size_t payload;
+            std::size_t size;
+        };
+
+        record locate(const char * data, std::size_t size, std::size_t position) const
+        {
+            using namespace detail::dynamic_any_serialization;
+
+            const std::size_t start = align(position, header_alignment);
+            if(start > size || size - start < sizeof(record_header))
+                boost::throw_exception(bad_dynamic_any_encoding("truncated record header"));
+            record_header header;
+            std::memcpy(&header, data + start, sizeof header);
+
+            record r = { 0, start + sizeof header, 0 };
+            if(header.id == 0)
+                return r;
+
+            if(header.id < m_dense.size() && m_dense[header.id].id)
+                r.ops = &m_dense[header.id];
+            else
+            {
+                ids_map::const_iterator found = m_ids.find(header.id);
+                if(found == m_ids.end())
+                    boost::throw_exception(bad_dynamic_any_encoding("unknown type id"));
+                r.ops = &found->second;
+            }
+
+            r.payload = align(r.payload, r.ops->alignment);
+            r.size = header.size;
+            if(r.payload > size || size - r.payload < r.size)
+                boost::throw_exception(bad_dynamic_any_encoding("truncated record payload"));
+            return r;
+        }
+
+        types_map m_types;
+        ids_map m_ids;
+        std::vector<codec_ops> m_dense;
+};
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef BOOST_DYNAMIC_ANY_STATS_INCLUDED
+#define BOOST_DYNAMIC_ANY_STATS_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/type_index.hpp>
+
+#if defined(BOOST_NO_CXX11_THREAD_LOCAL) || defined(BOOST_NO_CXX11_HDR_ATOMIC) \
+ || defined(BOOST_NO_CXX11_HDR_MUTEX)
+#  error "boost/dynamic_any_stats.hpp requires thread_local, <atomic> and <mutex>"
+#endif
+
+// Counting is compiled in only where BOOST_DYNAMIC_ANY_STATS is defined
+// before boost/dynamic_any.hpp is first included, and must then be defined
+// the same way in every translation unit.  Without it dynamic_any_stats()
+// returns an empty snapshot.
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_stats {
+        enum event
+        {
+            clones,
+            allocations,
+            casts,
+            failed_casts,
+            base_casts,
+            event_count
+        };
+
+        // One thread's counts for one held type.  Only the owning thread
+        // writes them, with a relaxed load and store rather than a
+        // read-modify-write, which costs the same as a plain increment
+        // while letting other threads read them safely.
+        struct counters
+        {
+            const boost::typeindex::type_info * type;
+            std::atomic<boost::uint64_t> events[event_count];
+        };
+
+        inline void count(counters & c, event e)
+        {
+            c.events[e].store(c.events[e].load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        }
+
+        typedef std::map<boost::typeindex::type_index, std::vector<boost::uint64_t> > totals_type;
+
+        inline void add(totals_type & totals, const counters & c)
+        {
+            std::vector<boost::uint64_t> & sums = totals[boost::typeindex::type_index(*c.type)];
+            sums.resize(event_count);
+            for(int e = 0; e != event_count; ++e)
+                sums[e] += c.events[e].load(std::memory_order_relaxed);
+        }
+
+        // The counters of every live thread, and the totals of threads
+        // that have exited.
+        class registry
+        {
+        public:
+            static registry & instance()
+            {
+                static registry * const r = new registry; // outlives every thread
+                return *r;
+            }
+
+            void enroll(std::vector<counters *> & thread, counters & c)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(thread.empty())
+                    m_threads.push_back(&thread);
+                thread.push_back(&c);
+            }
+
+            void retire(std::vector<counters *> & thread)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for(std::size_t i = 0; i != thread.size(); ++i)
+                    add(m_retired, *thread[i]);
+                for(std::size_t i = 0; i != m_threads.size(); ++i)
+                    if(m_threads[i] == &thread)
+                    {
+                        m_threads[i] = m_threads.back();
+                        m_threads.pop_back();
+                        break;
+                    }
+            }
+
+            totals_type totals()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                totals_type result = m_retired;
+                for(std::size_t i = 0; i != m_threads.size(); ++i)
+                    for(std::size_t j = 0; j != m_threads[i]->size(); ++j)
+                        add(result, *(*m_threads[i])[j]);
+                return result;
+            }
+
+        private:
+            std::mutex m_mutex;
+            std::vector<std::vector<counters *> *> m_threads;
+            totals_type m_retired;
+        };
+
+        // the counters this thread has enrolled, folded into the retired
+        // totals when it exits
+        struct thread_counters
+        {
+            std::vector<counters *> enrolled;
+
+            ~thread_counters()
+            {
+                registry::instance().retire(enrolled);
+                exited() = true;
+            }
+
+            // Set once thread_counters is gone; events after that, from
+            // other thread_local destructors, are not counted.
+            static bool & exited()
+            {
+                static thread_local bool value;
+                return value;
+            }
+        };
+
+        BOOST_NOINLINE inline void enroll(counters & c, const boost::typeindex::type_info & type)
+        {
+            c.type = &type;
+            if(thread_counters::exited())
+                return;
+            static thread_local thread_counters thread;
+            registry::instance().enroll(thread.enrolled, c);
+        }
+
+        // Zero-initialized and trivially destructible, so a thread reaches
+        // its own copy without any thread_local initialization check.
+        template<typename ValueType>
+        struct counters_of
+        {
+            static thread_local counters value;
+        };
+
+        template<typename ValueType>
+        thread_local counters counters_of<ValueType>::value;
+
+        template<typename ValueType>
+        inline counters & counters_for()
+        {
+            counters & c = counters_of<ValueType>::value;
+            if(BOOST_UNLIKELY(!c.type))
+                enroll(c, boost::typeindex::type_id<ValueType>().type_info());
+            return c;
+        }
+
+        inline void write_string(std::ostream & out, const std::string & s)
+        {
+            static const char hex[] = "0123456789abcdef";
+            out << '"';
+            for(std::size_t i = 0; i != s.size(); ++i)
+            {
+                const unsigned char c = s[i];
+                if(c == '"' || c == '\\')
+                    out << '\\' << c;
+                else if(c < 0x20)
+                    out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+                else
+                    out << c;
+            }
+            out << '"';
+        }
+    } // namespace dynamic_any_stats
+} // namespace detail
+
+    // What dynamic_any did with values of one held type, summed over all
+    // threads.  casts counts every successful dynamic_any_cast, of which
+    // base_casts reached a base class rather than the held type itself.
+    struct dynamic_any_type_stats
+    {
+        std::string type;
+        boost::uint64_t clones;
+        boost::uint64_t allocations;
+        boost::uint64_t casts;
+        boost::uint64_t failed_casts;
+        boost::uint64_t base_casts;
+    };
+
+    struct dynamic_any_stats_snapshot
+    {
+        std::vector<dynamic_any_type_stats> types;
+
+        // {"types":[{"type":"int","clones":0,...},...]}
+        void write_json(std::ostream & out) const
+        {
+            out << "{\"types\":[";
+            for(std::size_t i = 0; i != types.size(); ++i)
+            {
+                const dynamic_any_type_stats & t = types[i];
+                out << (i ? ",{" : "{") << "\"type\":";
+                detail::dynamic_any_stats::write_string(out, t.type);
+                out << ",\"clones\":" << t.clones
+                    << ",\"allocations\":" << t.allocations
+                    << ",\"casts\":" << t.casts
+                    << ",\"failed_casts\":" << t.failed_casts
+                    << ",\"base_casts\":" << t.base_casts << '}';
+            }
+            out << "]}";
+        }
+
+        std::string json() const
+        {
+            std::ostringstream out;
+            write_json(out);
+            return out.str();
+        }
+    };
+
+    // Sums the counts of every thread, live or exited, at the time of the
+    // call.  Counts still being made by other threads may or may not be
+    // included.
+    inline dynamic_any_stats_snapshot dynamic_any_stats()
+    {
+        using namespace detail::dynamic_any_stats;
+
+        const totals_type totals = registry::instance().totals();
+        dynamic_any_stats_snapshot snapshot;
+        for(totals_type::const_iterator i = totals.begin(); i != totals.end(); ++i)
+        {
+            const dynamic_any_type_stats t =
+            {
+                i->first.pretty_name(),
+                i->second[clones],
+                i->second[allocations],
+                i->second[casts],
+                i->second[failed_casts],
+                i->second[base_casts]
+            };
+            snapshot.types.push_back(t);
+        }
+        return snapshot;
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
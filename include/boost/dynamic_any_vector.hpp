@@ -0,0 +1,466 @@
+#ifndef BOOST_DYNAMIC_ANY_VECTOR_INCLUDED
+#define BOOST_DYNAMIC_ANY_VECTOR_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/assert.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/core/no_exceptions_support.hpp>
+#include <boost/move/utility.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <boost/type_traits/is_reference.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#  error "boost/dynamic_any_vector.hpp requires rvalue references and variadic templates"
+#endif
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_vector {
+        typedef boost::detail::dynamic_any::access access;
+        typedef access::types<std::allocator<char> > types;
+        typedef types::vtable vtable;
+
+        // The vector keeps its values as a plain dynamic_any would, so they
+        // are cast exactly as they would be there; this table adds what the
+        // vector itself needs to lay them out and move them.
+        struct element_ops
+        {
+            std::size_t size;
+            std::size_t align;
+            const boost::typeindex::type_info & (*type)();
+            const vtable * table;
+            void (*copy)(const void * from, void * to);
+            // constructs a copy of from at to, moving when that cannot throw
+            void (*relocate)(void * from, void * to);
+            void (*destroy)(void * value);
+        };
+
+        template<typename ValueType>
+        struct ops_of
+        {
+            static void copy(const void * from, void * to)
+            {
+                new(to) ValueType(*static_cast<const ValueType *>(from));
+            }
+
+            static void relocate(void * from, void * to)
+            {
+                new(to) ValueType(boost::move_if_noexcept(*static_cast<ValueType *>(from)));
+            }
+
+            static void destroy(void * value)
+            {
+                static_cast<ValueType *>(value)->~ValueType();
+            }
+
+            static const element_ops table;
+        };
+
+        template<typename ValueType>
+        const element_ops ops_of<ValueType>::table =
+        {
+            sizeof(ValueType),
+            boost::alignment_of<ValueType>::value,
+            &detail::dynamic_any::type_of<ValueType>,
+            &types::vtable_of<ValueType>::type::table,
+            &ops_of<ValueType>::copy,
+            &ops_of<ValueType>::relocate,
+            &ops_of<ValueType>::destroy
+        };
+
+        inline std::size_t blocks(std::size_t bytes)
+        {
+            return (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        }
+
+        // storage suitably aligned for any value
+        inline std::max_align_t * allocate(std::size_t bytes)
+        {
+            return std::allocator<std::max_align_t>().allocate(blocks(bytes));
+        }
+
+        inline void deallocate(std::max_align_t * storage, std::size_t bytes)
+        {
+            if(storage)
+                std::allocator<std::max_align_t>().deallocate(storage, blocks(bytes));
+        }
+
+        struct element
+        {
+            std::size_t         offset;
+            const element_ops * ops;
+        };
+    } // namespace dynamic_any_vector
+} // namespace detail
+
+/**
+    @brief a sequence of values of any copyable type, stored back to back.
+
+    A std::vector<dynamic_any> holds every value that does not fit the inline
+    buffer in its own heap block.  dynamic_any_vector instead places each value
+    in a single growable buffer, and keeps the offset and type of every element
+    in a parallel array, so walking the elements reads memory in order.
+
+    Elements are reached through the indexed forms of dynamic_any_cast, which
+    accept the held type or any of its bases just like a dynamic_any does, or
+    visited with for_each<T>.  Growing the buffer moves the held values, so
+    pointers and references to elements are invalidated by push_back and
+    emplace_back as they are for std::vector.
+*/
+class dynamic_any_vector
+{
+    public: // types
+
+        typedef std::size_t size_type;
+
+    public: // structors
+
+        dynamic_any_vector() BOOST_NOEXCEPT
+          : m_storage(0), m_used(0), m_capacity(0)
+        {
+        }
+
+        dynamic_any_vector(const dynamic_any_vector & other)
+          : m_elements(other.m_elements), m_storage(0), m_used(0), m_capacity(0)
+        {
+            if(other.m_used == 0)
+                return;
+
+            m_storage = detail::dynamic_any_vector::allocate(other.m_used);
+            size_type i = 0;
+            BOOST_TRY
+            {
+                for(; i != m_elements.size(); ++i)
+                    m_elements[i].ops->copy(other.at(i), at(i));
+            }
+            BOOST_CATCH(...)
+            {
+                destroy(0, i);
+                detail::dynamic_any_vector::deallocate(m_storage, other.m_used);
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+            m_used = m_capacity = other.m_used;
+        }
+
+        dynamic_any_vector(dynamic_any_vector && other) BOOST_NOEXCEPT
+          : m_storage(0), m_used(0), m_capacity(0)
+        {
+            swap(other);
+        }
+
+        ~dynamic_any_vector()
+        {
+            clear();
+            detail::dynamic_any_vector::deallocate(m_storage, m_capacity);
+        }
+
+    public: // modifiers
+
+        dynamic_any_vector & swap(dynamic_any_vector & rhs) BOOST_NOEXCEPT
+        {
+            m_elements.swap(rhs.m_elements);
+            std::swap(m_storage, rhs.m_storage);
+            std::swap(m_used, rhs.m_used);
+            std::swap(m_capacity, rhs.m_capacity);
+            return *this;
+        }
+
+        dynamic_any_vector & operator=(const dynamic_any_vector & rhs)
+        {
+            dynamic_any_vector(rhs).swap(*this);
+            return *this;
+        }
+
+        dynamic_any_vector & operator=(dynamic_any_vector && rhs) BOOST_NOEXCEPT
+        {
+            rhs.swap(*this);
+            dynamic_any_vector().swap(rhs);
+            return *this;
+        }
+
+        template<typename ValueType>
+        void push_back(ValueType && value)
+        {
+            emplace_back<BOOST_DEDUCED_TYPENAME decay<ValueType>::type>(
+                static_cast<ValueType &&>(value));
+        }
+
+        // constructs a ValueType from args at the end of the sequence
+        template<typename ValueType, typename... Args>
+        ValueType & emplace_back(Args &&... args)
+        {
+            const detail::dynamic_any_vector::element_ops & ops =
+                detail::dynamic_any_vector::ops_of<ValueType>::table;
+
+            BOOST_STATIC_ASSERT(boost::alignment_of<ValueType>::value
+                <= boost::alignment_of<std::max_align_t>::value);
+
+            const size_type offset = (m_used + ops.align - 1) & ~(ops.align - 1);
+            const detail::dynamic_any_vector::element e = { offset, &ops };
+            m_elements.push_back(e);
+            ValueType * result;
+            BOOST_TRY
+            {
+                if(offset + ops.size > m_capacity)
+                    result = grow_with<ValueType>(offset + ops.size, static_cast<Args &&>(args)...);
+                else
+                    result = new(storage() + offset) ValueType(static_cast<Args &&>(args)...);
+            }
+            BOOST_CATCH(...)
+            {
+                m_elements.pop_back();
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+            m_used = offset + ops.size;
+            return *result;
+        }
+
+        void pop_back()
+        {
+            BOOST_ASSERT(!empty());
+            const detail::dynamic_any_vector::element e = m_elements.back();
+            e.ops->destroy(storage() + e.offset);
+            m_elements.pop_back();
+            m_used = e.offset;
+        }
+
+        void clear() BOOST_NOEXCEPT
+        {
+            destroy(0, m_elements.size());
+            m_elements.clear();
+            m_used = 0;
+        }
+
+        // makes room for count elements taking bytes of storage in total
+        void reserve(size_type count, size_type bytes)
+        {
+            m_elements.reserve(count);
+            if(bytes > m_capacity)
+                grow(bytes);
+        }
+
+    public: // queries
+
+        bool empty() const BOOST_NOEXCEPT
+        {
+            return m_elements.empty();
+        }
+
+        size_type size() const BOOST_NOEXCEPT
+        {
+            return m_elements.size();
+        }
+
+        // bytes of the buffer taken by the elements, including padding
+        size_type storage_size() const BOOST_NOEXCEPT
+        {
+            return m_used;
+        }
+
+        size_type storage_capacity() const BOOST_NOEXCEPT
+        {
+            return m_capacity;
+        }
+
+        const boost::typeindex::type_info & type(size_type index) const
+        {
+            BOOST_ASSERT(index < m_elements.size());
+            return m_elements[index].ops->type();
+        }
+
+        // calls f with every element that can be cast to ValueType, in order
+        template<typename ValueType, typename F>
+        void for_each(F f)
+        {
+            for(size_type i = 0; i != m_elements.size(); ++i)
+                if(ValueType * value = cast<ValueType>(i))
+                    f(*value);
+        }
+
+        template<typename ValueType, typename F>
+        void for_each(F f) const
+        {
+            for(size_type i = 0; i != m_elements.size(); ++i)
+                if(const ValueType * value = cast<const ValueType>(i))
+                    f(*value);
+        }
+
+    private: // representation
+
+        template<typename ValueType>
+        friend ValueType * dynamic_any_cast(dynamic_any_vector *, size_type);
+
+        template<typename ValueType>
+        ValueType * cast(size_type index) const
+        {
+            BOOST_ASSERT(index < m_elements.size());
+            return detail::dynamic_any_vector::access::
+                cast<ValueType, std::allocator<char> >(m_elements[index].ops->table, at(index));
+        }
+
+        void * at(size_type index) const
+        {
+            return storage() + m_elements[index].offset;
+        }
+
+        char * storage() const
+        {
+            return reinterpret_cast<char *>(m_storage);
+        }
+
+        void destroy(size_type first, size_type last) BOOST_NOEXCEPT
+        {
+            for(; first != last; ++first)
+                m_elements[first].ops->destroy(at(first));
+        }
+
+        static size_type next_capacity(size_type bytes, size_type capacity)
+        {
+            return bytes > 2 * capacity ? bytes : 2 * capacity;
+        }
+
+        // Moves every element to a buffer of at least bytes; the elements
+        // keep their offsets, as the new buffer is aligned alike.
+        void grow(size_type bytes)
+        {
+            const size_type capacity = next_capacity(bytes, m_capacity);
+            std::max_align_t * storage = detail::dynamic_any_vector::allocate(capacity);
+            BOOST_TRY
+            {
+                relocate(storage, m_elements.size());
+            }
+            BOOST_CATCH(...)
+            {
+                detail::dynamic_any_vector::deallocate(storage, capacity);
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+            destroy(0, m_elements.size());
+            adopt(storage, capacity);
+        }
+
+        // As grow, for the last element, which is not built yet: it is
+        // constructed in the new buffer before the others move out of the
+        // old one, so args may refer to an element of this vector.
+        template<typename ValueType, typename... Args>
+        ValueType * grow_with(size_type bytes, Args &&... args)
+        {
+            const size_type capacity = next_capacity(bytes, m_capacity);
+            std::max_align_t * storage = detail::dynamic_any_vector::allocate(capacity);
+            ValueType * result;
+            BOOST_TRY
+            {
+                result = new(reinterpret_cast<char *>(storage) + m_elements.back().offset)
+                    ValueType(static_cast<Args &&>(args)...);
+                BOOST_TRY
+                {
+                    relocate(storage, m_elements.size() - 1);
+                }
+                BOOST_CATCH(...)
+                {
+                    result->~ValueType();
+                    BOOST_RETHROW
+                }
+                BOOST_CATCH_END
+            }
+            BOOST_CATCH(...)
+            {
+                detail::dynamic_any_vector::deallocate(storage, capacity);
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+            destroy(0, m_elements.size() - 1);
+            adopt(storage, capacity);
+            return result;
+        }
+
+        // Constructs the first count elements at their offsets in storage,
+        // leaving the old buffer as it was if one of them throws.
+        void relocate(std::max_align_t * storage, size_type count)
+        {
+            char * to = reinterpret_cast<char *>(storage);
+            size_type i = 0;
+            BOOST_TRY
+            {
+                for(; i != count; ++i)
+                    m_elements[i].ops->relocate(at(i), to + m_elements[i].offset);
+            }
+            BOOST_CATCH(...)
+            {
+                while(i--)
+                    m_elements[i].ops->destroy(to + m_elements[i].offset);
+                BOOST_RETHROW
+            }
+            BOOST_CATCH_END
+        }
+
+        // Replaces the buffer, whose elements are already destroyed.
+        void adopt(std::max_align_t * storage, size_type capacity) BOOST_NOEXCEPT
+        {
+            detail::dynamic_any_vector::deallocate(m_storage, m_capacity);
+            m_storage = storage;
+            m_capacity = capacity;
+        }
+
+        std::vector<detail::dynamic_any_vector::element> m_elements;
+        std::max_align_t * m_storage;
+        size_type m_used;
+        size_type m_capacity;
+};
+
+    inline void swap(dynamic_any_vector & lhs, dynamic_any_vector & rhs) BOOST_NOEXCEPT
+    {
+        lhs.swap(rhs);
+    }
+
+    // the element at index as a ValueType (the held type or one of its
+    // bases), or null if it is neither
+    template<typename ValueType>
+    ValueType * dynamic_any_cast(dynamic_any_vector * operand, std::size_t index)
+    {
+        return operand->cast<ValueType>(index);
+    }
+
+    template<typename ValueType>
+    inline const ValueType * dynamic_any_cast(const dynamic_any_vector * operand, std::size_t index)
+    {
+        return dynamic_any_cast<const ValueType>(const_cast<dynamic_any_vector *>(operand), index);
+    }
+
+    template<typename ValueType>
+    ValueType dynamic_any_cast(dynamic_any_vector & operand, std::size_t index)
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        nonref * result = dynamic_any_cast<nonref>(&operand, index);
+        if(!result)
+            boost::throw_exception(bad_dynamic_any_cast());
+        return *result;
+    }
+
+    template<typename ValueType>
+    inline ValueType dynamic_any_cast(const dynamic_any_vector & operand, std::size_t index)
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        return dynamic_any_cast<const nonref &>(const_cast<dynamic_any_vector &>(operand), index);
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
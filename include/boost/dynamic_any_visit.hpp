@@ -0,0 +1,195 @@
+#ifndef BOOST_DYNAMIC_ANY_VISIT_INCLUDED
+#define BOOST_DYNAMIC_ANY_VISIT_INCLUDED
+
+#include <cstddef>
+#include <utility>
+
+#include <boost/config.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+
+#if defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) || defined(BOOST_NO_CXX11_DECLTYPE)
+#  error "boost/dynamic_any_visit.hpp requires variadic templates and decltype"
+#endif
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_any_visit {
+        typedef boost::detail::dynamic_any::access access;
+
+        // names the cache of dispatch indices of one list of alternatives
+        template<typename... Types>
+        struct alternatives
+        {
+        };
+
+        // has no type when Visitor cannot take a First, so that visiting a
+        // non-const operand does not trip over the const overloads
+        template<typename Visitor, typename First, typename = void>
+        struct result_of_call
+        {
+        };
+
+        template<typename Visitor, typename First>
+        struct result_of_call<Visitor, First,
+            decltype(void(std::declval<Visitor &>()(std::declval<First &>())))>
+        {
+            typedef decltype(std::declval<Visitor &>()(std::declval<First &>())) type;
+        };
+
+        template<typename Visitor, typename First, typename...>
+        struct result : result_of_call<Visitor, First>
+        {
+        };
+
+        // the address of the held value as a ValueType, or null
+        template<typename Alloc, typename ValueType>
+        void * probe(const BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable * table, void * held)
+        {
+            return access::cast<ValueType, Alloc>(table, held);
+        }
+
+        // index of the first of Types the held value can be cast to, or
+        // sizeof...(Types) if there is none; value is set to its address
+        template<typename Alloc, typename... Types>
+        std::size_t find(const BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable * table,
+            void * held, void * & value)
+        {
+            typedef void * (*probe_type)(
+                const BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable *, void *);
+            static const probe_type probes[] = { &probe<Alloc, Types>... };
+
+            std::size_t i = 0;
+            for(; i != sizeof...(Types); ++i)
+                if((value = probes[i](table, held)) != 0)
+                    break;
+            return i;
+        }
+
+#ifndef BOOST_DYNAMIC_ANY_NO_CAST_CACHE
+        struct dispatch_slot
+        {
+            const void *   key;
+            std::size_t    index;
+            std::ptrdiff_t offset;
+        };
+#endif
+
+        template<typename Alloc, typename... Types>
+        std::size_t index(const BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable * table,
+            void * held, void * & value)
+        {
+            if(!table)
+                return sizeof...(Types);
+#ifdef BOOST_DYNAMIC_ANY_NO_CAST_CACHE
+            return find<Alloc, Types...>(table, held, value);
+#else
+            // Which alternative matches first, and where the value is
+            // found as that type, depend only on the held type; both are
+            // kept in the same kind of cache as base-class offsets.
+            typedef detail::dynamic_any::cast_cache<alternatives<Types...>,
+                BOOST_DEDUCED_TYPENAME access::types<Alloc>::vtable, dispatch_slot> cache;
+
+            const void * key = &table->type();
+            dispatch_slot & slot = cache::slot(key);
+            if(slot.key != key && !cache::fetch(slot, key))
+            {
+                slot.index = find<Alloc, Types...>(table, held, value);
+                slot.offset = slot.index != sizeof...(Types)
+                    ? static_cast<char *>(value) - static_cast<char *>(held)
+                    : 0;
+                slot.key = key;
+                cache::publish(slot);
+                return slot.index;
+            }
+            value = static_cast<char *>(held) + slot.offset;
+            return slot.index;
+#endif
+        }
+
+        template<typename R, typename Visitor, typename ValueType>
+        R call(void * value, Visitor & visitor)
+        {
+            return visitor(*static_cast<ValueType *>(value));
+        }
+
+        template<typename R, typename Alloc, typename Operand, typename Visitor,
+                 typename Fallback, typename... Types>
+        R dispatch(Operand & operand, Visitor & visitor, Fallback & fallback)
+        {
+            typedef R (*call_type)(void *, Visitor &);
+            static const call_type calls[] = { &call<R, Visitor, Types>... };
+
+            void * value = 0;
+            const std::size_t i = index<Alloc, BOOST_DEDUCED_TYPENAME remove_cv<Types>::type...>(
+                access::table(operand), access::value(operand), value);
+            return i != sizeof...(Types) ? calls[i](value, visitor) : fallback(operand);
+        }
+
+        template<typename R>
+        struct throw_bad_cast
+        {
+            template<typename Operand>
+            R operator()(Operand &) const
+            {
+                boost::throw_exception(bad_dynamic_any_cast());
+            }
+        };
+    } // namespace dynamic_any_visit
+} // namespace detail
+
+    // Calls visitor with the value held by operand, cast to the first of
+    // Types that dynamic_any_cast would accept for it, so a class value is
+    // also passed as any of its bases.  The choice is made once per held
+    // type and then dispatched through a table, instead of trying each
+    // alternative in turn for every value.  When none of Types match, or
+    // operand is empty, fallback is called with operand.
+    template<typename... Types, typename Alloc, typename Visitor, typename Fallback>
+    BOOST_DEDUCED_TYPENAME detail::dynamic_any_visit::result<Visitor, Types...>::type
+    visit(basic_dynamic_any<Alloc> & operand, Visitor && visitor, Fallback && fallback)
+    {
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_visit::result<Visitor, Types...>::type result;
+        return detail::dynamic_any_visit::dispatch<result, Alloc,
+            basic_dynamic_any<Alloc>, Visitor, Fallback, Types...>(operand, visitor, fallback);
+    }
+
+    template<typename... Types, typename Alloc, typename Visitor, typename Fallback>
+    BOOST_DEDUCED_TYPENAME detail::dynamic_any_visit::result<Visitor, const Types...>::type
+    visit(const basic_dynamic_any<Alloc> & operand, Visitor && visitor, Fallback && fallback)
+    {
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_visit::result<Visitor, const Types...>::type result;
+        return detail::dynamic_any_visit::dispatch<result, Alloc,
+            const basic_dynamic_any<Alloc>, Visitor, Fallback, const Types...>(operand, visitor, fallback);
+    }
+
+    // as above, throwing bad_dynamic_any_cast when none of Types match
+    template<typename... Types, typename Alloc, typename Visitor>
+    BOOST_DEDUCED_TYPENAME detail::dynamic_any_visit::result<Visitor, Types...>::type
+    visit(basic_dynamic_any<Alloc> & operand, Visitor && visitor)
+    {
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_visit::result<Visitor, Types...>::type result;
+        return visit<Types...>(operand, visitor,
+            detail::dynamic_any_visit::throw_bad_cast<result>());
+    }
+
+    template<typename... Types, typename Alloc, typename Visitor>
+    BOOST_DEDUCED_TYPENAME detail::dynamic_any_visit::result<Visitor, const Types...>::type
+    visit(const basic_dynamic_any<Alloc> & operand, Visitor && visitor)
+    {
+        typedef BOOST_DEDUCED_TYPENAME
+            detail::dynamic_any_visit::result<Visitor, const Types...>::type result;
+        return visit<Types...>(operand, visitor,
+            detail::dynamic_any_visit::throw_bad_cast<result>());
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
@@ -0,0 +1,405 @@
+#ifndef BOOST_DYNAMIC_FUNCTION_INCLUDED
+#define BOOST_DYNAMIC_FUNCTION_INCLUDED
+
+#include <cstddef>
+#include <initializer_list>
+#include <typeinfo>
+#include <utility>
+
+#include <boost/config.hpp>
+#include <boost/any_ref.hpp>
+#include <boost/assert.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/core/enable_if.hpp>
+#include <boost/type_traits/conditional.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/is_lvalue_reference.hpp>
+#include <boost/type_traits/is_rvalue_reference.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+
+#if defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) || defined(BOOST_NO_CXX11_DECLTYPE) \
+ || defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+#  error "boost/dynamic_function.hpp requires variadic templates, decltype, rvalue references and <initializer_list>"
+#endif
+
+namespace boost
+{
+    class dynamic_function;
+
+namespace detail {
+    namespace dynamic_function {
+        typedef boost::detail::any_ref::type_token type_token;
+        typedef boost::detail::any_ref::access any_ref_access;
+
+        // What one parameter accepts, as the any_ref tokens of its type.
+        struct parameter
+        {
+            const type_token * mutable_ref;
+            const type_token * const_ref;
+            bool needs_mutable; // a non-const lvalue reference
+        };
+
+        // A value or const reference parameter binds to any reference to
+        // its type, a non-const lvalue reference only to a mutable one.
+        template<typename Param>
+        struct parameter_of
+        {
+            BOOST_STATIC_ASSERT_MSG(!boost::is_rvalue_reference<Param>::value,
+                "dynamic_function does not support rvalue reference parameters");
+
+            typedef BOOST_DEDUCED_TYPENAME boost::remove_cv<
+                BOOST_DEDUCED_TYPENAME boost::remove_reference<Param>::type>::type type;
+
+            BOOST_STATIC_CONSTANT(bool, needs_mutable = boost::is_lvalue_reference<Param>::value
+                && !boost::is_const<BOOST_DEDUCED_TYPENAME boost::remove_reference<Param>::type>::value);
+
+            typedef BOOST_DEDUCED_TYPENAME boost::conditional<needs_mutable,
+                type &, const type &>::type reference;
+
+            static reference get(void * address)
+            {
+                return *static_cast<type *>(address);
+            }
+        };
+
+        // Tokens are unique per type except across shared objects, so the
+        // type itself is only looked at when the addresses differ.
+        inline bool accepts(const parameter & p, const type_token * token)
+        {
+            if(BOOST_LIKELY(token == p.mutable_ref || (token == p.const_ref && !p.needs_mutable)))
+                return true;
+            return (token->is_mutable || !p.needs_mutable)
+                && boost::detail::any_ref::same_type(token, p.const_ref);
+        }
+
+        struct signature
+        {
+            std::size_t arity;
+            const parameter * parameters;
+            const boost::typeindex::type_info & (*result)();
+        };
+
+        // Built once per signature, at compile time: a call only compares
+        // the tokens of its arguments against these.
+        template<typename R, typename... Args>
+        struct signature_of
+        {
+            // one entry more than there are parameters, so that the array
+            // is never empty
+            static const parameter parameters[sizeof...(Args) + 1];
+            static const signature value;
+        };
+
+        template<typename R, typename... Args>
+        const parameter signature_of<R, Args...>::parameters[sizeof...(Args) + 1] =
+        {
+            {
+                &boost::detail::any_ref::tokens<BOOST_DEDUCED_TYPENAME parameter_of<Args>::type>::mutable_ref,
+                &boost::detail::any_ref::tokens<BOOST_DEDUCED_TYPENAME parameter_of<Args>::type>::const_ref,
+                parameter_of<Args>::needs_mutable
+            }...,
+            { 0, 0, false }
+        };
+
+        template<typename R, typename... Args>
+        const signature signature_of<R, Args...>::value =
+        {
+            sizeof...(Args),
+            signature_of<R, Args...>::parameters,
+            &detail::dynamic_any::type_of<BOOST_DEDUCED_TYPENAME boost::decay<R>::type>
+        };
+
+        template<std::size_t... I>
+        struct indices
+        {
+        };
+
+        template<std::size_t N, std::size_t... I>
+        struct make_indices : make_indices<N - 1, N - 1, I...>
+        {
+        };
+
+        template<std::size_t... I>
+        struct make_indices<0, I...>
+        {
+            typedef indices<I...> type;
+        };
+
+        // the result of the call as a dynamic_any, empty for void
+        template<typename R>
+        struct returns
+        {
+            template<typename F, typename... A>
+            static boost::dynamic_any call(F & f, A &&... args)
+            {
+                return boost::dynamic_any(f(static_cast<A &&>(args)...));
+            }
+        };
+
+        template<>
+        struct returns<void>
+        {
+            template<typename F, typename... A>
+            static boost::dynamic_any call(F & f, A &&... args)
+            {
+                f(static_cast<A &&>(args)...);
+                return boost::dynamic_any();
+            }
+        };
+
+        typedef boost::dynamic_any (*invoke_type)(void * target, const boost::any_ref * args);
+
+        // calls the F at target with args, which have been checked already
+        template<typename F, typename R, typename... Args>
+        struct invoker
+        {
+            static boost::dynamic_any call(void * target, const boost::any_ref * args)
+            {
+                return call(*static_cast<F *>(target), args,
+                    BOOST_DEDUCED_TYPENAME make_indices<sizeof...(Args)>::type());
+            }
+
+            template<std::size_t... I>
+            static boost::dynamic_any call(F & f, const boost::any_ref * args, indices<I...>)
+            {
+                (void)args;
+                return returns<R>::call(f,
+                    parameter_of<Args>::get(any_ref_access::address(args[I]))...);
+            }
+        };
+
+        // The signature of a callable with exactly one call operator, or
+        // of a function pointer, as a function type.
+        template<typename F>
+        struct deduce : deduce<decltype(&F::operator())>
+        {
+        };
+
+        template<typename R, typename... Args>
+        struct deduce<R (*)(Args...)>
+        {
+            typedef R type(Args...);
+        };
+
+        template<typename C, typename R, typename... Args>
+        struct deduce<R (C::*)(Args...)>
+        {
+            typedef R type(Args...);
+        };
+
+        template<typename C, typename R, typename... Args>
+        struct deduce<R (C::*)(Args...) const>
+        {
+            typedef R type(Args...);
+        };
+
+#ifdef __cpp_noexcept_function_type
+        // noexcept is part of the type from C++17 on
+        template<typename R, typename... Args>
+        struct deduce<R (*)(Args...) noexcept>
+        {
+            typedef R type(Args...);
+        };
+
+        template<typename C, typename R, typename... Args>
+        struct deduce<R (C::*)(Args...) noexcept>
+        {
+            typedef R type(Args...);
+        };
+
+        template<typename C, typename R, typename... Args>
+        struct deduce<R (C::*)(Args...) const noexcept>
+        {
+            typedef R type(Args...);
+        };
+#endif
+
+        template<typename Signature>
+        struct signature_tag
+        {
+        };
+
+        template<typename F, typename Signature>
+        struct target_of;
+
+        template<typename F, typename R, typename... Args>
+        struct target_of<F, R(Args...)>
+        {
+            static const signature * value()
+            {
+                return &signature_of<R, Args...>::value;
+            }
+
+            static invoke_type invoke()
+            {
+                return &invoker<F, R, Args...>::call;
+            }
+        };
+
+        // keeps the converting constructor from hijacking copies of
+        // non-const lvalues
+        template<typename F>
+        struct disable_if_self
+          : boost::disable_if<boost::is_same<boost::dynamic_function,
+                BOOST_DEDUCED_TYPENAME boost::decay<F>::type> >
+        {
+        };
+    } // namespace dynamic_function
+} // namespace detail
+
+    class bad_dynamic_function_call : public std::bad_cast
+    {
+    public:
+        virtual const char * what() const throw()
+        {
+            return "boost::bad_dynamic_function_call: "
+                   "arguments do not match the signature";
+        }
+    };
+
+/**
+    @brief any callable, called with a sequence of any_ref arguments.
+
+    The signature of the callable is taken from its call operator (or from
+    make_dynamic_function, for callables with several), and turned once into
+    a table of any_ref type tokens.  A call then only compares the token of
+    each argument against that table before passing the referenced objects
+    on, so no cast or type_info comparison is made per call in the common
+    case.  The result comes back as a dynamic_any holding a copy of it, or
+    an empty one for void.
+
+    Parameters taken by value or by const reference accept any any_ref to
+    their type; non-const lvalue references accept only mutable ones, and
+    the callable may then modify the caller's object through them.
+*/
+class dynamic_function
+{
+    public: // structors
+
+        dynamic_function() BOOST_NOEXCEPT
+          : m_signature(0), m_invoke(0)
+        {
+        }
+
+        template<typename F>
+        dynamic_function(F f,
+            BOOST_DEDUCED_TYPENAME detail::dynamic_function::disable_if_self<F>::type * = 0)
+          : m_target(static_cast<F &&>(f))
+          , m_signature(detail::dynamic_function::target_of<F,
+                BOOST_DEDUCED_TYPENAME detail::dynamic_function::deduce<F>::type>::value())
+          , m_invoke(detail::dynamic_function::target_of<F,
+                BOOST_DEDUCED_TYPENAME detail::dynamic_function::deduce<F>::type>::invoke())
+        {
+        }
+
+    public: // modifiers
+
+        dynamic_function & swap(dynamic_function & rhs) BOOST_NOEXCEPT
+        {
+            m_target.swap(rhs.m_target);
+            std::swap(m_signature, rhs.m_signature);
+            std::swap(m_invoke, rhs.m_invoke);
+            return *this;
+        }
+
+    public: // queries
+
+        bool empty() const BOOST_NOEXCEPT
+        {
+            return !m_invoke;
+        }
+
+        std::size_t arity() const
+        {
+            BOOST_ASSERT(!empty());
+            return m_signature->arity;
+        }
+
+        // the type a parameter refers to, without reference or cv-qualifiers
+        const boost::typeindex::type_info & argument_type(std::size_t index) const
+        {
+            BOOST_ASSERT(index < arity());
+            return m_signature->parameters[index].const_ref->type();
+        }
+
+        // the type held by the results, void for a callable returning nothing
+        const boost::typeindex::type_info & result_type() const
+        {
+            BOOST_ASSERT(!empty());
+            return m_signature->result();
+        }
+
+        // whether a call with these arguments would go through
+        bool accepts(const any_ref * args, std::size_t count) const BOOST_NOEXCEPT
+        {
+            if(!m_invoke || count != m_signature->arity)
+                return false;
+            for(std::size_t i = 0; i != count; ++i)
+                if(!detail::dynamic_function::accepts(m_signature->parameters[i],
+                        detail::dynamic_function::any_ref_access::token(args[i])))
+                    return false;
+            return true;
+        }
+
+    public: // calls
+
+        // throws bad_dynamic_function_call if the arguments do not match
+        // the signature, or *this is empty
+        dynamic_any operator()(const any_ref * args, std::size_t count) const
+        {
+            if(!accepts(args, count))
+                boost::throw_exception(bad_dynamic_function_call());
+            return m_invoke(detail::dynamic_any::access::value(m_target), args);
+        }
+
+        dynamic_any operator()(std::initializer_list<any_ref> args) const
+        {
+            return (*this)(args.begin(), args.size());
+        }
+
+    private: // representation
+
+        template<typename Signature, typename F>
+        friend dynamic_function make_dynamic_function(F f);
+
+        template<typename F, typename Signature>
+        dynamic_function(F && f, detail::dynamic_function::signature_tag<Signature>)
+          : m_target(static_cast<F &&>(f))
+          , m_signature(detail::dynamic_function::target_of<
+                BOOST_DEDUCED_TYPENAME decay<F>::type, Signature>::value())
+          , m_invoke(detail::dynamic_function::target_of<
+                BOOST_DEDUCED_TYPENAME decay<F>::type, Signature>::invoke())
+        {
+        }
+
+        dynamic_any m_target;
+        const detail::dynamic_function::signature * m_signature;
+        detail::dynamic_function::invoke_type m_invoke;
+};
+
+    inline void swap(dynamic_function & lhs, dynamic_function & rhs) BOOST_NOEXCEPT
+    {
+        lhs.swap(rhs);
+    }
+
+    // Wraps f as a callable of the given signature, e.g. int(const std::string &),
+    // for callables whose signature cannot be deduced: overloaded or
+    // templated call operators, or generic lambdas.
+    template<typename Signature, typename F>
+    dynamic_function make_dynamic_function(F f)
+    {
+        return dynamic_function(static_cast<F &&>(f),
+            detail::dynamic_function::signature_tag<Signature>());
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
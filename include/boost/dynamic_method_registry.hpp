@@ -0,0 +1,282 @@
+#ifndef BOOST_DYNAMIC_METHOD_REGISTRY_INCLUDED
+#define BOOST_DYNAMIC_METHOD_REGISTRY_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/assert.hpp>
+#include <boost/dynamic_function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/throw_exception.hpp>
+
+#if defined(BOOST_NO_CXX11_HDR_ATOMIC) || defined(BOOST_NO_CXX11_HDR_UNORDERED_MAP)
+#  error "boost/dynamic_method_registry.hpp requires <atomic> and <unordered_map>"
+#endif
+
+// Number of slots (a power of two) in a registry's table of resolved
+// overloads, one per method and list of argument types seen.
+#ifndef BOOST_DYNAMIC_METHOD_CACHE_SIZE
+#  define BOOST_DYNAMIC_METHOD_CACHE_SIZE 1024
+#endif
+
+// Number of slots, from the one its hash picks, that a combination may be
+// kept in.  When those are all taken by others it is resolved on every
+// call, which then costs at most this many compares more than without the
+// table.
+#ifndef BOOST_DYNAMIC_METHOD_CACHE_PROBES
+#  define BOOST_DYNAMIC_METHOD_CACHE_PROBES 8
+#endif
+
+namespace boost
+{
+namespace detail {
+    namespace dynamic_method_registry {
+        typedef boost::detail::any_ref::type_token type_token;
+
+        // an interned name and its overloads
+        struct method
+        {
+            std::string name;
+            std::vector<boost::dynamic_function> overloads;
+        };
+
+        // The overload chosen for one method and one list of argument
+        // tokens, or null when none accepts them.  Written once, before it
+        // is published, and never changed afterwards.
+        struct resolution
+        {
+            std::size_t hash;
+            const method * name;
+            std::vector<const type_token *> tokens;
+            const boost::dynamic_function * target;
+        };
+
+        inline std::size_t hash(const method * name, const boost::any_ref * args, std::size_t count)
+        {
+            std::size_t seed = boost::hash<const void *>()(name);
+            for(std::size_t i = 0; i != count; ++i)
+                boost::hash_combine(seed, static_cast<const void *>(
+                    boost::detail::any_ref::access::token(args[i])));
+            return seed;
+        }
+
+        inline bool matches(const resolution & r, std::size_t hash, const method * name,
+            const boost::any_ref * args, std::size_t count)
+        {
+            if(r.hash != hash || r.name != name || r.tokens.size() != count)
+                return false;
+            for(std::size_t i = 0; i != count; ++i)
+                if(r.tokens[i] != boost::detail::any_ref::access::token(args[i]))
+                    return false;
+            return true;
+        }
+    } // namespace dynamic_method_registry
+} // namespace detail
+
+/**
+    @brief named methods, each a set of dynamic_function overloads, called by name.
+
+    Names are interned: add and find hash a name once and return a method_id,
+    through which calls reach the method without looking at the name again.
+    The overload taken for a call is the first one, in the order they were
+    added, that accepts the arguments; which one that is depends only on the
+    method and the types of the arguments, so it is looked for once per such
+    combination and then found in an open-addressed table keyed by the
+    method_id and the any_ref type tokens of the arguments.
+
+    Methods are added while the registry is set up.  Once that is done,
+    calls may be made from any number of threads at once: entries of the
+    table are written once and only read afterwards, as in the cast cache of
+    dynamic_any.
+*/
+class dynamic_method_registry
+{
+    public: // types
+
+        typedef const detail::dynamic_method_registry::method * method_id;
+
+    public: // structors
+
+        dynamic_method_registry()
+        {
+            for(std::size_t i = 0; i != BOOST_DYNAMIC_METHOD_CACHE_SIZE; ++i)
+                m_cache[i].store(0, std::memory_order_relaxed);
+        }
+
+        ~dynamic_method_registry()
+        {
+            clear_cache();
+        }
+
+    public: // modifiers
+
+        // adds f as an overload of the method called name; not to be
+        // called while other threads call methods
+        method_id add(const std::string & name, const dynamic_function & f)
+        {
+            BOOST_ASSERT(!f.empty());
+            detail::dynamic_method_registry::method & m = intern(name);
+            m.overloads.push_back(f);
+            // what was resolved before may now resolve differently
+            clear_cache();
+            return &m;
+        }
+
+    public: // queries
+
+        // the method called name, or null if nothing has been added under it
+        method_id find(const std::string & name) const
+        {
+            const std::unordered_map<std::string,
+                detail::dynamic_method_registry::method *>::const_iterator i = m_names.find(name);
+            return i != m_names.end() ? i->second : 0;
+        }
+
+        const std::string & name(method_id id) const
+        {
+            return id->name;
+        }
+
+        std::size_t overloads(method_id id) const
+        {
+            return id->overloads.size();
+        }
+
+        // the overload a call with args would go to, or null if none
+        // accepts them
+        const dynamic_function * resolve(method_id id, const any_ref * args, std::size_t count) const
+        {
+            typedef detail::dynamic_method_registry::resolution resolution;
+            BOOST_STATIC_ASSERT((BOOST_DYNAMIC_METHOD_CACHE_SIZE & (BOOST_DYNAMIC_METHOD_CACHE_SIZE - 1)) == 0);
+            BOOST_STATIC_ASSERT(BOOST_DYNAMIC_METHOD_CACHE_PROBES <= BOOST_DYNAMIC_METHOD_CACHE_SIZE);
+
+            const std::size_t h = detail::dynamic_method_registry::hash(id, args, count);
+            for(std::size_t probe = 0; probe != BOOST_DYNAMIC_METHOD_CACHE_PROBES; ++probe)
+            {
+                resolution * found = slot(h, probe).load(std::memory_order_acquire);
+                if(!found)
+                    return publish(h, probe, id, args, count);
+                if(detail::dynamic_method_registry::matches(*found, h, id, args, count))
+                    return found->target;
+            }
+            return search(id, args, count);
+        }
+
+    public: // calls
+
+        // throws bad_dynamic_function_call if no overload accepts args
+        dynamic_any call(method_id id, const any_ref * args, std::size_t count) const
+        {
+            const dynamic_function * f = resolve(id, args, count);
+            if(!f)
+                boost::throw_exception(bad_dynamic_function_call());
+            return (*f)(args, count);
+        }
+
+        dynamic_any call(method_id id, std::initializer_list<any_ref> args) const
+        {
+            return call(id, args.begin(), args.size());
+        }
+
+        // as above, also throwing bad_dynamic_function_call for an unknown
+        // name; this hashes name on every call, which a method_id avoids
+        dynamic_any call(const std::string & name, const any_ref * args, std::size_t count) const
+        {
+            const method_id id = find(name);
+            if(!id)
+                boost::throw_exception(bad_dynamic_function_call());
+            return call(id, args, count);
+        }
+
+        dynamic_any call(const std::string & name, std::initializer_list<any_ref> args) const
+        {
+            return call(name, args.begin(), args.size());
+        }
+
+    private: // representation
+
+        detail::dynamic_method_registry::method & intern(const std::string & name)
+        {
+            detail::dynamic_method_registry::method *& m = m_names[name];
+            if(!m)
+            {
+                m_methods.push_back(detail::dynamic_method_registry::method());
+                m = &m_methods.back();
+                m->name = name;
+            }
+            return *m;
+        }
+
+        static const dynamic_function * search(method_id id, const any_ref * args, std::size_t count)
+        {
+            for(std::size_t i = 0; i != id->overloads.size(); ++i)
+                if(id->overloads[i].accepts(args, count))
+                    return &id->overloads[i];
+            return 0;
+        }
+
+        std::atomic<detail::dynamic_method_registry::resolution *> &
+        slot(std::size_t hash, std::size_t probe) const
+        {
+            return m_cache[(hash + probe) & (BOOST_DYNAMIC_METHOD_CACHE_SIZE - 1)];
+        }
+
+        // Keeps the resolution of this call in the first free slot from
+        // probe on.  A slot another thread fills first is no loss when it
+        // was filled for the same call; otherwise the next one is tried,
+        // and when none is left the call is resolved without being kept.
+        const dynamic_function * publish(std::size_t hash, std::size_t probe,
+            method_id id, const any_ref * args, std::size_t count) const
+        {
+            detail::dynamic_method_registry::resolution * r =
+                new detail::dynamic_method_registry::resolution;
+            r->hash = hash;
+            r->name = id;
+            r->tokens.reserve(count);
+            for(std::size_t i = 0; i != count; ++i)
+                r->tokens.push_back(detail::any_ref::access::token(args[i]));
+            r->target = search(id, args, count);
+
+            const dynamic_function * target = r->target;
+            for(; probe != BOOST_DYNAMIC_METHOD_CACHE_PROBES; ++probe)
+            {
+                detail::dynamic_method_registry::resolution * expected = 0;
+                if(slot(hash, probe).compare_exchange_strong(expected, r,
+                        std::memory_order_acq_rel, std::memory_order_acquire))
+                    return target;
+                if(detail::dynamic_method_registry::matches(*expected, hash, id, args, count))
+                    break;
+            }
+            delete r;
+            return target;
+        }
+
+        void clear_cache()
+        {
+            for(std::size_t i = 0; i != BOOST_DYNAMIC_METHOD_CACHE_SIZE; ++i)
+                delete m_cache[i].exchange(0, std::memory_order_relaxed);
+        }
+
+        std::unordered_map<std::string, detail::dynamic_method_registry::method *> m_names;
+        std::deque<detail::dynamic_method_registry::method> m_methods; // never moved
+        mutable std::atomic<detail::dynamic_method_registry::resolution *>
+            m_cache[BOOST_DYNAMIC_METHOD_CACHE_SIZE];
+
+    private: // intentionally left unimplemented
+        dynamic_method_registry(const dynamic_method_registry &);
+        dynamic_method_registry & operator=(const dynamic_method_registry &);
+};
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
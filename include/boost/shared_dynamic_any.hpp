@@ -0,0 +1,366 @@
+#ifndef BOOST_SHARED_DYNAMIC_ANY_INCLUDED
+#define BOOST_SHARED_DYNAMIC_ANY_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <boost/config.hpp>
+#include <boost/dynamic_any.hpp>
+#include <boost/none.hpp>
+#include <boost/optional/optional.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/core/enable_if.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <boost/type_traits/is_reference.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) \
+ || defined(BOOST_NO_CXX11_HDR_ATOMIC)
+#  error "boost/shared_dynamic_any.hpp requires rvalue references, variadic templates and <atomic>"
+#endif
+
+namespace boost
+{
+    class shared_dynamic_any;
+
+namespace detail {
+    namespace shared_dynamic_any {
+        typedef boost::detail::dynamic_any::access access;
+        typedef access::types<std::allocator<char> > types;
+
+        // One held value and the number of shared_dynamic_any objects
+        // referring to it.  The value comes with the table a dynamic_any
+        // holding it would use, so it is cast by the same rules.
+        class block
+        {
+        public: // structors
+
+            block()
+              : refs(1), shareable(true), table(0), value(0)
+            {
+            }
+
+            virtual ~block()
+            {
+            }
+
+        public: // queries
+
+            // a new, unshared block with a copy of the value
+            virtual block * clone() const = 0;
+
+            std::atomic<std::size_t> refs;
+
+            // Cleared once a mutable pointer or reference to the value has
+            // been handed out, after which copies get their own value
+            // rather than one that can still be written through it.  Only
+            // an unshared block is ever cleared, and it then stays
+            // unshared, so the flag is only seen by its one owner.
+            bool shareable;
+
+            const types::vtable * table;
+            void * value;
+
+        private: // intentionally left unimplemented
+            block(const block &);
+            block & operator=(const block &);
+        };
+
+        template<typename ValueType>
+        class node : public block
+        {
+        public: // structors
+
+            template<typename... Args>
+            explicit node(Args &&... args)
+              : held(static_cast<Args &&>(args)...)
+            {
+                table = &types::vtable_of<ValueType>::type::table;
+                value = &held;
+            }
+
+        public: // queries
+
+            virtual block * clone() const
+            {
+                return new node(held);
+            }
+
+        private: // representation
+
+            ValueType held;
+        };
+
+        // keeps the forwarding constructor and assignment from hijacking
+        // copies of non-const lvalues
+        template<typename ValueType, typename R = void>
+        struct disable_if_self
+          : boost::disable_if<boost::is_same<boost::shared_dynamic_any,
+                BOOST_DEDUCED_TYPENAME boost::decay<ValueType>::type>, R>
+        {
+        };
+    } // namespace shared_dynamic_any
+} // namespace detail
+
+/**
+    @brief a dynamic_any whose copies share one immutable value until one of them is modified.
+
+    Copying a shared_dynamic_any only increments an atomic reference count, so
+    fanning a large value out to many owners costs no copies of it.  Reading the
+    value, through a const shared_dynamic_any or the const forms of
+    dynamic_any_cast, never copies it.  Obtaining mutable access through
+    dynamic_any_cast or emplace first gives this object a private copy of the
+    value if, and only if, it is still shared (copy on write).  As the pointer
+    or reference obtained may be written through at any later time, the value
+    then stays private: copies of this object copy it instead of sharing it,
+    until a new value is assigned.
+
+    Distinct shared_dynamic_any objects sharing a value may be used from
+    different threads; as for any other value type, a single shared_dynamic_any
+    must not be modified while another thread uses it.
+*/
+class shared_dynamic_any
+{
+    public: // structors
+
+        shared_dynamic_any() BOOST_NOEXCEPT
+          : m_block(0)
+        {
+        }
+
+        template<typename ValueType>
+        shared_dynamic_any(ValueType && value,
+            BOOST_DEDUCED_TYPENAME detail::shared_dynamic_any::disable_if_self<ValueType>::type * = 0)
+          : m_block(make<BOOST_DEDUCED_TYPENAME decay<ValueType>::type>(
+                static_cast<ValueType &&>(value)))
+        {
+        }
+
+        shared_dynamic_any(const shared_dynamic_any & other)
+          : m_block(share(other.m_block))
+        {
+        }
+
+        shared_dynamic_any(shared_dynamic_any && other) BOOST_NOEXCEPT
+          : m_block(other.m_block)
+        {
+            other.m_block = 0;
+        }
+
+        ~shared_dynamic_any()
+        {
+            release(m_block);
+        }
+
+    public: // modifiers
+
+        shared_dynamic_any & swap(shared_dynamic_any & rhs) BOOST_NOEXCEPT
+        {
+            detail::shared_dynamic_any::block * tmp = m_block;
+            m_block = rhs.m_block;
+            rhs.m_block = tmp;
+            return *this;
+        }
+
+        shared_dynamic_any & operator=(const shared_dynamic_any & rhs)
+        {
+            shared_dynamic_any(rhs).swap(*this);
+            return *this;
+        }
+
+        shared_dynamic_any & operator=(shared_dynamic_any && rhs) BOOST_NOEXCEPT
+        {
+            shared_dynamic_any(static_cast<shared_dynamic_any &&>(rhs)).swap(*this);
+            return *this;
+        }
+
+        template<typename ValueType>
+        BOOST_DEDUCED_TYPENAME detail::shared_dynamic_any::disable_if_self<
+            ValueType, shared_dynamic_any &>::type
+        operator=(ValueType && rhs)
+        {
+            shared_dynamic_any(static_cast<ValueType &&>(rhs)).swap(*this);
+            return *this;
+        }
+
+        // replaces the value with a ValueType constructed from args
+        template<typename ValueType, typename... Args>
+        ValueType & emplace(Args &&... args)
+        {
+            shared_dynamic_any(make<ValueType>(static_cast<Args &&>(args)...)).swap(*this);
+            m_block->shareable = false;
+            return *static_cast<ValueType *>(m_block->value);
+        }
+
+        void clear() BOOST_NOEXCEPT
+        {
+            shared_dynamic_any().swap(*this);
+        }
+
+    public: // queries
+
+        bool empty() const BOOST_NOEXCEPT
+        {
+            return !m_block;
+        }
+
+        const boost::typeindex::type_info & type() const
+        {
+            return m_block ? m_block->table->type() : detail::dynamic_any::type_of<void>();
+        }
+
+        // number of shared_dynamic_any objects sharing the value (0 if empty)
+        std::size_t use_count() const BOOST_NOEXCEPT
+        {
+            return m_block ? m_block->refs.load(std::memory_order_acquire) : 0;
+        }
+
+        bool unique() const BOOST_NOEXCEPT
+        {
+            return use_count() == 1;
+        }
+
+    private: // representation
+
+        template<typename ValueType>
+        friend const ValueType * dynamic_any_cast(const shared_dynamic_any *) BOOST_NOEXCEPT;
+
+        template<typename ValueType>
+        friend ValueType * dynamic_any_cast(shared_dynamic_any *);
+
+        explicit shared_dynamic_any(detail::shared_dynamic_any::block * b) BOOST_NOEXCEPT
+          : m_block(b)
+        {
+        }
+
+        template<typename ValueType, typename... Args>
+        static detail::shared_dynamic_any::block * make(Args &&... args)
+        {
+            return new detail::shared_dynamic_any::node<ValueType>(static_cast<Args &&>(args)...);
+        }
+
+        // the block a copy of an object referring to b refers to
+        static detail::shared_dynamic_any::block * share(detail::shared_dynamic_any::block * b)
+        {
+            if(!b)
+                return 0;
+            if(!b->shareable)
+                return b->clone();
+            b->refs.fetch_add(1, std::memory_order_relaxed);
+            return b;
+        }
+
+        static void release(detail::shared_dynamic_any::block * b) BOOST_NOEXCEPT
+        {
+            if(b && b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete b;
+        }
+
+        template<typename ValueType>
+        ValueType * cast() const BOOST_NOEXCEPT
+        {
+            return m_block
+                ? detail::shared_dynamic_any::access::cast<ValueType, std::allocator<char> >(
+                      m_block->table, m_block->value)
+                : 0;
+        }
+
+        // read-only access, even through a non-const operand
+        template<typename ValueType>
+        const ValueType * detach(const ValueType * value) BOOST_NOEXCEPT
+        {
+            return value;
+        }
+
+        // Gives this object its own copy of the value before it is
+        // modified, and keeps it its own; the held type, and so the offset
+        // of value within the held value, stay the same.
+        template<typename ValueType>
+        ValueType * detach(ValueType * value)
+        {
+            if(!value)
+                return value;
+
+            if(m_block->refs.load(std::memory_order_acquire) != 1)
+            {
+                const std::ptrdiff_t offset = reinterpret_cast<char *>(value)
+                    - static_cast<char *>(m_block->value);
+                shared_dynamic_any(m_block->clone()).swap(*this);
+                value = reinterpret_cast<ValueType *>(
+                    static_cast<char *>(m_block->value) + offset);
+            }
+            m_block->shareable = false;
+            return value;
+        }
+
+        detail::shared_dynamic_any::block * m_block;
+};
+
+    inline void swap(shared_dynamic_any & lhs, shared_dynamic_any & rhs) BOOST_NOEXCEPT
+    {
+        lhs.swap(rhs);
+    }
+
+    // read-only access never copies the value
+    template<typename ValueType>
+    const ValueType * dynamic_any_cast(const shared_dynamic_any * operand) BOOST_NOEXCEPT
+    {
+        return operand ? operand->cast<const ValueType>() : 0;
+    }
+
+    // mutable access first makes the value private to operand if it is
+    // shared, which may throw whatever copying it throws, and keeps it
+    // private from then on
+    template<typename ValueType>
+    ValueType * dynamic_any_cast(shared_dynamic_any * operand)
+    {
+        return operand ? operand->detach(operand->cast<ValueType>()) : 0;
+    }
+
+    template<typename ValueType>
+    ValueType dynamic_any_cast(shared_dynamic_any & operand)
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        // returning a copy of the value only needs to read it
+        nonref * result = is_reference<ValueType>::value
+            ? dynamic_any_cast<nonref>(&operand)
+            : const_cast<nonref *>(dynamic_any_cast<nonref>(
+                  static_cast<const shared_dynamic_any *>(&operand)));
+        if(!result)
+            boost::throw_exception(bad_dynamic_any_cast());
+        return *result;
+    }
+
+    template<typename ValueType>
+    inline ValueType dynamic_any_cast(const shared_dynamic_any & operand)
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        const nonref * result = dynamic_any_cast<nonref>(&operand);
+        if(!result)
+            boost::throw_exception(bad_dynamic_any_cast());
+        return *result;
+    }
+
+    // read-only, so it never copies the value either
+    template<typename ValueType>
+    inline boost::optional<const BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type &>
+    try_cast(const shared_dynamic_any & operand) BOOST_NOEXCEPT
+    {
+        typedef BOOST_DEDUCED_TYPENAME remove_reference<ValueType>::type nonref;
+
+        const nonref * result = dynamic_any_cast<nonref>(&operand);
+        if(BOOST_LIKELY(result != 0))
+            return boost::optional<const nonref &>(*result);
+        return boost::none;
+    }
+}
+
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#endif
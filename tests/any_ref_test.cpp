@@ -0,0 +1,160 @@
+// what:  unit tests for boost::any_ref
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_trivially_copyable.hpp>
+
+#include "boost/any_ref.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_default_ctor();
+    void test_mutable_ref();
+    void test_const_ref();
+    void test_copy();
+    void test_rebind();
+    void test_representation();
+    void test_try_cast();
+
+    const test_case test_cases[] =
+    {
+        { "default construction",           test_default_ctor      },
+        { "reference to mutable object",    test_mutable_ref       },
+        { "reference to const object",      test_const_ref         },
+        { "copy construction",              test_copy              },
+        { "assignment rebinds",             test_rebind            },
+        { "two word representation",        test_representation    },
+        { "non-throwing cast",              test_try_cast          }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+    using boost::typeindex::type_id;
+
+    void times2(double & v) { v *= 2; }
+    double twice(const double & v) { return 2 * v; }
+
+    void test_default_ctor()
+    {
+        const any_ref r;
+
+        check_equal(r.type(), type_id<void>(), "type");
+        check_null(r.const_ptr<int>(), "const_ptr<int>");
+        check_null(r.ptr<int>(), "ptr<int>");
+    }
+
+    void test_mutable_ref()
+    {
+        double x = 5.5;
+        any_ref r = x;
+
+        check_equal(r.type(), type_id<double>(), "type");
+        check_true(r.is_mutable(), "is_mutable");
+        check_equal(r.ptr<double>(), &x, "ptr<double>");
+        check_equal(r.const_ptr<double>(), &x, "const_ptr<double>");
+        check_null(r.ptr<int>(), "ptr to other type");
+        check_null(r.const_ptr<float>(), "const_ptr to other type");
+
+        times2(r);
+        check_equal(x, 11.0, "modified through reference conversion");
+        check_equal(twice(r), 22.0, "const reference conversion");
+    }
+
+    void test_const_ref()
+    {
+        const double cx = 22;
+        any_ref r = cx;
+
+        check_equal(r.type(), type_id<double>(), "type");
+        check_false(r.is_mutable(), "is_mutable");
+        check_null(r.ptr<double>(), "ptr<double> to const object");
+        check_equal(r.const_ptr<double>(), &cx, "const_ptr<double>");
+        check_equal(twice(r), 44.0, "const reference conversion");
+
+        TEST_CHECK_THROW(
+            times2(r),
+            bad_any_ref_cast,
+            "any_ref cast from const double& to double&");
+    }
+
+    void test_copy()
+    {
+        std::string text = "test message";
+        any_ref original = text;
+        any_ref copy = original;
+        const any_ref const_copy(original);
+
+        check_equal(copy.ptr<std::string>(), &text, "copy refers to the same object");
+        check_equal(const_copy.ptr<std::string>(), &text, "const copy refers to the same object");
+        check_null(copy.ptr<any_ref>(), "copy does not refer to the original any_ref");
+    }
+
+    void test_rebind()
+    {
+        int five = 5;
+        double x = 1.5;
+        any_ref r = five;
+
+        int & ref = r;
+        check_equal(&ref, &five, "int reference");
+
+        any_ref * assign_result = &(r = x);
+        check_equal(assign_result, &r, "address of assignment result");
+        check_equal(r.type(), type_id<double>(), "type after rebinding");
+        check_null(r.ptr<int>(), "old type after rebinding");
+        check_equal(r.ptr<double>(), &x, "new referent after rebinding");
+    }
+
+    void test_representation()
+    {
+        BOOST_STATIC_ASSERT(boost::is_trivially_copyable<any_ref>::value);
+        check_equal(sizeof(any_ref), 2 * sizeof(void *), "size of any_ref");
+    }
+    void test_try_cast()
+    {
+        double x = 1.5;
+        const double cx = 2.5;
+        any_ref r = x;
+        any_ref cr = cx;
+
+        check_equal(&*try_cast<double>(r), &x, "mutable reference");
+        check_equal(&*try_cast<const double>(r), &x, "const reference to mutable object");
+        check_false(try_cast<double>(cr).is_initialized(), "mutable reference to const object");
+        check_equal(*try_cast<const double>(cr), 2.5, "const reference to const object");
+        check_false(try_cast<const int>(r).is_initialized(), "other type");
+    }
+
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
@@ -0,0 +1,248 @@
+// what:  unit tests for boost::bounded_dynamic_any
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "boost/bounded_dynamic_any.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_default_ctor();
+    void test_converting_ctor();
+    void test_exact_cast();
+    void test_base_cast();
+    void test_virtual_base_cast();
+    void test_copy_and_move();
+    void test_emplace();
+    void test_from_dynamic_any();
+    void test_to_dynamic_any();
+
+    const test_case test_cases[] =
+    {
+        { "default construction",         test_default_ctor      },
+        { "single argument construction", test_converting_ctor   },
+        { "cast to a bounded type",       test_exact_cast        },
+        { "cast to a base class",         test_base_cast         },
+        { "cast to a virtual base class", test_virtual_base_cast },
+        { "copy and move",                test_copy_and_move     },
+        { "emplace",                      test_emplace           },
+        { "from dynamic_any",             test_from_dynamic_any  },
+        { "to dynamic_any",               test_to_dynamic_any    }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+    using boost::typeindex::type_id;
+
+    struct base
+    {
+        int a;
+    };
+
+    struct base1
+    {
+        int a1;
+    };
+
+    struct derived : base, base1
+    {
+        int b;
+    };
+
+    struct node
+    {
+        virtual ~node() {}
+        int id;
+    };
+
+    struct left : virtual node {};
+    struct right : virtual node {};
+    struct diamond : left, right {};
+
+    // counts live instances, to check that every value is destroyed once
+    struct counted
+    {
+        static int count;
+
+        counted() { ++count; }
+        counted(const counted &) { ++count; }
+        ~counted() { --count; }
+    };
+
+    int counted::count = 0;
+
+    typedef bounded_dynamic_any<int, std::string, derived> value;
+
+    void test_default_ctor()
+    {
+        const value empty;
+
+        check_true(empty.empty(), "empty");
+        check_equal(empty.which(), -1, "which");
+        check_null(dynamic_any_cast<int>(&empty), "dynamic_any_cast<int>");
+        check_equal(empty.type(), type_id<void>(), "type");
+    }
+
+    void test_converting_ctor()
+    {
+        std::string text = "test message";
+        value v = text;
+
+        check_false(v.empty(), "empty");
+        check_equal(v.which(), 1, "which");
+        check_equal(v.type(), type_id<std::string>(), "type");
+        check_equal(dynamic_any_cast<std::string>(v), text, "comparing cast copy against original text");
+        check_unequal(dynamic_any_cast<std::string>(&v), &text, "comparing address in copy against original text");
+        check_true(sizeof(value) < sizeof(std::string) + sizeof(derived) + sizeof(void *),
+                   "values share their storage");
+    }
+
+    void test_exact_cast()
+    {
+        value v = 42;
+
+        check_equal(dynamic_any_cast<int>(v), 42, "cast by value");
+        check_non_null(dynamic_any_cast<const int>(&v), "cast to const");
+        check_null(dynamic_any_cast<std::string>(&v), "cast to another bounded type");
+        check_true(!try_cast<std::string>(v), "try_cast to another bounded type");
+        TEST_CHECK_THROW(dynamic_any_cast<std::string>(v), bad_dynamic_any_cast, "cast to another bounded type");
+
+        dynamic_any_cast<int &>(v) = 7;
+        check_equal(*try_cast<int>(static_cast<const value &>(v)), 7, "assigned through reference");
+    }
+
+    void test_base_cast()
+    {
+        derived d;
+        d.a = 1;
+        d.a1 = 2;
+        d.b = 3;
+        value v = d;
+
+        const derived * held = dynamic_any_cast<derived>(&v);
+        check_non_null(held, "cast to held type");
+        check_equal(dynamic_any_cast<base>(&v), static_cast<const base *>(held), "cast to first base");
+        check_equal(dynamic_any_cast<base1>(&v), static_cast<const base1 *>(held), "cast to second base");
+        check_equal(dynamic_any_cast<const base1 &>(v).a1, 2, "value through second base");
+
+        v = 1;
+        check_null(dynamic_any_cast<base1>(&v), "no base of int");
+    }
+
+    void test_virtual_base_cast()
+    {
+        bounded_dynamic_any<int, diamond> v = diamond();
+        dynamic_any_cast<node &>(v).id = 5;
+
+        const diamond & held = dynamic_any_cast<const diamond &>(v);
+        check_equal(dynamic_any_cast<node>(&v), static_cast<const node *>(&held), "cast to virtual base");
+        check_equal(dynamic_any_cast<left &>(v).id, 5, "one virtual base through each path");
+        check_equal(dynamic_any_cast<right &>(v).id, 5, "one virtual base through each path");
+    }
+
+    void test_copy_and_move()
+    {
+        {
+            bounded_dynamic_any<int, counted> original = counted();
+            check_equal(counted::count, 1, "constructed");
+
+            bounded_dynamic_any<int, counted> copy = original;
+            check_equal(counted::count, 2, "copied");
+
+            bounded_dynamic_any<int, counted> moved = std::move(copy);
+            check_equal(counted::count, 3, "moved from value left in place");
+
+            copy = 4;
+            check_equal(counted::count, 2, "replaced");
+
+            swap(copy, original);
+            check_equal(dynamic_any_cast<int>(original), 4, "swapped");
+            check_non_null(dynamic_any_cast<counted>(&copy), "swapped");
+            check_equal(counted::count, 2, "swapped");
+
+            copy.clear();
+            check_true(copy.empty(), "cleared");
+            check_equal(counted::count, 1, "cleared");
+        }
+        check_equal(counted::count, 0, "destroyed");
+
+        value a, b;
+        check_true(std::is_nothrow_move_constructible<value>::value, "nothrow move");
+        check_true(std::is_nothrow_move_assignable<value>::value, "nothrow move assignment");
+        check_true(noexcept(swap(a, b)), "nothrow swap");
+        check_false(std::is_nothrow_move_constructible<bounded_dynamic_any<int, counted> >::value,
+            "move that may throw");
+    }
+
+    void test_emplace()
+    {
+        value v = 1;
+        std::string & s = v.emplace<std::string>(3u, 'x');
+
+        check_equal(s, std::string("xxx"), "constructed in place");
+        check_equal(dynamic_any_cast<std::string>(&v), &s, "held in place");
+        check_equal(v.which(), 1, "which");
+    }
+
+    void test_from_dynamic_any()
+    {
+        dynamic_any open = std::string("text");
+        value v(open);
+        check_equal(dynamic_any_cast<std::string>(v), std::string("text"), "copied");
+        check_equal(dynamic_any_cast<std::string>(open), std::string("text"), "left in place");
+
+        value moved(std::move(open));
+        check_equal(dynamic_any_cast<std::string>(moved), std::string("text"), "moved");
+
+        check_true(value(dynamic_any()).empty(), "empty");
+        TEST_CHECK_THROW(value(dynamic_any(1.5)), bad_dynamic_any_cast, "unbounded type");
+        TEST_CHECK_THROW(value(dynamic_any(base{})), bad_dynamic_any_cast, "base of a bounded type");
+    }
+
+    void test_to_dynamic_any()
+    {
+        derived d;
+        d.a1 = 9;
+        const value v = d;
+
+        dynamic_any open = v.to_dynamic_any();
+        check_equal(open.type(), type_id<derived>(), "type");
+        check_equal(dynamic_any_cast<derived>(open).a1, 9, "value");
+        check_unequal(dynamic_any_cast<derived>(&open), dynamic_any_cast<derived>(&v), "copied");
+
+        check_true(value().to_dynamic_any().empty(), "empty");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
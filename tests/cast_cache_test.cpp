@@ -0,0 +1,281 @@
+// what:  the base-class cast cache under many held types and many threads
+// where: tested with g++ 12, also under -fsanitize=thread
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/dynamic_any.hpp"
+#include "boost/dynamic_any_visit.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_many_held_types();
+    void test_concurrent_casts();
+    void test_concurrent_visits();
+    void test_unregistered_types();
+
+    const test_case test_cases[] =
+    {
+        { "more held types than the per-thread cache", test_many_held_types   },
+        { "concurrent casts",                          test_concurrent_casts  },
+        { "concurrent visits",                         test_concurrent_visits },
+        { "more unregistered types than the tables",   test_unregistered_types }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    struct base
+    {
+        virtual ~base() {}
+        int id;
+    };
+
+    struct unrelated
+    {
+        virtual ~unrelated() {}
+    };
+
+    // padding of a different size in front of base in each held type, so
+    // that every type has its own offset to base
+    template<int N>
+    struct padding
+    {
+        padding() : bytes() {}
+        char bytes[N * sizeof(int) + 1];
+    };
+
+    template<int N>
+    struct item : padding<N>, base
+    {
+        item() { id = N; }
+    };
+
+    struct tag
+    {
+        int tag_id;
+    };
+
+    // not registered: found with dynamic_cast, or by the throw without
+    // it, and cached like the registered ones
+    template<int N>
+    struct unregistered : padding<N % 7>, base, tag
+    {
+        unregistered() { id = N; tag_id = -N; }
+    };
+}
+
+namespace boost
+{
+    // the base has to be registered for casts without RTTI; a template
+    // of held types is registered by partial specialization
+    template<int N>
+    struct dynamic_any_bases<any_tests::item<N> >
+    {
+        static void * cast(any_tests::item<N> * derived, const boost::typeindex::type_info & target)
+        {
+            return detail::dynamic_any::cast_to_base<any_tests::item<N>, any_tests::base>(derived, target);
+        }
+    };
+}
+
+namespace any_tests
+{
+    const int held_types = 32;
+
+    template<int N>
+    void add_items(std::vector<dynamic_any> & values)
+    {
+        add_items<N - 1>(values);
+        values.push_back(item<N - 1>());
+    }
+
+    template<>
+    void add_items<0>(std::vector<dynamic_any> &)
+    {
+    }
+
+    std::vector<dynamic_any> items()
+    {
+        std::vector<dynamic_any> values;
+        add_items<held_types>(values);
+        return values;
+    }
+
+    // number of values whose id is found correctly through their base, and
+    // which fail to cast to an unrelated type, over rounds passes
+    int check_items(std::vector<dynamic_any> & values, int rounds)
+    {
+        int correct = 0;
+        for(int round = 0; round != rounds; ++round)
+            for(std::size_t i = 0; i != values.size(); ++i)
+            {
+                base * b = dynamic_any_cast<base>(&values[i]);
+                if(b && b->id == int(i) && !dynamic_any_cast<unrelated>(&values[i]))
+                    ++correct;
+            }
+        return correct;
+    }
+
+    unsigned thread_count()
+    {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores < 4 ? 4 : cores;
+    }
+
+    void test_many_held_types()
+    {
+        std::vector<dynamic_any> values = items();
+        check_equal(check_items(values, 3), 3 * held_types, "casts to base");
+    }
+
+    void test_concurrent_casts()
+    {
+        const unsigned threads = thread_count();
+        const int rounds = 200;
+        std::vector<int> correct(threads);
+        std::vector<std::thread> workers;
+
+        // each thread has its own values, so only the caches are shared
+        for(unsigned t = 0; t != threads; ++t)
+            workers.push_back(std::thread([&correct, t]() {
+                std::vector<dynamic_any> values = items();
+                correct[t] = check_items(values, rounds);
+            }));
+        for(unsigned t = 0; t != threads; ++t)
+            workers[t].join();
+
+        for(unsigned t = 0; t != threads; ++t)
+            check_equal(correct[t], rounds * held_types, "casts to base in every thread");
+    }
+
+    struct get_id
+    {
+        int operator()(const std::string &) const { return -2; }
+        int operator()(const base & b) const { return b.id; }
+    };
+
+    int unmatched(const dynamic_any &)
+    {
+        return -1;
+    }
+
+    void test_concurrent_visits()
+    {
+        const unsigned threads = thread_count();
+        const int rounds = 200;
+        std::vector<int> correct(threads);
+        std::vector<std::thread> workers;
+
+        for(unsigned t = 0; t != threads; ++t)
+            workers.push_back(std::thread([&correct, t]() {
+                std::vector<dynamic_any> values = items();
+                values.push_back(std::string("text"));
+                values.push_back(1.5);
+                const std::vector<dynamic_any> & cvalues = values;
+
+                for(int round = 0; round != rounds; ++round)
+                {
+                    for(int i = 0; i != held_types; ++i)
+                        if(visit<std::string, base>(cvalues[i], get_id(), unmatched) == i)
+                            ++correct[t];
+                    if(visit<std::string, base>(cvalues[held_types], get_id(), unmatched) == -2
+                    && visit<std::string, base>(cvalues[held_types + 1], get_id(), unmatched) == -1)
+                        ++correct[t];
+                }
+            }));
+        for(unsigned t = 0; t != threads; ++t)
+            workers[t].join();
+
+        for(unsigned t = 0; t != threads; ++t)
+            check_equal(correct[t], rounds * (held_types + 1), "visits in every thread");
+    }
+
+#ifndef BOOST_NO_RTTI
+    const int unregistered_types = 3 * BOOST_DYNAMIC_ANY_SHARED_CAST_CACHE_SIZE / 2;
+
+    template<int N>
+    void add_unregistered(std::vector<dynamic_any> & values)
+    {
+        add_unregistered<N - 1>(values);
+        values.push_back(unregistered<N - 1>());
+    }
+
+    template<>
+    void add_unregistered<0>(std::vector<dynamic_any> &)
+    {
+    }
+
+    int check_unregistered(std::vector<dynamic_any> & values, int rounds)
+    {
+        int correct = 0;
+        for(int round = 0; round != rounds; ++round)
+            for(std::size_t i = 0; i != values.size(); ++i)
+            {
+                base * b = dynamic_any_cast<base>(&values[i]);
+                tag * t = dynamic_any_cast<tag>(&values[i]);
+                if(b && b->id == int(i) && t && t->tag_id == -int(i)
+                && !dynamic_any_cast<unrelated>(&values[i]))
+                    ++correct;
+            }
+        return correct;
+    }
+
+    void test_unregistered_types()
+    {
+        // more held types per target than the shared table holds, so that
+        // it grows, from several threads at once
+        const unsigned threads = thread_count();
+        const int rounds = 20;
+        std::vector<int> correct(threads);
+        std::vector<std::thread> workers;
+
+        for(unsigned t = 0; t != threads; ++t)
+            workers.push_back(std::thread([&correct, t]() {
+                std::vector<dynamic_any> values;
+                add_unregistered<unregistered_types>(values);
+                correct[t] = check_unregistered(values, rounds);
+            }));
+        for(unsigned t = 0; t != threads; ++t)
+            workers[t].join();
+
+        for(unsigned t = 0; t != threads; ++t)
+            check_equal(correct[t], rounds * unregistered_types, "casts to unregistered bases");
+    }
+#else
+    void test_unregistered_types()
+    {
+    }
+#endif
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
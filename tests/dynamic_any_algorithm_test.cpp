@@ -0,0 +1,317 @@
+// what:  unit tests for cast_all and filter over ranges of dynamic_any
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "boost/dynamic_any_algorithm.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_empty_range();
+    void test_exact_type();
+    void test_base_casts();
+    void test_const_range();
+    void test_many_types();
+    void test_output_iterator();
+    void test_type_index();
+    void test_index_many_matches();
+    void test_index_overflow();
+
+    const test_case test_cases[] =
+    {
+        { "empty range",                    test_empty_range     },
+        { "exact type",                     test_exact_type      },
+        { "casts to bases",                 test_base_casts      },
+        { "const elements",                 test_const_range     },
+        { "more types than slots",          test_many_types      },
+        { "any output iterator",            test_output_iterator },
+        { "through a type index",           test_type_index      },
+        { "more matching ids than compares",test_index_many_matches },
+        { "more types than ids",            test_index_overflow  }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    struct base
+    {
+        int a;
+        virtual ~base() {}
+    };
+
+    struct base1
+    {
+        int a1;
+    };
+
+    struct derived : base, base1
+    {
+        explicit derived(int b_) : b(b_) { a = 1; a1 = 2; }
+        int b;
+    };
+
+    template<int N>
+    struct numbered
+    {
+        numbered() : value(N) {}
+        int value;
+    };
+
+    template<int N>
+    struct based : base1
+    {
+        based() { a1 = N; }
+    };
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::derived, any_tests::base, any_tests::base1)
+BOOST_DYNAMIC_ANY_BASES(any_tests::based<1>, any_tests::base1)
+BOOST_DYNAMIC_ANY_BASES(any_tests::based<2>, any_tests::base1)
+BOOST_DYNAMIC_ANY_BASES(any_tests::based<3>, any_tests::base1)
+BOOST_DYNAMIC_ANY_BASES(any_tests::based<4>, any_tests::base1)
+BOOST_DYNAMIC_ANY_BASES(any_tests::based<5>, any_tests::base1)
+
+namespace any_tests
+{
+    using namespace boost;
+
+    void test_empty_range()
+    {
+        std::vector<dynamic_any> values;
+        check_true(filter<int>(values.begin(), values.end()).empty(), "no elements");
+
+        values.resize(3);
+        check_true(filter<int>(values.begin(), values.end()).empty(), "only empty elements");
+    }
+
+    void test_exact_type()
+    {
+        std::vector<dynamic_any> values;
+        values.push_back(1);
+        values.push_back(std::string("text"));
+        values.push_back(dynamic_any());
+        values.push_back(2);
+        values.push_back(3l);
+        values.push_back(3);
+
+        const std::vector<int *> ints = filter<int>(values.begin(), values.end());
+        check_equal(ints.size(), 3u, "all ints found");
+        check_equal(ints[0], dynamic_any_cast<int>(&values[0]), "same pointer as dynamic_any_cast");
+        check_equal(ints[1], dynamic_any_cast<int>(&values[3]), "in order");
+        check_equal(*ints[2], 3, "value");
+
+        *ints[1] = 20;
+        check_equal(dynamic_any_cast<int>(values[3]), 20, "pointers into the elements");
+
+        const std::vector<std::string *> strings = filter<std::string>(values.begin(), values.end());
+        check_equal(strings.size(), 1u, "one string");
+        check_equal(*strings[0], std::string("text"), "string value");
+    }
+
+    void test_base_casts()
+    {
+        std::vector<dynamic_any> values;
+        values.push_back(derived(1));
+        values.push_back(1);
+        values.push_back(derived(2));
+        values.push_back(base1());
+
+        const std::vector<base1 *> bases = filter<base1>(values.begin(), values.end());
+        check_equal(bases.size(), 3u, "derived and exact");
+        for(std::size_t i = 0; i != 3; ++i)
+            check_equal(bases[i], dynamic_any_cast<base1>(&values[i == 0 ? 0 : i + 1]),
+                "adjusted as dynamic_any_cast would");
+        check_equal(static_cast<derived *>(bases[1])->b, 2, "second base of the second element");
+
+        check_equal(filter<base>(values.begin(), values.end()).size(), 2u, "first base");
+        check_true(filter<derived>(values.begin() + 3, values.end()).empty(), "no downcasts");
+    }
+
+    void test_const_range()
+    {
+        std::list<dynamic_any> values;
+        values.push_back(derived(3));
+        values.push_back(std::string("text"));
+        const std::list<dynamic_any> & view = values;
+
+        const std::vector<const base *> bases = filter<base>(view.begin(), view.end());
+        check_equal(bases.size(), 1u, "const elements give const pointers");
+        check_equal(bases[0], dynamic_any_cast<base>(&view.front()), "same pointer as dynamic_any_cast");
+    }
+
+    void test_many_types()
+    {
+        // more held types than BOOST_DYNAMIC_ANY_BATCH_CAST_SLOTS, so that
+        // slots are taken over by other types and decided again
+        std::vector<dynamic_any> values;
+        for(int round = 0; round != 3; ++round)
+        {
+            values.push_back(numbered<1>());  values.push_back(numbered<2>());
+            values.push_back(numbered<3>());  values.push_back(numbered<4>());
+            values.push_back(numbered<5>());  values.push_back(numbered<6>());
+            values.push_back(numbered<7>());  values.push_back(numbered<8>());
+            values.push_back(numbered<9>());  values.push_back(numbered<10>());
+            values.push_back(numbered<11>()); values.push_back(numbered<12>());
+            values.push_back(numbered<13>()); values.push_back(numbered<14>());
+            values.push_back(numbered<15>()); values.push_back(numbered<16>());
+            values.push_back(numbered<17>()); values.push_back(numbered<18>());
+            values.push_back(round);
+        }
+
+        const std::vector<int *> ints = filter<int>(values.begin(), values.end());
+        check_equal(ints.size(), 3u, "ints among many types");
+        check_equal(*ints[2], 2, "last int");
+
+        const std::vector<numbered<17> *> seventeens =
+            filter<numbered<17> >(values.begin(), values.end());
+        check_equal(seventeens.size(), 3u, "each of many types");
+        check_equal(seventeens[1]->value, 17, "value");
+    }
+
+    void test_output_iterator()
+    {
+        std::vector<dynamic_any> values;
+        values.push_back(1);
+        values.push_back(2l);
+        values.push_back(3);
+
+        int * found[3] = { 0, 0, 0 };
+        int ** last = cast_all<int>(values.begin(), values.end(), found);
+        check_equal(last, found + 2, "end of the output returned");
+        check_equal(*found[1], 3, "written in order");
+        check_null(found[2], "nothing written past the end");
+    }
+
+    // the same pointers as filter without the index
+    template<typename ValueType, typename Range>
+    bool same_as_unindexed(Range & values)
+    {
+        const dynamic_any_type_index index(values.begin(), values.end());
+        return filter<ValueType>(index, values.begin(), values.end())
+            == filter<ValueType>(values.begin(), values.end());
+    }
+
+    void test_type_index()
+    {
+        std::vector<dynamic_any> values;
+        for(int round = 0; round != 20; ++round)
+        {
+            values.push_back(round);
+            values.push_back(std::string("text"));
+            values.push_back(dynamic_any());
+            values.push_back(derived(round));
+            values.push_back(base1());
+        }
+
+        const dynamic_any_type_index index(values.begin(), values.end());
+        check_equal(index.size(), values.size(), "one id per element");
+        check_equal(int(index[2]), 0, "empty elements have id 0");
+        check_equal(index[5], index[0], "same type, same id");
+
+        const std::vector<int *> ints = filter<int>(index, values.begin(), values.end());
+        check_equal(ints.size(), 20u, "all ints found");
+        check_equal(ints[7], dynamic_any_cast<int>(&values[35]), "same pointer as dynamic_any_cast");
+        check_equal(*ints[19], 19, "in order");
+
+        check_true(same_as_unindexed<base1>(values), "bases of two types");
+        check_true(same_as_unindexed<base>(values), "first base");
+        check_true(same_as_unindexed<std::string>(values), "one type");
+        check_true(same_as_unindexed<long>(values), "no type");
+
+        const std::vector<dynamic_any> & view = values;
+        const std::vector<const base1 *> bases = filter<base1>(index, view.begin(), view.end());
+        check_equal(bases.size(), 40u, "const elements give const pointers");
+        check_equal(static_cast<const derived *>(bases[2])->b, 1, "adjusted as dynamic_any_cast would");
+
+        dynamic_any_type_index grown;
+        std::vector<dynamic_any> appended;
+        for(int i = 0; i != 40; ++i)
+        {
+            appended.push_back(i % 3 ? dynamic_any(i) : dynamic_any(derived(i)));
+            grown.push_back(appended.back());
+        }
+        check_equal(filter<base>(grown, appended.begin(), appended.end()).size(), 14u,
+            "kept up to date by push_back");
+    }
+
+    void test_index_many_matches()
+    {
+        // more matching held types than the SIMD scan compares at once
+        std::vector<dynamic_any> values;
+        for(int round = 0; round != 10; ++round)
+        {
+            values.push_back(based<1>()); values.push_back(round);
+            values.push_back(based<2>()); values.push_back(based<3>());
+            values.push_back(based<4>()); values.push_back(based<5>());
+            values.push_back(base1());    values.push_back(derived(round));
+        }
+
+        check_true(same_as_unindexed<base1>(values), "same elements as without the index");
+        const dynamic_any_type_index index(values.begin(), values.end());
+        check_equal(filter<base1>(index, values.begin(), values.end()).size(), 70u,
+            "all seven matching types");
+    }
+
+    template<int N>
+    void push_numbered(std::vector<dynamic_any> & values)
+    {
+        values.push_back(numbered<N>());
+        push_numbered<N - 1>(values);
+    }
+
+    template<>
+    void push_numbered<0>(std::vector<dynamic_any> & values)
+    {
+        values.push_back(numbered<0>());
+    }
+
+    void test_index_overflow()
+    {
+        // ints and the types after the first 254 share the last id
+        std::vector<dynamic_any> values;
+        push_numbered<259>(values);
+        values.push_back(1);
+        push_numbered<259>(values);
+        values.push_back(2);
+
+        const dynamic_any_type_index index(values.begin(), values.end());
+        check_equal(int(index[values.size() - 1]), 255, "one id for the rest");
+
+        const std::vector<int *> ints = filter<int>(index, values.begin(), values.end());
+        check_equal(ints.size(), 2u, "found past the last id");
+        check_equal(*ints[1], 2, "in order");
+        check_true(same_as_unindexed<numbered<0> >(values), "a type with no id of its own");
+        check_true(same_as_unindexed<numbered<259> >(values), "a type with an id");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
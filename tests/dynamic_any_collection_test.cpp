@@ -0,0 +1,228 @@
+// what:  unit tests for boost::dynamic_any_collection
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include "boost/dynamic_any_collection.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_default_ctor();
+    void test_insert();
+    void test_insert_own_element();
+    void test_for_each();
+    void test_for_each_base();
+    void test_copy_and_move();
+    void test_clear();
+
+    const test_case test_cases[] =
+    {
+        { "default construction",           test_default_ctor   },
+        { "insert and emplace",             test_insert         },
+        { "insert of own element",          test_insert_own_element },
+        { "for_each visits exact type",     test_for_each       },
+        { "for_each_base visits bases",     test_for_each_base  },
+        { "copy and move",                  test_copy_and_move  },
+        { "clear",                          test_clear          }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    struct shape
+    {
+        virtual ~shape() {}
+        virtual int area() const = 0;
+    };
+
+    struct tag
+    {
+        int id;
+    };
+
+    struct square : tag, shape
+    {
+        explicit square(int side_) : side(side_) { id = 1; }
+        int area() const { return side * side; }
+        int side;
+    };
+
+    struct rectangle : shape, tag
+    {
+        rectangle(int w_, int h_) : w(w_), h(h_) { id = 2; }
+        int area() const { return w * h; }
+        int w, h;
+    };
+
+    struct counted
+    {
+        counted() { ++live; }
+        counted(const counted &) { ++live; }
+        ~counted() { --live; }
+        static int live;
+    };
+
+    int counted::live = 0;
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::square, any_tests::tag, any_tests::shape)
+BOOST_DYNAMIC_ANY_BASES(any_tests::rectangle, any_tests::shape, any_tests::tag)
+
+namespace any_tests
+{
+    void test_default_ctor()
+    {
+        const dynamic_any_collection values;
+
+        check_true(values.empty(), "empty");
+        check_equal(values.size(), 0u, "size");
+        check_equal(values.count<int>(), 0u, "count<int>");
+    }
+
+    void test_insert()
+    {
+        dynamic_any_collection values;
+        values.insert(1);
+        values.insert(std::string("one"));
+        values.insert(2);
+        std::string & text = values.emplace<std::string>(2u, 'x');
+
+        check_equal(text, std::string("xx"), "emplaced in place");
+        check_equal(values.size(), 4u, "size");
+        check_equal(values.count<int>(), 2u, "count<int>");
+        check_equal(values.count<const std::string>(), 2u, "count<const std::string>");
+        check_equal(values.count<double>(), 0u, "count of absent type");
+    }
+
+    void test_insert_own_element()
+    {
+        dynamic_any_collection values;
+        std::string * last = &values.emplace<std::string>("a string too long for the small buffer");
+        for(int i = 0; i != 10; ++i)
+            last = &values.emplace<std::string>(*last);
+
+        check_equal(values.count<std::string>(), 11u, "count");
+        bool intact = true;
+        values.for_each<std::string>([&](const std::string & s)
+            { intact = intact && s == "a string too long for the small buffer"; });
+        check_true(intact, "copied before the segment grew");
+    }
+
+    void test_for_each()
+    {
+        dynamic_any_collection values;
+        for(int i = 1; i <= 100; ++i)
+        {
+            values.insert(i);
+            values.insert(square(i));
+        }
+
+        int sum = 0;
+        int previous = 0;
+        bool ordered = true;
+        values.for_each<int>([&](int & i) { sum += i; ordered = ordered && i > previous; previous = i; });
+        check_equal(sum, 5050, "sum of ints");
+        check_true(ordered, "insertion order kept within a segment");
+
+        values.for_each<square>([](square & s) { s.side = 1; });
+        int area = 0;
+        const dynamic_any_collection & cvalues = values;
+        cvalues.for_each<square>([&](const square & s) { area += s.area(); });
+        check_equal(area, 100, "modified through for_each");
+
+        int shapes = 0;
+        values.for_each<shape>([&](shape &) { ++shapes; });
+        check_equal(shapes, 0, "for_each matches the exact type only");
+    }
+
+    void test_for_each_base()
+    {
+        dynamic_any_collection values;
+        values.insert(square(2));
+        values.insert(rectangle(2, 3));
+        values.insert(7);
+        values.insert(square(3));
+        values.insert(rectangle(1, 5));
+
+        int area = 0;
+        values.for_each_base<shape>([&](shape & s) { area += s.area(); });
+        check_equal(area, 4 + 6 + 9 + 5, "areas through the shape base");
+
+        int ids = 0;
+        const dynamic_any_collection & cvalues = values;
+        cvalues.for_each_base<tag>([&](const tag & t) { ids += t.id; });
+        check_equal(ids, 1 + 2 + 1 + 2, "ids through the tag base");
+
+        int ints = 0;
+        values.for_each_base<int>([&](int & i) { ints += i; });
+        check_equal(ints, 7, "scalars match their own type");
+    }
+
+    void test_copy_and_move()
+    {
+        {
+            dynamic_any_collection values;
+            values.insert(counted());
+            values.insert(counted());
+            values.insert(std::string("test message"));
+
+            dynamic_any_collection copy = values;
+            check_equal(counted::live, 4, "copied elements");
+            check_equal(copy.count<std::string>(), 1u, "copied string");
+
+            dynamic_any_collection moved = std::move(values);
+            check_true(values.empty(), "moved-from collection is empty");
+            check_equal(counted::live, 4, "move does not copy");
+
+            copy = moved;
+            check_equal(counted::live, 4, "copy assignment replaced elements");
+        }
+        check_equal(counted::live, 0, "elements destroyed");
+    }
+
+    void test_clear()
+    {
+        dynamic_any_collection values;
+        values.insert(counted());
+        values.insert(1);
+        values.clear();
+
+        check_equal(counted::live, 0, "clear destroys all elements");
+        check_true(values.empty(), "empty after clear");
+
+        values.insert(2);
+        check_equal(values.count<int>(), 1u, "insert after clear");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
@@ -0,0 +1,283 @@
+// what:  parallel_for_each, parallel_transform and parallel_reduce over
+//        ranges of dynamic_any, and the executor under them
+// where: tested with g++ 12, also under -fsanitize=thread
+
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/dynamic_any_parallel.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_executor_runs();
+    void test_nested_runs();
+    void test_exceptions();
+    void test_for_each();
+    void test_transform();
+    void test_reduce();
+
+    const test_case test_cases[] =
+    {
+        { "every chunk run once",           test_executor_runs },
+        { "runs started from a body",       test_nested_runs   },
+        { "exceptions from a body",         test_exceptions    },
+        { "for_each by held type",          test_for_each      },
+        { "transform with fallback",        test_transform     },
+        { "reduce in order",                test_reduce        }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    struct shape
+    {
+        virtual ~shape() {}
+        int sides;
+    };
+
+    struct square : shape
+    {
+        square() { sides = 4; }
+    };
+
+    struct triangle : shape
+    {
+        triangle() { sides = 3; }
+    };
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::square, any_tests::shape)
+BOOST_DYNAMIC_ANY_BASES(any_tests::triangle, any_tests::shape)
+
+namespace any_tests
+{
+    const std::size_t count = 20 * BOOST_DYNAMIC_ANY_PARALLEL_CHUNK + 7;
+
+    // runs of several lengths, some across chunk boundaries, of ints,
+    // strings, shapes and empty values
+    std::vector<dynamic_any> mixed()
+    {
+        std::vector<dynamic_any> values;
+        values.reserve(count);
+        for(std::size_t i = 0; values.size() != count; ++i)
+            for(std::size_t n = 0; n != i % 50 + 1 && values.size() != count; ++n)
+                switch(i % 5)
+                {
+                case 0: values.push_back(int(values.size())); break;
+                case 1: values.push_back(std::string("ab")); break;
+                case 2: values.push_back(square()); break;
+                case 3: values.push_back(triangle()); break;
+                default: values.push_back(dynamic_any()); break;
+                }
+        return values;
+    }
+
+    struct mark
+    {
+        std::vector<std::atomic<int> > * calls;
+
+        void operator()(std::size_t chunk) const
+        {
+            ++(*calls)[chunk];
+        }
+    };
+
+    void test_executor_runs()
+    {
+        for(std::size_t threads = 1; threads != 5; ++threads)
+        {
+            parallel_executor executor(threads);
+            check_equal(executor.concurrency(), threads, "concurrency");
+            for(std::size_t chunks = 0; chunks < 70; chunks += 23)
+            {
+                std::vector<std::atomic<int> > calls(chunks);
+                for(std::size_t i = 0; i != chunks; ++i)
+                    calls[i] = 0;
+                mark body = { &calls };
+                executor.run(chunks, body);
+                for(std::size_t i = 0; i != chunks; ++i)
+                    check_equal(calls[i].load(), 1, "each chunk once");
+            }
+        }
+    }
+
+    struct nested
+    {
+        parallel_executor * executor;
+        std::atomic<int> * total;
+
+        void operator()(std::size_t) const
+        {
+            std::vector<std::atomic<int> > calls(4);
+            for(std::size_t i = 0; i != calls.size(); ++i)
+                calls[i] = 0;
+            mark inner = { &calls };
+            executor->run(calls.size(), inner);
+            for(std::size_t i = 0; i != calls.size(); ++i)
+                *total += calls[i];
+        }
+    };
+
+    void test_nested_runs()
+    {
+        parallel_executor executor(3);
+        std::atomic<int> total(0);
+        nested body = { &executor, &total };
+        executor.run(10, body);
+        check_equal(total.load(), 40, "inner runs done by the outer chunks");
+    }
+
+    struct fail_at
+    {
+        std::size_t chunk;
+
+        void operator()(std::size_t i) const
+        {
+            if(i == chunk)
+                throw std::runtime_error("chunk failed");
+        }
+    };
+
+    void test_exceptions()
+    {
+        parallel_executor executor(3);
+        fail_at body = { 17 };
+        TEST_CHECK_THROW(executor.run(40, body), std::runtime_error, "rethrown from run");
+
+        std::vector<std::atomic<int> > calls(40);
+        for(std::size_t i = 0; i != calls.size(); ++i)
+            calls[i] = 0;
+        mark after = { &calls };
+        executor.run(calls.size(), after);
+        check_equal(calls[39].load(), 1, "usable after a failed run");
+    }
+
+    struct count_sides
+    {
+        std::atomic<long> * sides;
+        std::atomic<long> * shapes;
+
+        void operator()(shape & s) const
+        {
+            *sides += s.sides;
+            ++*shapes;
+        }
+    };
+
+    void test_for_each()
+    {
+        std::vector<dynamic_any> values = mixed();
+        long sides = 0, shapes = 0;
+        for(std::size_t i = 0; i != values.size(); ++i)
+            if(shape * s = dynamic_any_cast<shape>(&values[i]))
+            {
+                sides += s->sides;
+                ++shapes;
+            }
+
+        parallel_executor executor(4);
+        std::atomic<long> parallel_sides(0), parallel_shapes(0);
+        count_sides f = { &parallel_sides, &parallel_shapes };
+        parallel_for_each<shape>(executor, values.begin(), values.end(), f);
+        check_equal(parallel_shapes.load(), shapes, "every shape, by its base");
+        check_equal(parallel_sides.load(), sides, "values cast to the base");
+
+        std::atomic<long> texts(0);
+        const std::vector<dynamic_any> & view = values;
+        parallel_for_each<std::string>(view.begin(), view.end(),
+            [&](const std::string & s) { texts += long(s.size()); });
+        check_true(texts.load() > 0, "const elements on the default executor");
+    }
+
+    struct describe
+    {
+        long operator()(int & i) const { return i; }
+        long operator()(std::string & s) const { return -long(s.size()); }
+        long operator()(shape & s) const { return 1000 + s.sides; }
+    };
+
+    long unmatched(dynamic_any & value)
+    {
+        return value.empty() ? -100 : -200;
+    }
+
+    void test_transform()
+    {
+        std::vector<dynamic_any> values = mixed();
+        std::vector<long> expected(values.size());
+        for(std::size_t i = 0; i != values.size(); ++i)
+            expected[i] = visit<int, std::string, shape>(values[i], describe(), &unmatched);
+
+        parallel_executor executor(4);
+        std::vector<long> results(values.size());
+        std::vector<long>::iterator last = parallel_transform<int, std::string, shape>(
+            executor, values.begin(), values.end(), results.begin(), describe(), &unmatched);
+        check_true(last == results.end(), "end of the output returned");
+        check_true(results == expected, "each element in its place");
+
+        TEST_CHECK_THROW((parallel_transform<int, std::string>(
+            executor, values.begin(), values.end(), results.begin(), describe())),
+            bad_dynamic_any_cast, "element holding none of the types");
+    }
+
+    struct digits
+    {
+        std::string operator()(const int & i) const { return std::string(1, char('0' + i % 10)); }
+    };
+
+    struct concatenate
+    {
+        std::string operator()(const std::string & a, const std::string & b) const { return a + b; }
+    };
+
+    void test_reduce()
+    {
+        const std::vector<dynamic_any> values = mixed();
+        std::string expected;
+        for(std::size_t i = 0; i != values.size(); ++i)
+            if(const int * p = dynamic_any_cast<int>(&values[i]))
+                expected += digits()(*p);
+
+        parallel_executor executor(4);
+        check_equal(parallel_reduce<int>(executor, values.begin(), values.end(),
+            std::string(), digits(), concatenate()), expected, "combined in order");
+        check_equal(parallel_reduce<int>(executor, values.begin(), values.end(),
+            std::string(">"), digits(), concatenate()), ">" + expected, "init combined once");
+
+        check_equal(parallel_reduce<std::string>(values.begin(), values.begin(),
+            std::string("init"), [](const std::string & s) { return s; }, concatenate()),
+            std::string("init"), "empty range");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
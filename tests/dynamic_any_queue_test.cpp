@@ -0,0 +1,328 @@
+// what:  dynamic_any_queue with one thread, and under many producers and
+//        consumers at once
+// where: tested with g++ 12, also under -fsanitize=thread
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/dynamic_any_queue.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_capacity();
+    void test_fifo();
+    void test_full_and_empty();
+    void test_no_allocation();
+    void test_large_values();
+    void test_stateful_allocator();
+    void test_other_allocators();
+    void test_cache_lines();
+    void test_producers_and_consumers();
+
+    const test_case test_cases[] =
+    {
+        { "capacity",                       test_capacity                },
+        { "first in, first out",            test_fifo                    },
+        { "full and empty",                 test_full_and_empty          },
+        { "small values not allocated",     test_no_allocation           },
+        { "large values on the heap",       test_large_values            },
+        { "cells take the queue's allocator", test_stateful_allocator    },
+        { "values with other allocators",   test_other_allocators        },
+        { "cells on cache lines",           test_cache_lines             },
+        { "many producers and consumers",   test_producers_and_consumers }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    std::atomic<unsigned> allocations(0);
+
+    template<typename T>
+    struct counting_allocator
+    {
+        typedef T value_type;
+
+        counting_allocator() {}
+
+        template<typename U>
+        counting_allocator(const counting_allocator<U> &) {}
+
+        T * allocate(std::size_t n)
+        {
+            ++allocations;
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T * p, std::size_t)
+        {
+            ::operator delete(p);
+        }
+
+        bool operator==(const counting_allocator &) const { return true; }
+        bool operator!=(const counting_allocator &) const { return false; }
+    };
+
+    // set to make every pool_allocator fail
+    bool pools_exhausted = false;
+
+    // unequal to one drawing from another pool
+    template<typename T>
+    struct pool_allocator
+    {
+        typedef T value_type;
+
+        explicit pool_allocator(unsigned * pool = 0) : pool(pool) {}
+
+        template<typename U>
+        pool_allocator(const pool_allocator<U> & other) : pool(other.pool) {}
+
+        T * allocate(std::size_t n)
+        {
+            if(pools_exhausted)
+                throw std::bad_alloc();
+            ++*pool;
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T * p, std::size_t)
+        {
+            ::operator delete(p);
+        }
+
+        bool operator==(const pool_allocator & other) const { return pool == other.pool; }
+        bool operator!=(const pool_allocator & other) const { return pool != other.pool; }
+
+        unsigned * pool;
+    };
+
+    struct large
+    {
+        char data[256];
+    };
+
+    void test_capacity()
+    {
+        check_equal(dynamic_any_queue(0).capacity(), 2u, "at least two");
+        check_equal(dynamic_any_queue(5).capacity(), 8u, "rounded up");
+        check_equal(dynamic_any_queue(64).capacity(), 64u, "power of two kept");
+        check_true(dynamic_any_queue(4).empty(), "empty");
+    }
+
+    void test_fifo()
+    {
+        dynamic_any_queue queue(4);
+        for(int round = 0; round != 3; ++round)
+        {
+            queue.push(dynamic_any(1));
+            queue.push(dynamic_any(std::string("two")));
+            const dynamic_any three = 3.0;
+            queue.push(three);
+
+            check_equal(dynamic_any_cast<int>(queue.pop()), 1, "first");
+            check_equal(dynamic_any_cast<std::string>(queue.pop()), std::string("two"), "second");
+            check_equal(dynamic_any_cast<double>(queue.pop()), 3.0, "copy pushed");
+            check_true(queue.empty(), "emptied");
+        }
+    }
+
+    void test_full_and_empty()
+    {
+        dynamic_any_queue queue(2);
+        dynamic_any value;
+        check_false(queue.try_pop(value), "pop from an empty queue");
+        check_true(value.empty(), "nothing popped");
+
+        check_true(queue.try_push(dynamic_any(1)), "push");
+        check_true(queue.try_push(dynamic_any(2)), "push");
+        dynamic_any rejected = 3;
+        check_false(queue.try_push(static_cast<dynamic_any &&>(rejected)), "push to a full queue");
+        check_equal(dynamic_any_cast<int>(rejected), 3, "rejected value left alone");
+
+        value = std::string("overwritten");
+        check_true(queue.try_pop(value), "pop");
+        check_equal(dynamic_any_cast<int>(value), 1, "value replaced");
+        check_true(queue.try_push(static_cast<dynamic_any &&>(rejected)), "room again");
+        check_true(rejected.empty(), "pushed value moved from");
+    }
+
+    void test_no_allocation()
+    {
+        typedef basic_dynamic_any<counting_allocator<char> > counted_any;
+        basic_dynamic_any_queue<counting_allocator<char> > queue(8);
+        counted_any value;
+
+        allocations = 0;
+        for(int i = 0; i != 100; ++i)
+        {
+            queue.push(counted_any(i));
+            queue.push(counted_any(double(i)));
+            check_true(queue.try_pop(value), "int popped");
+            check_equal(dynamic_any_cast<int>(value), i, "int");
+            check_true(queue.try_pop(value), "double popped");
+        }
+        check_equal(allocations.load(), 0u, "no allocation for inline values");
+    }
+
+    void test_large_values()
+    {
+        typedef basic_dynamic_any<counting_allocator<char> > counted_any;
+        basic_dynamic_any_queue<counting_allocator<char> > queue(8);
+
+        large l = large();
+        l.data[255] = 'x';
+        counted_any value = l;
+        const large * address = dynamic_any_cast<large>(&value);
+
+        allocations = 0;
+        queue.push(static_cast<counted_any &&>(value));
+        counted_any popped;
+        check_true(queue.try_pop(popped), "popped");
+        check_equal(allocations.load(), 0u, "heap value passed along");
+        check_equal(dynamic_any_cast<large>(&popped), address, "same heap value");
+        check_equal(dynamic_any_cast<large>(popped).data[255], 'x', "contents");
+    }
+
+    void test_stateful_allocator()
+    {
+        typedef basic_dynamic_any<pool_allocator<char> > pool_any;
+
+        unsigned pool = 0;
+        const pool_allocator<char> alloc(&pool);
+        basic_dynamic_any_queue<pool_allocator<char> > queue(4, alloc);
+        check_equal(pool, 1u, "buffer from the queue's allocator");
+
+        pool_any value(large(), alloc), popped(alloc);
+        const large * address = dynamic_any_cast<large>(&value);
+        queue.push(static_cast<pool_any &&>(value));
+        check_true(queue.try_pop(popped), "popped");
+        check_equal(pool, 2u, "heap value passed along");
+        check_equal(dynamic_any_cast<large>(&popped), address, "same heap value");
+    }
+
+    void test_other_allocators()
+    {
+        typedef basic_dynamic_any<pool_allocator<char> > pool_any;
+
+        unsigned queue_pool = 0, other_pool = 0;
+        const pool_allocator<char> other(&other_pool);
+        basic_dynamic_any_queue<pool_allocator<char> > queue(2, pool_allocator<char>(&queue_pool));
+
+        large l;
+        l.data[0] = 'x';
+        pool_any value(l, other), popped(other);
+        queue.push(static_cast<pool_any &&>(value));
+        check_equal(queue_pool, 2u, "moved to the queue's allocator");
+        check_true(queue.try_pop(popped), "popped");
+        check_equal(other_pool, 2u, "moved back to the other allocator");
+        check_equal(dynamic_any_cast<large>(popped).data[0], 'x', "contents");
+
+        pool_any failing(l, other);
+        pools_exhausted = true;
+        TEST_CHECK_THROW(
+            queue.try_push(static_cast<pool_any &&>(failing)),
+            std::bad_alloc,
+            "failed move to the queue's allocator");
+        pools_exhausted = false;
+        check_true(queue.empty(), "nothing pushed");
+
+        queue.push(pool_any(1, other));
+        check_true(queue.try_pop(popped), "no cell left claimed");
+        check_equal(dynamic_any_cast<int>(popped), 1, "next value");
+    }
+
+    void test_cache_lines()
+    {
+        typedef detail::dynamic_any_queue::cell<std::allocator<char> > cell;
+        const std::size_t line = detail::dynamic_any_queue::cache_line;
+
+        check_equal(alignof(cell), line, "cells aligned to cache lines");
+        check_equal(sizeof(cell) % line, 0u, "cells fill whole lines");
+        check_equal(alignof(detail::dynamic_any_queue::position), line, "positions aligned");
+        check_equal(sizeof(detail::dynamic_any_queue::position), line, "positions fill a line");
+    }
+
+    const int producers = 3, consumers = 3, per_producer = 20000;
+
+    void produce(dynamic_any_queue * queue, int id)
+    {
+        for(int i = 0; i != per_producer; ++i)
+            if(i % 7 == 0)
+                queue->push(dynamic_any(std::string(40, char('a' + id))));
+            else
+                queue->push(dynamic_any(id * per_producer + i));
+    }
+
+    void consume(dynamic_any_queue * queue, std::atomic<long> * sum, std::atomic<int> * texts)
+    {
+        dynamic_any value;
+        for(int i = 0; i != producers * per_producer / consumers; ++i)
+        {
+            value = queue->pop();
+            if(const int * n = dynamic_any_cast<int>(&value))
+                *sum += *n;
+            else
+                *texts += int(dynamic_any_cast<std::string>(value).size());
+        }
+    }
+
+    void test_producers_and_consumers()
+    {
+        dynamic_any_queue queue(64);
+        std::atomic<long> sum(0);
+        std::atomic<int> texts(0);
+
+        long expected_sum = 0;
+        int expected_texts = 0;
+        for(int id = 0; id != producers; ++id)
+            for(int i = 0; i != per_producer; ++i)
+                if(i % 7 == 0)
+                    expected_texts += 40;
+                else
+                    expected_sum += id * per_producer + i;
+
+        std::vector<std::thread> threads;
+        for(int id = 0; id != producers; ++id)
+            threads.push_back(std::thread(&produce, &queue, id));
+        for(int id = 0; id != consumers; ++id)
+            threads.push_back(std::thread(&consume, &queue, &sum, &texts));
+        for(std::size_t i = 0; i != threads.size(); ++i)
+            threads[i].join();
+
+        check_equal(sum.load(), expected_sum, "every number once");
+        check_equal(texts.load(), expected_texts, "every string once");
+        check_true(queue.empty(), "drained");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
@@ -0,0 +1,229 @@
+// what:  unit tests for boost::dynamic_any_reader and mapped_dynamic_any_file
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// small windows, so that reading the test file crosses many of them
+#define BOOST_DYNAMIC_ANY_READ_AHEAD 4096u
+
+#include "boost/dynamic_any_reader.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_read_buffer();
+    void test_views();
+    void test_mapped_file();
+    void test_empty_file();
+    void test_malformed();
+
+    const test_case test_cases[] =
+    {
+        { "reading a buffer",       test_read_buffer },
+        { "views of records",       test_views       },
+        { "reading a mapped file",  test_mapped_file },
+        { "empty file",             test_empty_file  },
+        { "malformed records",      test_malformed   }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    struct point
+    {
+        int x, y;
+    };
+
+    const char * const file_name = "dynamic_any_reader_test.bin";
+
+    dynamic_any_registry make_registry()
+    {
+        dynamic_any_registry registry;
+        registry.add<int>(1);
+        registry.add<double>(2);
+        registry.add<point>(3);
+        registry.add<std::string>(4);
+        return registry;
+    }
+
+    std::vector<char> encode(const dynamic_any_registry & registry, const std::vector<dynamic_any> & values)
+    {
+        std::vector<char> buffer;
+        for(std::size_t i = 0; i != values.size(); ++i)
+            registry.encode(values[i], buffer);
+        return buffer;
+    }
+
+    std::vector<dynamic_any> sample()
+    {
+        std::vector<dynamic_any> values;
+        values.push_back(1);
+        values.push_back(std::string("two"));
+        values.push_back(3.0);
+        values.push_back(dynamic_any());
+        point p = { 4, 5 };
+        values.push_back(p);
+        return values;
+    }
+
+    void test_read_buffer()
+    {
+        const dynamic_any_registry registry = make_registry();
+        const std::vector<char> buffer = encode(registry, sample());
+
+        dynamic_any_reader reader(registry, buffer.data(), buffer.size());
+        dynamic_any value;
+
+        check_true(reader.next(value), "first");
+        check_equal(dynamic_any_cast<int>(value), 1, "int");
+        check_true(reader.next(value), "second");
+        check_equal(dynamic_any_cast<std::string>(value), std::string("two"), "string");
+        check_true(reader.next(value), "third");
+        check_equal(dynamic_any_cast<double>(value), 3.0, "double");
+        check_true(reader.next(value), "fourth");
+        check_true(value.empty(), "empty");
+        check_true(reader.next(value), "fifth");
+        check_equal(dynamic_any_cast<point>(value).y, 5, "point");
+
+        check_true(reader.done(), "done");
+        check_equal(reader.position(), buffer.size(), "position at end");
+        check_false(reader.next(value), "no more records");
+    }
+
+    void test_views()
+    {
+        const dynamic_any_registry registry = make_registry();
+        const std::vector<char> buffer = encode(registry, sample());
+        const char * first = buffer.data();
+        const char * last = first + buffer.size();
+
+        dynamic_any_reader reader(registry, buffer.data(), buffer.size());
+        any_ref view;
+
+        reader.next(view);
+        const int * i = view.const_ptr<int>();
+        check_non_null(i, "int view");
+        check_true(reinterpret_cast<const char *>(i) >= first && reinterpret_cast<const char *>(i) < last,
+                   "int viewed in place");
+        check_false(view.is_mutable(), "views are read-only");
+
+        reader.next(view);
+        const std::string * s = view.const_ptr<std::string>();
+        check_non_null(s, "string view");
+        check_equal(*s, std::string("two"), "string decoded");
+
+        reader.next(view);
+        check_equal(static_cast<const double &>(view), 3.0, "double view");
+
+        reader.next(view);
+        check_null(view.const_ptr<int>(), "empty record");
+
+        reader.next(view);
+        check_equal(static_cast<const point &>(view).x, 4, "point view");
+        check_false(reader.next(view), "no more records");
+    }
+
+    void test_mapped_file()
+    {
+        const dynamic_any_registry registry = make_registry();
+        const int count = 20000;
+
+        long expected = 0;
+        {
+            std::vector<char> buffer;
+            for(int i = 0; i != count; ++i)
+            {
+                registry.encode(i % 3 ? dynamic_any(i) : dynamic_any(std::string(i % 7, 'x')), buffer);
+                expected += i % 3 ? i : i % 7;
+            }
+            std::ofstream file(file_name, std::ios::binary);
+            file.write(buffer.data(), buffer.size());
+        }
+
+        long total = 0;
+        int records = 0;
+        {
+            const mapped_dynamic_any_file file(file_name);
+            check_true(file.size() > 10 * BOOST_DYNAMIC_ANY_READ_AHEAD, "file spans many windows");
+
+            dynamic_any_reader reader(registry, file);
+            any_ref view;
+            while(reader.next(view))
+            {
+                if(const int * i = view.const_ptr<int>())
+                    total += *i;
+                else
+                    total += static_cast<const std::string &>(view).size();
+                ++records;
+            }
+        }
+        std::remove(file_name);
+
+        check_equal(records, count, "records read");
+        check_equal(total, expected, "values read");
+    }
+
+    void test_empty_file()
+    {
+        std::ofstream(file_name, std::ios::binary).close();
+        {
+            const dynamic_any_registry registry = make_registry();
+            const mapped_dynamic_any_file file(file_name);
+            check_equal(file.size(), 0u, "size");
+
+            dynamic_any_reader reader(registry, file);
+            dynamic_any value;
+            check_true(reader.done(), "done");
+            check_false(reader.next(value), "no records");
+        }
+        std::remove(file_name);
+
+        TEST_CHECK_THROW(mapped_dynamic_any_file file(file_name),
+            boost::interprocess::interprocess_exception, "no file");
+    }
+
+    void test_malformed()
+    {
+        const dynamic_any_registry registry = make_registry();
+        const std::vector<char> buffer = encode(registry, sample());
+
+        dynamic_any_reader reader(registry, buffer.data(), buffer.size() - 1);
+        dynamic_any value;
+        for(int i = 0; i != 4; ++i)
+            reader.next(value);
+        TEST_CHECK_THROW(reader.next(value), bad_dynamic_any_encoding, "truncated last record");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
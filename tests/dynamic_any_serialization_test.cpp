@@ -0,0 +1,269 @@
+// what:  unit tests for boost::dynamic_any_registry encoding and decoding
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "boost/dynamic_any_serialization.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_scalar_round_trip();
+    void test_class_round_trip();
+    void test_custom_codec();
+    void test_empty();
+    void test_record_sequence();
+    void test_decode_in_place();
+    void test_errors();
+
+    const test_case test_cases[] =
+    {
+        { "scalar round trip",                test_scalar_round_trip },
+        { "trivially copyable class",         test_class_round_trip  },
+        { "strings and specialized codecs",   test_custom_codec      },
+        { "empty value",                      test_empty             },
+        { "sequence of records",              test_record_sequence   },
+        { "decoding over the same held type", test_decode_in_place   },
+        { "encoding errors",                  test_errors            }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    enum colour { red, green, blue };
+
+    struct point
+    {
+        int x, y;
+    };
+
+    // too large for the inline buffer
+    struct block
+    {
+        double values[16];
+    };
+
+    struct unregistered {};
+}
+
+namespace boost
+{
+    // a codec for a type that is not trivially copyable
+    template<>
+    struct dynamic_any_codec<std::vector<int> >
+    {
+        static const std::size_t alignment = sizeof(int);
+
+        static void save(const std::vector<int> & value, std::vector<char> & out)
+        {
+            const char * bytes = reinterpret_cast<const char *>(value.data());
+            out.insert(out.end(), bytes, bytes + value.size() * sizeof(int));
+        }
+
+        static void load(const char * data, std::size_t size, std::vector<int> & value)
+        {
+            const int * first = reinterpret_cast<const int *>(data);
+            value.assign(first, first + size / sizeof(int));
+        }
+    };
+}
+
+namespace any_tests
+{
+    dynamic_any_registry make_registry()
+    {
+        dynamic_any_registry registry;
+        registry.add<int>(1);
+        registry.add<double>(2);
+        registry.add<char>(3);
+        registry.add<colour>(4);
+        registry.add<point>(10);
+        registry.add<block>(11);
+        registry.add<std::string>(20);
+        registry.add<std::vector<int> >(21);
+        return registry;
+    }
+
+    template<typename ValueType>
+    ValueType round_trip(const dynamic_any_registry & registry, const ValueType & value)
+    {
+        std::vector<char> buffer;
+        registry.encode(dynamic_any(value), buffer);
+
+        dynamic_any decoded;
+        const std::size_t next = registry.decode(buffer.data(), buffer.size(), 0, decoded);
+        check_equal(next, buffer.size(), "whole record consumed");
+        check_equal(decoded.type(), typeindex::type_id<ValueType>(), "decoded type");
+        return dynamic_any_cast<ValueType>(decoded);
+    }
+
+    void test_scalar_round_trip()
+    {
+        const dynamic_any_registry registry = make_registry();
+
+        check_equal(round_trip(registry, 42), 42, "int");
+        check_equal(round_trip(registry, -1.5), -1.5, "double");
+        check_equal(round_trip(registry, 'x'), 'x', "char");
+        check_equal(round_trip(registry, blue), blue, "enum");
+        check_equal(registry.id_of(typeindex::type_id<double>().type_info()), 2u, "id_of");
+        check_equal(registry.id_of(typeindex::type_id<unregistered>().type_info()), 0u, "id_of unregistered");
+    }
+
+    void test_class_round_trip()
+    {
+        const dynamic_any_registry registry = make_registry();
+
+        point p = { 3, -4 };
+        const point q = round_trip(registry, p);
+        check_equal(q.x, 3, "point.x");
+        check_equal(q.y, -4, "point.y");
+
+        block b;
+        for(int i = 0; i != 16; ++i)
+            b.values[i] = i * 0.5;
+        const block c = round_trip(registry, b);
+        check_equal(c.values[0], 0.0, "block.values[0]");
+        check_equal(c.values[15], 7.5, "block.values[15]");
+    }
+
+    void test_custom_codec()
+    {
+        const dynamic_any_registry registry = make_registry();
+
+        check_equal(round_trip(registry, std::string("text")), std::string("text"), "string");
+        check_equal(round_trip(registry, std::string()), std::string(), "empty string");
+
+        std::vector<int> numbers;
+        numbers.push_back(1);
+        numbers.push_back(2);
+        numbers.push_back(3);
+        check_true(round_trip(registry, numbers) == numbers, "vector");
+    }
+
+    void test_empty()
+    {
+        const dynamic_any_registry registry = make_registry();
+
+        std::vector<char> buffer;
+        registry.encode(dynamic_any(), buffer);
+
+        dynamic_any decoded = 1;
+        registry.decode(buffer.data(), buffer.size(), 0, decoded);
+        check_true(decoded.empty(), "decoded empty");
+    }
+
+    void test_record_sequence()
+    {
+        const dynamic_any_registry registry = make_registry();
+
+        std::vector<dynamic_any> values;
+        values.push_back('a');
+        values.push_back(2.5);
+        values.push_back(std::string("abc"));
+        values.push_back(dynamic_any());
+        values.push_back(7);
+
+        std::vector<char> buffer;
+        for(std::size_t i = 0; i != values.size(); ++i)
+            registry.encode(values[i], buffer);
+
+        std::vector<dynamic_any> decoded(values.size());
+        std::size_t position = 0;
+        for(std::size_t i = 0; i != decoded.size(); ++i)
+        {
+            position = registry.decode(buffer.data(), buffer.size(), position, decoded[i]);
+            check_equal(typeindex::type_index(decoded[i].type()), typeindex::type_index(values[i].type()), "decoded type");
+        }
+        check_equal(position, buffer.size(), "all records consumed");
+
+        check_equal(dynamic_any_cast<char>(decoded[0]), 'a', "char");
+        check_equal(dynamic_any_cast<double>(decoded[1]), 2.5, "double after char");
+        check_equal(dynamic_any_cast<std::string>(decoded[2]), std::string("abc"), "string");
+        check_true(decoded[3].empty(), "empty");
+        check_equal(dynamic_any_cast<int>(decoded[4]), 7, "int after empty");
+    }
+
+    void test_decode_in_place()
+    {
+        const dynamic_any_registry registry = make_registry();
+
+        block first, second;
+        first.values[0] = 1;
+        second.values[0] = 2;
+        std::vector<char> buffer;
+        registry.encode(dynamic_any(first), buffer);
+        const std::size_t split = buffer.size();
+        registry.encode(dynamic_any(second), buffer);
+
+        dynamic_any decoded;
+        registry.decode(buffer.data(), buffer.size(), 0, decoded);
+        const block * storage = dynamic_any_cast<block>(&decoded);
+        registry.decode(buffer.data(), buffer.size(), split, decoded);
+
+        check_equal(dynamic_any_cast<block>(&decoded), storage, "value overwritten in place");
+        check_equal(storage->values[0], 2.0, "second value");
+    }
+
+    void test_errors()
+    {
+        dynamic_any_registry registry = make_registry();
+        std::vector<char> buffer;
+        dynamic_any decoded;
+
+        TEST_CHECK_THROW(
+            registry.encode(dynamic_any(unregistered()), buffer),
+            bad_dynamic_any_encoding,
+            "encoding an unregistered type");
+        TEST_CHECK_THROW(registry.add<unregistered>(1), bad_dynamic_any_encoding, "duplicate id");
+        TEST_CHECK_THROW(registry.add<int>(99), bad_dynamic_any_encoding, "duplicate type");
+        TEST_CHECK_THROW(registry.add<unregistered>(0), bad_dynamic_any_encoding, "reserved id");
+
+        registry.encode(dynamic_any(point()), buffer);
+        TEST_CHECK_THROW(
+            registry.decode(buffer.data(), buffer.size() - 1, 0, decoded),
+            bad_dynamic_any_encoding,
+            "truncated payload");
+        TEST_CHECK_THROW(
+            registry.decode(buffer.data(), 4, 0, decoded),
+            bad_dynamic_any_encoding,
+            "truncated header");
+
+        dynamic_any_registry other;
+        other.add<int>(1);
+        TEST_CHECK_THROW(
+            other.decode(buffer.data(), buffer.size(), 0, decoded),
+            bad_dynamic_any_encoding,
+            "unknown id");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
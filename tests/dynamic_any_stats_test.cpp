@@ -0,0 +1,185 @@
+// what:  unit tests for the dynamic_any instrumentation counters
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_DYNAMIC_ANY_STATS
+
+#include "boost/dynamic_any.hpp"
+#include "boost/dynamic_any_stats.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_clones();
+    void test_allocations();
+    void test_casts();
+    void test_base_casts();
+    void test_threads();
+    void test_json();
+
+    const test_case test_cases[] =
+    {
+        { "clones",                      test_clones      },
+        { "heap allocations",            test_allocations },
+        { "successful and failed casts", test_casts       },
+        { "casts to a base class",       test_base_casts  },
+        { "counts from other threads",   test_threads     },
+        { "JSON output",                 test_json        }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+    using boost::typeindex::type_id;
+
+    // every test counts events for types of its own, as the counts are
+    // never reset
+
+    struct cloned { int value; };
+
+    struct large { char data[256]; };
+
+    struct base { int a; };
+    struct derived : base { int b; };
+
+    struct threaded { int value; };
+
+    struct named {};
+
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::derived, any_tests::base)
+
+namespace any_tests
+{
+    dynamic_any_type_stats stats_of(const std::string & type)
+    {
+        const dynamic_any_stats_snapshot snapshot = dynamic_any_stats();
+        for(std::size_t i = 0; i != snapshot.types.size(); ++i)
+            if(snapshot.types[i].type == type)
+                return snapshot.types[i];
+        const dynamic_any_type_stats none = { type, 0, 0, 0, 0, 0 };
+        return none;
+    }
+
+    template<typename ValueType>
+    dynamic_any_type_stats stats_of()
+    {
+        return stats_of(type_id<ValueType>().pretty_name());
+    }
+
+    void test_clones()
+    {
+        cloned c = { 1 };
+        const dynamic_any original = c;
+        dynamic_any copy = original, another = copy;
+        copy = another;
+
+        check_equal(stats_of<cloned>().clones, 3u, "clones");
+        check_equal(stats_of<cloned>().allocations, 0u, "stored inline");
+    }
+
+    void test_allocations()
+    {
+        const dynamic_any original = large();
+        const dynamic_any copy = original;
+
+        check_equal(stats_of<large>().allocations, 2u, "allocations");
+        check_equal(stats_of<large>().clones, 1u, "clones");
+    }
+
+    void test_casts()
+    {
+        dynamic_any value = std::string("text");
+        dynamic_any_cast<std::string>(&value);
+        dynamic_any_cast<const std::string>(&value);
+        dynamic_any_cast<int>(&value);
+
+        const dynamic_any_type_stats stats = stats_of<std::string>();
+        check_equal(stats.casts, 2u, "casts");
+        check_equal(stats.failed_casts, 1u, "failed casts");
+        check_equal(stats.base_casts, 0u, "base casts");
+        check_equal(stats_of<int>().failed_casts, 0u, "counted for the held type");
+    }
+
+    void test_base_casts()
+    {
+        dynamic_any value = derived();
+        for(int i = 0; i != 3; ++i)
+            dynamic_any_cast<base>(&value);
+        dynamic_any_cast<derived>(&value);
+        dynamic_any_cast<cloned>(&value);
+
+        const dynamic_any_type_stats stats = stats_of<derived>();
+        check_equal(stats.casts, 4u, "casts");
+        check_equal(stats.base_casts, 3u, "base casts, cached or not");
+        check_equal(stats.failed_casts, 1u, "failed casts");
+    }
+
+    void test_threads()
+    {
+        std::vector<std::thread> threads;
+        for(int t = 0; t != 4; ++t)
+            threads.push_back(std::thread([]() {
+                threaded value = { 0 };
+                dynamic_any a = value;
+                for(int i = 0; i != 1000; ++i)
+                    dynamic_any_cast<threaded>(&a);
+            }));
+
+        // the counts of the live thread and of those that have exited
+        dynamic_any a = threaded();
+        dynamic_any_cast<threaded>(&a);
+        for(std::size_t t = 0; t != threads.size(); ++t)
+            threads[t].join();
+
+        check_equal(stats_of<threaded>().casts, 4001u, "casts");
+    }
+
+    void test_json()
+    {
+        dynamic_any value = named();
+        dynamic_any_cast<named>(&value);
+
+        const std::string json = dynamic_any_stats().json();
+        check_true(json.compare(0, 10, "{\"types\":[") == 0, "starts with the list of types");
+        check_true(json.compare(json.size() - 2, 2, "]}") == 0, "ends with the list of types");
+
+        std::string expected = "{\"type\":\"";
+        expected += type_id<named>().pretty_name();
+        expected += "\",\"clones\":0,\"allocations\":0,\"casts\":1,\"failed_casts\":0,\"base_casts\":0}";
+        check_true(json.find(expected) != std::string::npos, "entry for a type");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
@@ -4,12 +4,22 @@
 // where: tested with BCC 5.5, MSVC 6.0, and g++ 2.95
 
 #include <cstdlib>
+#include <map>
+#include <set>
 #include <string>
 #include <utility>
 
 #include "boost/dynamic_any.hpp"
 #include "test.hpp"
 
+#ifndef BOOST_NO_CXX11_HDR_UNORDERED_SET
+#include <unordered_set>
+#endif
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+
 namespace any_tests
 {
     typedef test<const char *, void (*)()> test_case;
@@ -41,11 +51,174 @@ int main()
 
     struct other {};
 
+    // the same shape as derived, but with its bases registered
+    struct registered : base, base1
+    {
+        int e;
+    };
+
+    struct virtual_derived : virtual base, base1
+    {
+        int c;
+    };
+
+    template<int N>
+    struct numbered : base1, base
+    {
+        char padding[N];
+    };
+
+#ifndef BOOST_NO_CXX11_FINAL
+    struct sealed final : base
+    {
+        int d;
+    };
+#endif
+
+    union bits
+    {
+        float f;
+        unsigned u;
+    };
+
+    // exactly fills the inline buffer
+    struct three_words
+    {
+        void * words[BOOST_DYNAMIC_ANY_SMALL_BUFFER_SIZE / sizeof(void *)];
+    };
+
+BOOST_DYNAMIC_ANY_BASES(registered, base, base1)
+BOOST_DYNAMIC_ANY_BASES(numbered<1>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<2>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<3>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<4>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<5>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<6>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<7>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<8>, base1, base)
+BOOST_DYNAMIC_ANY_BASES(numbered<64>, base1, base)
+#ifdef BOOST_NO_RTTI
+// otherwise left unregistered to exercise the throw and catch fallback
+BOOST_DYNAMIC_ANY_BASES(derived, base, base1)
+BOOST_DYNAMIC_ANY_BASES(virtual_derived, base, base1)
+#ifndef BOOST_NO_CXX11_FINAL
+BOOST_DYNAMIC_ANY_BASES(sealed, base)
+#endif
+#endif
+
+    struct large
+    {
+        char data[4 * BOOST_DYNAMIC_ANY_SMALL_BUFFER_SIZE];
+    };
+
+    struct copy_counter
+    {
+        static unsigned copies;
+
+        copy_counter() {}
+        copy_counter(int, char) {}
+        copy_counter(const copy_counter &) { ++copies; }
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        copy_counter(copy_counter &&) BOOST_NOEXCEPT {}
+#endif
+
+        char payload[2 * BOOST_DYNAMIC_ANY_SMALL_BUFFER_SIZE];
+    };
+
+    unsigned copy_counter::copies = 0;
+
+    struct money
+    {
+        explicit money(long cents = 0) : cents(cents) {}
+        long cents;
+    };
+
+    bool operator==(const money & lhs, const money & rhs) { return lhs.cents == rhs.cents; }
+    bool operator<(const money & lhs, const money & rhs) { return lhs.cents < rhs.cents; }
+    std::size_t hash_value(const money & m) { return boost::hash<long>()(m.cents); }
+
+    struct arena
+    {
+        unsigned allocated, deallocated;
+    };
+
+    template<typename T>
+    struct arena_allocator
+    {
+        typedef T value_type;
+
+        explicit arena_allocator(arena * source) : source(source) {}
+
+        template<typename U>
+        arena_allocator(const arena_allocator<U> & other) : source(other.source) {}
+
+        T * allocate(std::size_t n)
+        {
+            ++source->allocated;
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T * p, std::size_t)
+        {
+            ++source->deallocated;
+            ::operator delete(p);
+        }
+
+        bool operator==(const arena_allocator & other) const { return source == other.source; }
+        bool operator!=(const arena_allocator & other) const { return source != other.source; }
+
+        arena * source;
+    };
+
+    // goes along with the value on assignment and swap
+    template<typename T>
+    struct propagating_allocator : arena_allocator<T>
+    {
+        typedef boost::true_type propagate_on_container_copy_assignment;
+        typedef boost::true_type propagate_on_container_move_assignment;
+        typedef boost::true_type propagate_on_container_swap;
+
+        explicit propagating_allocator(arena * source) : arena_allocator<T>(source) {}
+
+        template<typename U>
+        propagating_allocator(const propagating_allocator<U> & other) : arena_allocator<T>(other) {}
+    };
+
+#ifdef __cpp_lib_memory_resource
+    struct counting_resource : std::pmr::memory_resource
+    {
+        counting_resource() : allocated(0), deallocated(0) {}
+
+        unsigned allocated, deallocated;
+
+    private:
+        void * do_allocate(std::size_t bytes, std::size_t alignment)
+        {
+            ++allocated;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void * p, std::size_t bytes, std::size_t alignment)
+        {
+            ++deallocated;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource & other) const noexcept
+        {
+            return this == &other;
+        }
+    };
+#endif
+
+BOOST_DYNAMIC_ANY_COMPARABLE(money)
+
 namespace any_tests // test suite
 {
     void test_default_ctor();
     void test_converting_ctor();
     void test_copy_ctor();
+    void test_move_ctor();
     void test_copy_assign();
     void test_converting_assign();
     void test_bad_cast();
@@ -53,19 +226,46 @@ namespace any_tests // test suite
     void test_null_copying();
     void test_cast_to_reference();
     void test_dynamic_cast();
+    void test_registered_bases();
+    void test_small_buffer();
+    void test_cached_dynamic_cast();
+    void test_plain_values();
+    void test_exact_cast();
+    void test_allocator();
+    void test_propagating_allocator();
+    void test_polymorphic_allocator();
+    void test_try_cast();
+    void test_equality();
+    void test_ordering();
+    void test_hashing();
+    void test_heterogeneous_lookup();
 
     const test_case test_cases[] =
     {
         { "default construction",           test_default_ctor      },
         { "single argument construction",   test_converting_ctor   },
         { "copy construction",              test_copy_ctor         },
+        { "move construction",              test_move_ctor         },
         { "copy assignment operator",       test_copy_assign       },
         { "converting assignment operator", test_converting_assign },
         { "failed custom keyword cast",     test_bad_cast          },
         { "swap member function",           test_swap              },
         { "copying operations on a null",   test_null_copying      },
         { "cast to reference types",        test_cast_to_reference },
-        { "dynamic cast",                   test_dynamic_cast      }
+        { "dynamic cast",                   test_dynamic_cast      },
+        { "cast to registered bases",       test_registered_bases  },
+        { "small buffer storage",           test_small_buffer      },
+        { "repeated dynamic cast",          test_cached_dynamic_cast },
+        { "values held as they are",        test_plain_values      },
+        { "cast to the held type",          test_exact_cast        },
+        { "user supplied allocator",        test_allocator         },
+        { "propagating allocator",          test_propagating_allocator },
+        { "polymorphic allocator",          test_polymorphic_allocator },
+        { "non-throwing cast",              test_try_cast          },
+        { "equality",                       test_equality          },
+        { "ordering",                       test_ordering          },
+        { "hashing",                        test_hashing           },
+        { "lookup by held value",           test_heterogeneous_lookup }
     };
 
     const test_case_iterator begin = test_cases;
@@ -76,6 +276,8 @@ namespace any_tests // test suite
 namespace any_tests // test definitions
 {
     using namespace boost;
+    using boost::typeindex::type_id;
+    using boost::typeindex::type_index;
 
     void test_default_ctor()
     {
@@ -83,7 +285,7 @@ namespace any_tests // test definitions
 
         check_true(value.empty(), "empty");
         check_null(dynamic_any_cast<int>(&value), "dynamic_any_cast<int>");
-        check_equal(value.type(), typeid(void), "type");
+        check_equal(value.type(), type_id<void>(), "type");
     }
 
     void test_converting_ctor()
@@ -92,7 +294,7 @@ namespace any_tests // test definitions
         dynamic_any value = text;
 
         check_false(value.empty(), "empty");
-        check_equal(value.type(), typeid(std::string), "type");
+        check_equal(value.type(), type_id<std::string>(), "type");
         check_null(dynamic_any_cast<int>(&value), "dynamic_any_cast<int>");
         check_non_null(dynamic_any_cast<std::string>(&value), "dynamic_any_cast<std::string>");
         check_equal(
@@ -109,7 +311,7 @@ namespace any_tests // test definitions
         dynamic_any original = text, copy = original;
 
         check_false(copy.empty(), "empty");
-        check_equal(original.type(), copy.type(), "type");
+        check_equal(type_index(original.type()), copy.type(), "type");
         check_equal(
             dynamic_any_cast<std::string>(original), dynamic_any_cast<std::string>(copy),
             "comparing cast copy against original");
@@ -122,6 +324,45 @@ namespace any_tests // test definitions
             "comparing address in copy against original");
     }
 
+    void test_move_ctor()
+    {
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+        copy_counter::copies = 0;
+
+        dynamic_any original = copy_counter();
+        copy_counter * held = dynamic_any_cast<copy_counter>(&original);
+        dynamic_any moved(std::move(original));
+
+        check_true(original.empty(), "moved-from is empty");
+        check_equal(dynamic_any_cast<copy_counter>(&moved), held, "heap value changes owner");
+
+        dynamic_any assigned;
+        assigned = std::move(moved);
+        check_true(moved.empty(), "move-assigned-from is empty");
+        check_equal(dynamic_any_cast<copy_counter>(&assigned), held, "heap value moved by assignment");
+
+        assigned = copy_counter();
+        assigned.emplace<copy_counter>(1, 'x');
+        check_equal(assigned.type(), type_id<copy_counter>(), "type after emplace");
+#ifndef BOOST_NO_CXX17_HDR_VARIANT
+        dynamic_any in_place(std::in_place_type<copy_counter>, 1, 'x');
+        check_false(in_place.empty(), "in place construction");
+#endif
+        check_equal(copy_counter::copies, 0u, "no copy constructor ran");
+
+        std::string text = "test message";
+        dynamic_any small = 137, string_value = std::move(text);
+        dynamic_any small_moved(std::move(small));
+        check_true(small.empty(), "inline moved-from is empty");
+        check_equal(dynamic_any_cast<int>(small_moved), 137, "inline value moved");
+        check_equal(dynamic_any_cast<std::string>(string_value), std::string("test message"),
+            "converting move construction");
+        check_equal(small_moved.emplace<int>(42), 42, "emplace returns held value");
+#else
+        throw not_implemented();
+#endif
+    }
+
     void test_copy_assign()
     {
         std::string text = "test message";
@@ -129,7 +370,7 @@ namespace any_tests // test definitions
         dynamic_any * assign_result = &(copy = original);
 
         check_false(copy.empty(), "empty");
-        check_equal(original.type(), copy.type(), "type");
+        check_equal(type_index(original.type()), copy.type(), "type");
         check_equal(
             dynamic_any_cast<std::string>(original), dynamic_any_cast<std::string>(copy),
             "comparing cast copy against cast original");
@@ -150,7 +391,7 @@ namespace any_tests // test definitions
         dynamic_any * assign_result = &(value = text);
 
         check_false(value.empty(), "type");
-        check_equal(value.type(), typeid(std::string), "type");
+        check_equal(value.type(), type_id<std::string>(), "type");
         check_null(dynamic_any_cast<int>(&value), "dynamic_any_cast<int>");
         check_non_null(dynamic_any_cast<std::string>(&value), "dynamic_any_cast<std::string>");
         check_equal(
@@ -183,7 +424,7 @@ namespace any_tests // test definitions
 
         check_true(original.empty(), "empty on original");
         check_false(swapped.empty(), "empty on swapped");
-        check_equal(swapped.type(), typeid(std::string), "type");
+        check_equal(swapped.type(), type_id<std::string>(), "type");
         check_equal(
             text, dynamic_any_cast<std::string>(swapped),
             "comparing swapped copy against original text");
@@ -215,12 +456,34 @@ namespace any_tests // test definitions
         base &                   b   = dynamic_any_cast<base&>(a);
         base1 &                  b1  = dynamic_any_cast<base1&>(a);
         const base1 &            cb1 = dynamic_any_cast<const base1&>(a);
+        check_true(&b == static_cast<base *>(&ra), "cast to base");
+        check_true(&b1 == static_cast<base1 *>(&ra), "cast to base1");
+        check_true(&cb1 == &b1, "cast to const base1");
     
         TEST_CHECK_THROW(
             dynamic_any_cast<other&>(a),
             bad_dynamic_any_cast,
             "dynamic_any_cast to incorrect reference type");
     }
+
+    void test_registered_bases()
+    {
+        registered r;
+        r.a = 1; r.a1 = 2; r.e = 3;
+        dynamic_any a(r);
+        registered & held = dynamic_any_cast<registered &>(a);
+
+        check_equal(&dynamic_any_cast<base &>(a), static_cast<base *>(&held), "first base");
+        check_equal(dynamic_any_cast<const base1>(&a), static_cast<const base1 *>(&held),
+            "second base");
+        check_equal(dynamic_any_cast<base1 &>(a).a1, 2, "value through a base");
+        check_null(dynamic_any_cast<derived>(&a), "unrelated class of the same shape");
+        TEST_CHECK_THROW(
+            dynamic_any_cast<other &>(a),
+            bad_dynamic_any_cast,
+            "dynamic_any_cast to unregistered type");
+    }
+
     void test_cast_to_reference()
     {
         dynamic_any a(137);
@@ -256,6 +519,364 @@ namespace any_tests // test definitions
             "dynamic_any_cast to incorrect const reference type");
     }
 
+    bool stored_inline(const void * held, const dynamic_any & value)
+    {
+        const char * first = reinterpret_cast<const char *>(&value);
+        const char * p = static_cast<const char *>(held);
+        return first <= p && p < first + sizeof(value);
+    }
+
+    void test_small_buffer()
+    {
+        dynamic_any small = 137, big = large();
+        large * big_ptr = dynamic_any_cast<large>(&big);
+
+        check_true(stored_inline(dynamic_any_cast<int>(&small), small), "int stored inline");
+        check_false(stored_inline(big_ptr, big), "large value stored on heap");
+
+        dynamic_any copy = small;
+        check_true(stored_inline(dynamic_any_cast<int>(&copy), copy), "copy stored inline");
+        check_equal(dynamic_any_cast<int>(copy), 137, "copied inline value");
+
+        small.swap(big);
+        check_equal(small.type(), type_id<large>(), "type after swap");
+        check_equal(big.type(), type_id<int>(), "type after swap");
+        check_equal(dynamic_any_cast<large>(&small), big_ptr, "heap value keeps its address");
+        check_true(stored_inline(dynamic_any_cast<int>(&big), big), "inline value moved inline");
+        check_equal(dynamic_any_cast<int>(big), 137, "inline value after swap");
+
+        derived d;
+        d.a = 1; d.a1 = 2; d.b = 3;
+        dynamic_any a(d), b = 2.5;
+        a.swap(b);
+        check_equal(dynamic_any_cast<double>(a), 2.5, "double after swap");
+        check_equal(dynamic_any_cast<base1&>(b).a1, 2, "base cast after swap");
+        check_equal(dynamic_any_cast<derived&>(b).b, 3, "derived cast after swap");
+    }
+
+
+    template<typename Held>
+    void check_base_casts(const std::string & name)
+    {
+        Held held = Held();
+        dynamic_any value = held;
+        Held & ref = dynamic_any_cast<Held &>(value);
+
+        for(int pass = 0; pass != 3; ++pass)
+        {
+            check_equal(dynamic_any_cast<base>(&value), static_cast<base *>(&ref),
+                "cast to base of " + name);
+            check_equal(dynamic_any_cast<const base1>(&value), static_cast<const base1 *>(&ref),
+                "cast to const base1 of " + name);
+            check_null(dynamic_any_cast<other>(&value), "cast to unrelated type from " + name);
+        }
+    }
+
+    void test_cached_dynamic_cast()
+    {
+        // more held types than cache slots, so entries get evicted
+        check_base_casts<derived>("derived");
+        check_base_casts<registered>("registered");
+        check_base_casts<virtual_derived>("virtual_derived");
+        check_base_casts<numbered<1> >("numbered<1>");
+        check_base_casts<numbered<64> >("numbered<64>");
+        check_base_casts<numbered<2> >("numbered<2>");
+        check_base_casts<numbered<3> >("numbered<3>");
+        check_base_casts<numbered<4> >("numbered<4>");
+        check_base_casts<numbered<5> >("numbered<5>");
+        check_base_casts<numbered<6> >("numbered<6>");
+        check_base_casts<numbered<7> >("numbered<7>");
+        check_base_casts<numbered<8> >("numbered<8>");
+        check_base_casts<derived>("derived");
+        check_base_casts<numbered<64> >("numbered<64>");
+
+        dynamic_any scalar = 1;
+        check_null(dynamic_any_cast<base>(&scalar), "cast to base from scalar");
+        check_null(dynamic_any_cast<base>(&scalar), "repeated cast to base from scalar");
+    }
+
+    void test_plain_values()
+    {
+        // nothing is added to a held value, so types that cannot be
+        // derived from are held too, and a value the size of the buffer
+        // still fits it
+#ifndef BOOST_NO_CXX11_FINAL
+        sealed s;
+        s.a = 4;
+        dynamic_any a = s;
+        check_equal(dynamic_any_cast<sealed>(&a), &dynamic_any_cast<sealed &>(a), "final class held");
+        check_equal(dynamic_any_cast<base &>(a).a, 4, "base of a final class");
+#endif
+
+        bits b;
+        b.u = 7;
+        dynamic_any u = b;
+        check_equal(dynamic_any_cast<bits>(u).u, 7u, "union held");
+        check_null(dynamic_any_cast<base>(&u), "no base of a union");
+
+        three_words w = { { 0 } };
+        dynamic_any words = w;
+        check_true(stored_inline(dynamic_any_cast<three_words>(&words), words),
+            "value filling the buffer stored inline");
+
+        // a virtual base is found again in copies, where the value has
+        // moved
+        virtual_derived v = virtual_derived();
+        v.a = 5;
+        dynamic_any original = v;
+        dynamic_any copy = original;
+        original.clear();
+        check_equal(dynamic_any_cast<base &>(copy).a, 5, "virtual base in a copy");
+        check_equal(dynamic_any_cast<base>(&copy),
+            static_cast<base *>(dynamic_any_cast<virtual_derived>(&copy)), "virtual base address in a copy");
+    }
+
+
+    void test_exact_cast()
+    {
+        derived d;
+        dynamic_any a(d), b = large(), c = 2.5;
+        const dynamic_any & ca = a;
+
+        derived * held = dynamic_any_cast<derived>(&a);
+        check_non_null(held, "cast to held class type");
+        check_equal(dynamic_any_cast<const derived>(&ca), held, "cast to const held class type");
+        check_equal(static_cast<base1 *>(held), dynamic_any_cast<base1>(&a),
+            "exact and base casts agree");
+        check_true(dynamic_any_cast<const volatile large>(&b) != 0, "cv cast to held heap type");
+        check_null(dynamic_any_cast<derived>(&b), "cast to other class type");
+        check_equal(*dynamic_any_cast<volatile double>(&c), 2.5, "cv cast to held scalar type");
+        check_null(dynamic_any_cast<float>(&c), "cast to other scalar type");
+    }
+
+
+    void test_allocator()
+    {
+        typedef basic_dynamic_any<arena_allocator<char> > arena_any;
+
+        arena first = { 0, 0 }, second = { 0, 0 };
+        const arena_allocator<char> first_alloc(&first), second_alloc(&second);
+        {
+            arena_any small(137, first_alloc), big(large(), first_alloc);
+            check_equal(first.allocated, 1u, "only the large value is allocated");
+            check_true(big.get_allocator() == first_alloc, "get_allocator");
+
+            arena_any copy(big);
+            check_equal(first.allocated, 2u, "copy allocates from the source's arena");
+
+            arena_any assigned(second_alloc);
+            assigned = big;
+            assigned = std::string("test message");
+            check_equal(first.allocated, 2u, "assignment keeps the target's arena");
+            check_equal(second.allocated, 2u, "assignment allocates from the target's arena");
+            check_equal(second.deallocated, 1u, "assignment frees the old value");
+            check_true(assigned.get_allocator() == second_alloc, "allocator after assignment");
+
+            small.swap(assigned);
+            check_true(small.get_allocator() == first_alloc, "allocator stays on swap");
+            check_equal(dynamic_any_cast<int>(assigned), 137, "value after swap");
+            check_non_null(dynamic_any_cast<std::string>(&small), "value after swap");
+            check_equal(first.allocated, 3u, "swap moves the heap value into the other arena");
+            check_equal(second.deallocated, 2u, "swap frees the moved value");
+
+            arena_any moved(second_alloc);
+            moved = boost::move(big);
+            check_true(moved.get_allocator() == second_alloc, "allocator stays on move assignment");
+            check_true(big.empty(), "moved from");
+            check_equal(second.allocated, 3u, "move assignment allocates from the target's arena");
+        }
+        check_equal(first.allocated, first.deallocated, "first arena balanced");
+        check_equal(second.allocated, second.deallocated, "second arena balanced");
+    }
+
+    void test_propagating_allocator()
+    {
+        typedef basic_dynamic_any<propagating_allocator<char> > arena_any;
+
+        arena first = { 0, 0 }, second = { 0, 0 };
+        const propagating_allocator<char> first_alloc(&first), second_alloc(&second);
+        {
+            arena_any big(large(), first_alloc), assigned(137, second_alloc);
+            assigned = big;
+            check_true(assigned.get_allocator() == first_alloc, "allocator travels with copy assignment");
+            check_equal(first.allocated, 2u, "copy allocated from the source's arena");
+
+            arena_any other(std::string("test message"), second_alloc);
+            large * held = dynamic_any_cast<large>(&big);
+            big.swap(other);
+            check_true(big.get_allocator() == second_alloc, "allocator travels with swap");
+            check_equal(dynamic_any_cast<large>(&other), held, "heap value keeps its address");
+
+            arena_any moved(second_alloc);
+            moved = boost::move(other);
+            check_true(moved.get_allocator() == first_alloc, "allocator travels with move assignment");
+            check_equal(dynamic_any_cast<large>(&moved), held, "heap value moved without copying");
+        }
+        check_equal(first.allocated, 2u, "no copies on swap and move");
+        check_equal(first.allocated, first.deallocated, "first arena balanced");
+        check_equal(second.allocated, second.deallocated, "second arena balanced");
+    }
+
+    void test_polymorphic_allocator()
+    {
+#ifdef __cpp_lib_memory_resource
+        typedef basic_dynamic_any<std::pmr::polymorphic_allocator<char> > pmr_any;
+
+        counting_resource first, second;
+        {
+            pmr_any a(large(), &first), b(std::string("test message"), &second);
+            pmr_any c((pmr_any::allocator_type(&first)));
+
+            c = a;
+            check_true(c.get_allocator().resource() == &first, "resource kept on copy assignment");
+            check_equal(first.allocated, 2u, "copy allocated from the target's resource");
+
+            a = b;
+            check_true(a.get_allocator().resource() == &first, "resource kept on copy assignment");
+            check_equal(dynamic_any_cast<std::string>(a), std::string("test message"), "copied value");
+            check_equal(first.allocated, 3u, "copy allocated from the target's resource");
+            check_equal(first.deallocated, 1u, "old value freed");
+
+            c = std::move(b);
+            check_true(c.get_allocator().resource() == &first, "resource kept on move assignment");
+            check_true(b.empty(), "moved from");
+            check_equal(second.deallocated, 1u, "moved value freed by its resource");
+
+            pmr_any d(large(), &second);
+            c.swap(d);
+            check_true(c.get_allocator().resource() == &first, "resource kept on swap");
+            check_true(d.get_allocator().resource() == &second, "resource kept on swap");
+            check_non_null(dynamic_any_cast<large>(&c), "value after swap");
+            check_equal(dynamic_any_cast<std::string>(d), std::string("test message"), "value after swap");
+
+            pmr_any e(137, &first);
+            large * held = dynamic_any_cast<large>(&c);
+            const unsigned allocations = first.allocated;
+            e.swap(c);
+            check_equal(dynamic_any_cast<large>(&e), held, "same resource swaps without moving");
+            check_equal(first.allocated, allocations, "same resource swaps without allocating");
+        }
+        check_equal(first.allocated, first.deallocated, "first resource balanced");
+        check_equal(second.allocated, second.deallocated, "second resource balanced");
+#endif
+    }
+
+    void test_try_cast()
+    {
+        derived d;
+        d.b = 3;
+        dynamic_any value = d;
+        const dynamic_any & cvalue = value;
+        const dynamic_any empty;
+
+        check_true(try_cast<derived>(value).is_initialized(), "held type");
+        check_equal(&*try_cast<derived &>(value), dynamic_any_cast<derived>(&value), "reference form");
+        check_equal(try_cast<base1>(cvalue)->a1, d.a1, "base through const operand");
+        check_false(try_cast<other>(value).is_initialized(), "unrelated type");
+        check_false(try_cast<int>(empty).is_initialized(), "empty operand");
+
+        try_cast<derived>(value)->b = 4;
+        check_equal(dynamic_any_cast<derived &>(value).b, 4, "modified through optional");
+    }
+
+    void test_equality()
+    {
+        const dynamic_any one = 1, another_one = 1, two = 2, long_one = 1L, empty;
+
+        check_true(one == another_one, "equal ints");
+        check_true(one != two, "different ints");
+        check_false(one == long_one, "different types never equal");
+        check_true(empty == dynamic_any(), "empty values equal");
+        check_true(one != empty, "empty and non-empty");
+        check_true(dynamic_any(std::string("a")) == dynamic_any(std::string("a")), "strings");
+        check_true(dynamic_any(money(5)) == dynamic_any(money(5)), "opted in type");
+
+        const dynamic_any object = other();
+        check_false(object == one, "type mismatch is settled without comparing");
+        TEST_CHECK_THROW(
+            (object == dynamic_any(other())),
+            bad_dynamic_any_comparison,
+            "comparing a type that did not opt in");
+    }
+
+    void test_ordering()
+    {
+        const dynamic_any one = 1, two = 2, text = std::string("text"), empty;
+
+        check_true(one < two, "ints");
+        check_true(two > one, "greater");
+        check_true(one <= one && one >= one, "not less than itself");
+        check_true(empty < one && !(one < empty), "empty first");
+        check_true((one < text) != (text < one), "different types are ordered");
+        check_true((one < text) == (two < text), "ordered by type before value");
+        check_true(dynamic_any(money(1)) < dynamic_any(money(2)), "opted in type");
+        TEST_CHECK_THROW(
+            (dynamic_any(other()) < dynamic_any(other())),
+            bad_dynamic_any_comparison,
+            "ordering a type that did not opt in");
+
+        std::set<dynamic_any> values;
+        values.insert(two);
+        values.insert(text);
+        values.insert(one);
+        values.insert(dynamic_any(2));
+        values.insert(dynamic_any(std::string("text")));
+        check_equal(values.size(), 3u, "set of mixed types");
+    }
+
+    void test_hashing()
+    {
+        check_equal(hash_value(dynamic_any(5)), boost::hash<int>()(5), "hashes the held value");
+        check_equal(boost::hash<dynamic_any>()(dynamic_any(std::string("x"))),
+                    boost::hash<std::string>()("x"), "boost::hash");
+        check_equal(hash_value(dynamic_any()), 0u, "empty");
+        check_equal(dynamic_any_hash()(money(3)), dynamic_any_hash()(dynamic_any(money(3))),
+                    "plain value hashes like a dynamic_any holding it");
+        TEST_CHECK_THROW(
+            hash_value(dynamic_any(other())),
+            bad_dynamic_any_comparison,
+            "hashing a type that did not opt in");
+
+#ifndef BOOST_NO_CXX11_HDR_UNORDERED_SET
+        check_equal(std::hash<dynamic_any>()(dynamic_any(5)), boost::hash<int>()(5), "std::hash");
+
+        std::unordered_set<dynamic_any, dynamic_any_hash, dynamic_any_equal_to> values;
+        values.insert(dynamic_any(1));
+        values.insert(dynamic_any(1L));
+        values.insert(dynamic_any(1));
+        values.insert(dynamic_any(std::string("1")));
+        check_equal(values.size(), 3u, "unordered set of mixed types");
+#endif
+    }
+
+    void test_heterogeneous_lookup()
+    {
+        const dynamic_any one = 1;
+        dynamic_any_equal_to equal;
+        dynamic_any_less less;
+
+        check_true(equal(one, 1) && equal(1, one), "equal to a plain value");
+        check_false(equal(one, 1L), "only the held type matches");
+        check_false(equal(dynamic_any(), 1), "empty");
+        check_true(less(one, 2) && less(0, one), "less than a plain value");
+        check_equal(less(one, std::string()), one < dynamic_any(std::string()), "ordered by type like dynamic_any");
+
+        std::map<dynamic_any, int, dynamic_any_less> by_key;
+        by_key[dynamic_any(1)] = 10;
+        by_key[dynamic_any(std::string("b"))] = 20;
+#ifdef __cpp_lib_generic_associative_lookup
+        check_equal(by_key.find(std::string("b"))->second, 20, "map lookup by plain value");
+        check_true(by_key.find(2) == by_key.end(), "map lookup miss");
+#endif
+
+#if !defined(BOOST_NO_CXX11_HDR_UNORDERED_SET) && defined(__cpp_lib_generic_unordered_lookup)
+        std::unordered_set<dynamic_any, dynamic_any_hash, dynamic_any_equal_to> values;
+        values.insert(dynamic_any(money(7)));
+        check_true(values.find(money(7)) != values.end(), "unordered lookup by plain value");
+        check_true(values.find(7L) == values.end(), "unordered lookup miss");
+#endif
+    }
+
 }
 
 // Copyright Kevlin Henney, 2000, 2001. All rights reserved.
@@ -0,0 +1,289 @@
+// what:  unit tests for boost::dynamic_any_vector
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include "boost/dynamic_any_vector.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_default_ctor();
+    void test_push_back();
+    void test_emplace_back();
+    void test_bad_cast();
+    void test_dynamic_cast();
+    void test_packed_storage();
+    void test_growth();
+    void test_push_back_own_element();
+    void test_copy_and_move();
+    void test_pop_back_and_clear();
+    void test_typed_iteration();
+
+    const test_case test_cases[] =
+    {
+        { "default construction",           test_default_ctor       },
+        { "push_back",                      test_push_back          },
+        { "emplace_back",                   test_emplace_back       },
+        { "bad indexed cast",               test_bad_cast           },
+        { "indexed dynamic cast",           test_dynamic_cast       },
+        { "packed storage",                 test_packed_storage     },
+        { "growth keeps values",            test_growth             },
+        { "push_back of own element",       test_push_back_own_element },
+        { "copy and move",                  test_copy_and_move      },
+        { "pop_back and clear",             test_pop_back_and_clear },
+        { "typed iteration",                test_typed_iteration    }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+    using boost::typeindex::type_id;
+
+    struct base
+    {
+        int a;
+        virtual ~base() {}
+    };
+
+    struct base1
+    {
+        int a1;
+    };
+
+    struct derived : base, base1
+    {
+        derived(int b_) : b(b_) { a = 1; a1 = 2; }
+        int b;
+    };
+
+    struct other {};
+
+    struct counted
+    {
+        counted() { ++live; }
+        counted(const counted &) { ++live; }
+        ~counted() { --live; }
+        static int live;
+    };
+
+    int counted::live = 0;
+
+    int sum = 0;
+    void add(int & value) { sum += value; }
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::derived, any_tests::base, any_tests::base1)
+
+namespace any_tests
+{
+    void test_default_ctor()
+    {
+        const dynamic_any_vector values;
+
+        check_true(values.empty(), "empty");
+        check_equal(values.size(), 0u, "size");
+        check_equal(values.storage_size(), 0u, "storage_size");
+    }
+
+    void test_push_back()
+    {
+        std::string text = "test message";
+        dynamic_any_vector values;
+        values.push_back(text);
+        values.push_back(42);
+        values.push_back(2.5);
+
+        check_equal(values.size(), 3u, "size");
+        check_equal(values.type(0), type_id<std::string>(), "type of element 0");
+        check_equal(values.type(1), type_id<int>(), "type of element 1");
+        check_equal(dynamic_any_cast<std::string>(values, 0), text, "element 0");
+        check_equal(dynamic_any_cast<int>(values, 1), 42, "element 1");
+        check_equal(dynamic_any_cast<double>(values, 2), 2.5, "element 2");
+        check_null(dynamic_any_cast<int>(&values, 2), "cast to other scalar type");
+
+        dynamic_any_cast<int &>(values, 1) = 7;
+        const dynamic_any_vector & cvalues = values;
+        check_equal(*dynamic_any_cast<int>(&cvalues, 1), 7, "modified through reference");
+    }
+
+    void test_emplace_back()
+    {
+        dynamic_any_vector values;
+        std::string & text = values.emplace_back<std::string>(3u, 'x');
+
+        check_equal(text, std::string("xxx"), "constructed in place");
+        check_equal(dynamic_any_cast<std::string>(&values, 0), &text, "address of element");
+        check_equal(values.emplace_back<derived>(5).b, 5, "class constructed in place");
+    }
+
+    void test_bad_cast()
+    {
+        dynamic_any_vector values;
+        values.push_back(std::string("test message"));
+
+        TEST_CHECK_THROW(
+            dynamic_any_cast<const char *>(values, 0),
+            bad_dynamic_any_cast,
+            "indexed dynamic_any_cast to incorrect type");
+    }
+
+    void test_dynamic_cast()
+    {
+        dynamic_any_vector values;
+        values.push_back(derived(3));
+        values.push_back(other());
+
+        check_equal(dynamic_any_cast<derived &>(values, 0).b, 3, "held type");
+        check_equal(dynamic_any_cast<base &>(values, 0).a, 1, "first base");
+        check_equal(dynamic_any_cast<const base1 &>(values, 0).a1, 2, "second base");
+        check_null(dynamic_any_cast<base>(&values, 1), "unrelated type");
+
+        TEST_CHECK_THROW(
+            dynamic_any_cast<other &>(values, 0),
+            bad_dynamic_any_cast,
+            "indexed dynamic_any_cast to incorrect reference type");
+    }
+
+    void test_packed_storage()
+    {
+        dynamic_any_vector values;
+        values.push_back(1);
+        values.push_back(2);
+        values.push_back(3);
+
+        char * first = reinterpret_cast<char *>(dynamic_any_cast<int>(&values, 0));
+        char * third = reinterpret_cast<char *>(dynamic_any_cast<int>(&values, 2));
+        check_true(first < third && third - first < 64, "elements stored back to back");
+        check_true(values.storage_size() <= values.storage_capacity(), "storage within capacity");
+    }
+
+    void test_growth()
+    {
+        dynamic_any_vector values;
+        for(int i = 0; i != 1000; ++i)
+        {
+            if(i % 2)
+                values.push_back(i);
+            else
+                values.push_back(std::string(i % 7 + 1, 'a'));
+        }
+
+        check_equal(values.size(), 1000u, "size");
+        bool intact = true;
+        for(int i = 0; i != 1000; ++i)
+            intact = intact && (i % 2
+                ? dynamic_any_cast<int>(values, i) == i
+                : dynamic_any_cast<const std::string &>(values, i).size() == std::size_t(i % 7 + 1));
+        check_true(intact, "values survive reallocation");
+    }
+
+    void test_push_back_own_element()
+    {
+        dynamic_any_vector values;
+        values.push_back(std::string("a string too long for the small buffer"));
+        for(int i = 0; i != 10; ++i)
+            values.push_back(dynamic_any_cast<std::string &>(values, i));
+
+        check_equal(values.size(), 11u, "size");
+        bool intact = true;
+        for(int i = 0; i != 11; ++i)
+            intact = intact && dynamic_any_cast<std::string &>(values, i)
+                == "a string too long for the small buffer";
+        check_true(intact, "copied before the buffer grew");
+    }
+
+    void test_copy_and_move()
+    {
+        {
+            dynamic_any_vector values;
+            values.push_back(counted());
+            values.push_back(std::string("test message"));
+
+            dynamic_any_vector copy = values;
+            check_equal(counted::live, 2, "copied element");
+            check_equal(dynamic_any_cast<std::string>(copy, 1), std::string("test message"), "copied string");
+            check_true(dynamic_any_cast<counted>(&copy, 0) != dynamic_any_cast<counted>(&values, 0),
+                "copy owns its elements");
+
+            counted * held = dynamic_any_cast<counted>(&values, 0);
+            dynamic_any_vector moved = std::move(values);
+            check_true(values.empty(), "moved-from vector is empty");
+            check_equal(dynamic_any_cast<counted>(&moved, 0), held, "move keeps elements in place");
+
+            copy = moved;
+            check_equal(counted::live, 2, "copy assignment replaced elements");
+        }
+        check_equal(counted::live, 0, "elements destroyed");
+    }
+
+    void test_pop_back_and_clear()
+    {
+        dynamic_any_vector values;
+        values.push_back(counted());
+        values.push_back(1);
+        values.push_back(counted());
+        check_equal(counted::live, 2, "live elements");
+
+        values.pop_back();
+        check_equal(counted::live, 1, "pop_back destroys the last element");
+        check_equal(values.size(), 2u, "size after pop_back");
+
+        values.push_back(2);
+        check_equal(dynamic_any_cast<int>(values, 2), 2, "push_back after pop_back");
+
+        values.clear();
+        check_equal(counted::live, 0, "clear destroys all elements");
+        check_true(values.empty(), "empty after clear");
+        check_equal(values.storage_size(), 0u, "storage_size after clear");
+    }
+
+    void test_typed_iteration()
+    {
+        dynamic_any_vector values;
+        values.push_back(1);
+        values.push_back(derived(10));
+        values.push_back(2);
+        values.push_back(std::string("3"));
+        values.push_back(derived(20));
+
+        sum = 0;
+        values.for_each<int>(add);
+        check_equal(sum, 3, "ints visited");
+
+        int bases = 0;
+        const dynamic_any_vector & cvalues = values;
+        cvalues.for_each<base1>([&](const base1 & b) { bases += b.a1; });
+        check_equal(bases, 4, "bases of held values visited");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
@@ -0,0 +1,200 @@
+// what:  unit tests for boost::visit over dynamic_any
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+
+#include "boost/dynamic_any_visit.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_exact_types();
+    void test_first_match_wins();
+    void test_base_classes();
+    void test_no_match();
+    void test_empty();
+    void test_const_operand();
+    void test_repeated_visits();
+
+    const test_case test_cases[] =
+    {
+        { "visit exact types",              test_exact_types       },
+        { "first matching alternative",     test_first_match_wins  },
+        { "visit base classes",             test_base_classes      },
+        { "no alternative matches",         test_no_match          },
+        { "empty operand",                  test_empty             },
+        { "const operand",                  test_const_operand     },
+        { "repeated visits",                test_repeated_visits   }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    struct base
+    {
+        virtual ~base() {}
+        int a;
+    };
+
+    struct base1
+    {
+        int a1;
+    };
+
+    struct derived : base, base1
+    {
+        derived() { a = 1; a1 = 2; }
+    };
+
+    struct other {};
+
+    struct describe
+    {
+        std::string operator()(int & i) const { return "int " + std::to_string(i); }
+        std::string operator()(std::string & s) const { return "string " + s; }
+        std::string operator()(base & b) const { return "base " + std::to_string(b.a); }
+        std::string operator()(base1 & b) const { return "base1 " + std::to_string(b.a1); }
+        std::string operator()(derived &) const { return "derived"; }
+        std::string operator()(other &) const { return "other"; }
+    };
+
+    struct reset
+    {
+        void operator()(int & i) const { i = 0; }
+        void operator()(std::string & s) const { s.clear(); }
+    };
+
+    struct count_kinds
+    {
+        int * counts;
+        void operator()(int &) const { ++counts[0]; }
+        void operator()(base &) const { ++counts[1]; }
+        void operator()(dynamic_any &) const { ++counts[2]; }
+    };
+
+    struct describe_const
+    {
+        std::string operator()(const int & i) const { return "int " + std::to_string(i); }
+        std::string operator()(const std::string & s) const { return "string " + s; }
+    };
+
+    std::string no_match(dynamic_any & operand)
+    {
+        return operand.empty() ? "empty" : "no match";
+    }
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::derived, any_tests::base, any_tests::base1)
+
+namespace any_tests
+{
+    void test_exact_types()
+    {
+        dynamic_any i(42), s(std::string("text"));
+
+        check_equal(visit<int, std::string>(i, describe()), std::string("int 42"), "int");
+        check_equal(visit<int, std::string>(s, describe()), std::string("string text"), "string");
+
+        visit<int, std::string>(i, reset());
+        check_equal(dynamic_any_cast<int>(i), 0, "modified through visitor");
+    }
+
+    void test_first_match_wins()
+    {
+        dynamic_any d = derived();
+
+        check_equal(visit<base1, base, derived>(d, describe()), std::string("base1 2"), "base1 first");
+        check_equal(visit<derived, base>(d, describe()), std::string("derived"), "derived first");
+        check_equal(visit<other, base>(d, describe()), std::string("base 1"), "skips non-matching");
+    }
+
+    void test_base_classes()
+    {
+        dynamic_any d = derived();
+
+        check_equal(visit<base>(d, describe()), std::string("base 1"), "base");
+        check_equal(visit<int, base1>(d, describe()), std::string("base1 2"), "base1");
+    }
+
+    void test_no_match()
+    {
+        dynamic_any d = 2.5;
+
+        check_equal(visit<int, std::string>(d, describe(), no_match), std::string("no match"), "fallback");
+
+        TEST_CHECK_THROW(
+            (visit<int, std::string>(d, describe())),
+            bad_dynamic_any_cast,
+            "visit without a matching alternative");
+    }
+
+    void test_empty()
+    {
+        dynamic_any e;
+
+        check_equal(visit<int>(e, describe(), no_match), std::string("empty"), "fallback for empty");
+
+        TEST_CHECK_THROW(
+            visit<int>(e, describe()),
+            bad_dynamic_any_cast,
+            "visit of an empty dynamic_any");
+    }
+
+    void test_const_operand()
+    {
+        const dynamic_any i(7);
+        int fallbacks = 0;
+
+        check_equal(visit<int, std::string>(i, describe_const()), std::string("int 7"), "const int");
+        visit<std::string>(i, describe_const(),
+            [&](const dynamic_any &) { ++fallbacks; return std::string(); });
+        check_equal(fallbacks, 1, "const fallback");
+    }
+
+    void test_repeated_visits()
+    {
+        dynamic_any values[] = { dynamic_any(1), dynamic_any(derived()), dynamic_any(2.5),
+                                 dynamic_any(std::string("x")), dynamic_any() };
+        int counts[3] = { 0, 0, 0 };
+
+        const count_kinds counter = { counts };
+
+        for(int round = 0; round != 10; ++round)
+            for(dynamic_any & value : values)
+                visit<int, base>(value, counter, counter);
+
+        check_equal(counts[0], 10, "ints");
+        check_equal(counts[1], 10, "bases");
+        check_equal(counts[2], 30, "fallbacks");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
@@ -0,0 +1,271 @@
+// what:  unit tests for boost::dynamic_function
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+
+#include "boost/dynamic_function.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_default_ctor();
+    void test_function_pointer();
+    void test_function_object();
+    void test_explicit_signature();
+    void test_reference_parameters();
+    void test_results();
+    void test_bad_call();
+    void test_copy_and_swap();
+    void test_noexcept();
+
+    const test_case test_cases[] =
+    {
+        { "default construction",       test_default_ctor         },
+        { "function pointer",           test_function_pointer     },
+        { "function object",            test_function_object      },
+        { "explicit signature",         test_explicit_signature   },
+        { "reference parameters",       test_reference_parameters },
+        { "results",                    test_results              },
+        { "mismatched arguments",       test_bad_call             },
+        { "copy and swap",              test_copy_and_swap        },
+        { "noexcept callables",         test_noexcept             }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+    using boost::typeindex::type_id;
+
+    int add(int a, int b)
+    {
+        return a + b;
+    }
+
+    struct repeat
+    {
+        std::string operator()(const std::string & s, unsigned n) const
+        {
+            std::string result;
+            while(n--)
+                result += s;
+            return result;
+        }
+    };
+
+    struct overloaded
+    {
+        int operator()(int i) const { return i + 1; }
+        int operator()(const std::string & s) const { return int(s.size()); }
+    };
+
+    struct multiply
+    {
+        template<typename T>
+        T operator()(T x, T y) const { return x * y; }
+    };
+
+    void increment(int & i)
+    {
+        ++i;
+    }
+
+    struct counter
+    {
+        int calls;
+
+        int operator()()
+        {
+            return ++calls;
+        }
+    };
+
+#ifdef __cpp_noexcept_function_type
+    int twice(int i) noexcept
+    {
+        return 2 * i;
+    }
+
+    struct negate
+    {
+        int operator()(int i) const noexcept { return -i; }
+    };
+
+    struct accumulate
+    {
+        int total;
+
+        int operator()(int i) noexcept { return total += i; }
+    };
+#endif
+
+    const std::string & longer(const std::string & a, const std::string & b)
+    {
+        return a.size() < b.size() ? b : a;
+    }
+
+    void test_default_ctor()
+    {
+        const dynamic_function f;
+
+        check_true(f.empty(), "empty");
+        check_false(f.accepts(0, 0), "accepts no call");
+        TEST_CHECK_THROW(f(0, 0), bad_dynamic_function_call, "call of empty function");
+    }
+
+    void test_function_pointer()
+    {
+        const dynamic_function f = &add;
+        int a = 2;
+        const int b = 3;
+
+        check_false(f.empty(), "empty");
+        check_equal(f.arity(), 2u, "arity");
+        check_equal(f.argument_type(0), type_id<int>(), "argument type");
+        check_equal(f.result_type(), type_id<int>(), "result type");
+        check_equal(dynamic_any_cast<int>(f({a, b})), 5, "called with mutable and const arguments");
+
+        const any_ref args[] = { any_ref(a), any_ref(a) };
+        check_true(f.accepts(args, 2), "accepts");
+        check_equal(dynamic_any_cast<int>(f(args, 2)), 4, "called with an array of arguments");
+    }
+
+    void test_function_object()
+    {
+        const std::string s = "ab";
+        unsigned n = 3;
+
+        const dynamic_function f = repeat();
+        check_equal(f.argument_type(1), type_id<unsigned>(), "argument type");
+        check_equal(dynamic_any_cast<std::string>(f({s, n})), std::string("ababab"), "functor");
+
+        const dynamic_function g = [](const std::string & text) { return text.size(); };
+        check_equal(dynamic_any_cast<std::size_t>(g({s})), s.size(), "lambda");
+    }
+
+    void test_explicit_signature()
+    {
+        const dynamic_function by_int = make_dynamic_function<int(int)>(overloaded());
+        const dynamic_function by_string = make_dynamic_function<int(const std::string &)>(overloaded());
+        const int i = 41;
+        const std::string s = "four";
+
+        check_equal(dynamic_any_cast<int>(by_int({i})), 42, "int overload");
+        check_equal(dynamic_any_cast<int>(by_string({s})), 4, "string overload");
+        const any_ref text[] = { any_ref(s) };
+        check_false(by_int.accepts(text, 1), "other overload not taken");
+
+        const dynamic_function generic = make_dynamic_function<long(long, long)>(multiply());
+        const long x = 6, y = 7;
+        check_equal(dynamic_any_cast<long>(generic({x, y})), 42l, "templated call operator");
+    }
+
+    void test_reference_parameters()
+    {
+        const dynamic_function f = &increment;
+        int i = 1;
+        const int c = 1;
+
+        f({i});
+        check_equal(i, 2, "modified through a mutable reference");
+
+        const any_ref to_const[] = { any_ref(c) };
+        check_false(f.accepts(to_const, 1), "const argument for a mutable reference");
+        TEST_CHECK_THROW(f(to_const, 1), bad_dynamic_function_call, "const argument for a mutable reference");
+        check_equal(c, 1, "const argument left alone");
+    }
+
+    void test_results()
+    {
+        const dynamic_function f = &increment;
+        int i = 0;
+        check_true(f({i}).empty(), "void result");
+        check_equal(f.result_type(), type_id<void>(), "void result type");
+
+        const std::string a = "short", b = "longer";
+        const dynamic_function g = &longer;
+        const dynamic_any result = g({a, b});
+        check_equal(result.type(), type_id<std::string>(), "reference result held by value");
+        check_equal(dynamic_any_cast<std::string>(result), b, "reference result");
+        check_unequal(dynamic_any_cast<std::string>(&result), &b, "reference result copied");
+    }
+
+    void test_bad_call()
+    {
+        const dynamic_function f = &add;
+        const int a = 1;
+        const long l = 2;
+
+        TEST_CHECK_THROW(f({a}), bad_dynamic_function_call, "too few arguments");
+        TEST_CHECK_THROW(f({a, a, a}), bad_dynamic_function_call, "too many arguments");
+        TEST_CHECK_THROW(f({a, l}), bad_dynamic_function_call, "argument of another type");
+        TEST_CHECK_THROW(f({a, any_ref()}), bad_dynamic_function_call, "empty argument");
+    }
+
+    void test_copy_and_swap()
+    {
+        counter c = { 0 };
+        dynamic_function f = c;
+        f({});
+        f({});
+
+        dynamic_function copy = f;
+        check_equal(dynamic_any_cast<int>(copy({})), 3, "copy keeps the callable's state");
+        check_equal(dynamic_any_cast<int>(f({})), 3, "state not shared with the copy");
+
+        dynamic_function other = &add;
+        swap(f, other);
+        check_equal(f.arity(), 2u, "swapped");
+        check_equal(other.arity(), 0u, "swapped");
+    }
+
+    void test_noexcept()
+    {
+#ifdef __cpp_noexcept_function_type
+        const int i = 21;
+
+        const dynamic_function f = &twice;
+        check_equal(f.argument_type(0), type_id<int>(), "argument type of a noexcept function");
+        check_equal(dynamic_any_cast<int>(f({i})), 42, "noexcept function");
+
+        const dynamic_function g = negate();
+        check_equal(dynamic_any_cast<int>(g({i})), -21, "noexcept const call operator");
+
+        accumulate a = { 0 };
+        dynamic_function h = a;
+        h({i});
+        check_equal(dynamic_any_cast<int>(h({i})), 42, "noexcept call operator");
+
+        const dynamic_function l = [](int x) noexcept { return x + 1; };
+        check_equal(dynamic_any_cast<int>(l({i})), 22, "noexcept lambda");
+#endif
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
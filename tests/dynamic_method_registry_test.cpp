@@ -0,0 +1,215 @@
+// what:  unit tests for boost::dynamic_method_registry
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/dynamic_method_registry.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_interning();
+    void test_call_by_name();
+    void test_overloads();
+    void test_repeated_resolution();
+    void test_no_overload();
+    void test_added_overload();
+    void test_threads();
+    void test_full_cache();
+
+    const test_case test_cases[] =
+    {
+        { "interned names",              test_interning           },
+        { "call by name and by id",      test_call_by_name        },
+        { "overload resolution",         test_overloads           },
+        { "repeated resolution",         test_repeated_resolution },
+        { "no matching overload",        test_no_overload         },
+        { "overload added after calls",  test_added_overload      },
+        { "calls from several threads",  test_threads             },
+        { "more calls than the table",   test_full_cache          }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+
+    int add(int a, int b) { return a + b; }
+    std::string concat(const std::string & a, const std::string & b) { return a + b; }
+    int negate(int a) { return -a; }
+    void clear(std::string & s) { s.clear(); }
+    std::size_t length(const std::string & s) { return s.size(); }
+
+    void test_interning()
+    {
+        dynamic_method_registry methods;
+        check_null(methods.find("add"), "unknown name");
+
+        const dynamic_method_registry::method_id id = methods.add("add", &add);
+        check_equal(methods.add("add", &concat), id, "same name, same id");
+        check_equal(methods.find("add"), id, "found");
+        check_equal(methods.name(id), std::string("add"), "name");
+        check_equal(methods.overloads(id), 2u, "overloads");
+        check_true(methods.add("negate", &negate) != id, "other name, other id");
+    }
+
+    void test_call_by_name()
+    {
+        dynamic_method_registry methods;
+        const dynamic_method_registry::method_id id = methods.add("add", &add);
+        const int a = 2, b = 3;
+
+        check_equal(dynamic_any_cast<int>(methods.call(id, {a, b})), 5, "by id");
+        check_equal(dynamic_any_cast<int>(methods.call("add", {a, b})), 5, "by name");
+
+        const any_ref args[] = { any_ref(a), any_ref(b) };
+        check_equal(dynamic_any_cast<int>(methods.call(id, args, 2)), 5, "array of arguments");
+        TEST_CHECK_THROW(methods.call("sub", {a, b}), bad_dynamic_function_call, "unknown name");
+    }
+
+    void test_overloads()
+    {
+        dynamic_method_registry methods;
+        methods.add("f", &add);
+        methods.add("f", &concat);
+        methods.add("f", &negate);
+        methods.add("f", &clear);
+        methods.add("f", &length);
+
+        const int i = 4;
+        const std::string s = "ab";
+        std::string m = "cd";
+
+        check_equal(dynamic_any_cast<int>(methods.call("f", {i, i})), 8, "by types");
+        check_equal(dynamic_any_cast<std::string>(methods.call("f", {s, s})), std::string("abab"), "by types");
+        check_equal(dynamic_any_cast<int>(methods.call("f", {i})), -4, "by arity");
+        check_equal(dynamic_any_cast<std::size_t>(methods.call("f", {s})), 2u, "const argument");
+
+        check_true(methods.call("f", {m}).empty(), "mutable argument, first overload taking it");
+        check_true(m.empty(), "modified");
+    }
+
+    void test_repeated_resolution()
+    {
+        dynamic_method_registry methods;
+        const dynamic_method_registry::method_id id = methods.add("f", &add);
+        methods.add("f", &negate);
+
+        int total = 0;
+        for(int i = 0; i != 100; ++i)
+        {
+            total += dynamic_any_cast<int>(methods.call(id, {i, i}));
+            total += dynamic_any_cast<int>(methods.call(id, {i}));
+        }
+        check_equal(total, 4950, "same results once resolved");
+
+        const int a = 1;
+        const any_ref args[] = { any_ref(a) };
+        check_equal(methods.resolve(id, args, 1), methods.resolve(id, args, 1), "same overload");
+    }
+
+    void test_no_overload()
+    {
+        dynamic_method_registry methods;
+        const dynamic_method_registry::method_id id = methods.add("f", &add);
+        const long l = 1;
+        const any_ref args[] = { any_ref(l), any_ref(l) };
+
+        for(int pass = 0; pass != 2; ++pass)
+        {
+            check_null(methods.resolve(id, args, 2), "no overload");
+            TEST_CHECK_THROW(methods.call(id, args, 2), bad_dynamic_function_call, "no overload");
+        }
+    }
+
+    void test_added_overload()
+    {
+        dynamic_method_registry methods;
+        const dynamic_method_registry::method_id id = methods.add("f", &add);
+        const std::string s = "x";
+        const any_ref args[] = { any_ref(s), any_ref(s) };
+
+        check_null(methods.resolve(id, args, 2), "not yet");
+        methods.add("f", &concat);
+        check_equal(dynamic_any_cast<std::string>(methods.call(id, args, 2)), std::string("xx"),
+            "resolved again");
+    }
+
+    void test_threads()
+    {
+        dynamic_method_registry methods;
+        const dynamic_method_registry::method_id id = methods.add("f", &add);
+        methods.add("f", &concat);
+        methods.add("f", &negate);
+
+        std::vector<long> sums(4);
+        std::vector<std::thread> threads;
+        for(std::size_t t = 0; t != sums.size(); ++t)
+            threads.push_back(std::thread([&methods, &sums, id, t]() {
+                const std::string s = "ab";
+                for(int i = 0; i != 1000; ++i)
+                {
+                    sums[t] += dynamic_any_cast<int>(methods.call(id, {i, i}));
+                    sums[t] += dynamic_any_cast<int>(methods.call(id, {i}));
+                    sums[t] += long(dynamic_any_cast<std::string>(methods.call(id, {s, s})).size());
+                }
+            }));
+        for(std::size_t t = 0; t != threads.size(); ++t)
+            threads[t].join();
+
+        for(std::size_t t = 0; t != sums.size(); ++t)
+            check_equal(sums[t], 499500l + 4000l, "every thread");
+    }
+
+    void test_full_cache()
+    {
+        // more methods than BOOST_DYNAMIC_METHOD_CACHE_SIZE, so that some
+        // find every slot they may take already taken
+        dynamic_method_registry methods;
+        std::vector<dynamic_method_registry::method_id> ids;
+        for(int i = 0; i != 3000; ++i)
+        {
+            ids.push_back(methods.add("f" + std::to_string(i), &negate));
+            methods.add("f" + std::to_string(i), &add);
+        }
+
+        for(int pass = 0; pass != 2; ++pass)
+        {
+            long total = 0;
+            for(std::size_t i = 0; i != ids.size(); ++i)
+                total += dynamic_any_cast<int>(methods.call(ids[i], {int(i), 1}))
+                    + dynamic_any_cast<int>(methods.call(ids[i], {1}));
+            check_equal(total, 4498500l, "resolved whether kept or not");
+        }
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
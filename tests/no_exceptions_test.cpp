@@ -0,0 +1,131 @@
+// what:  builds every header with exceptions disabled and checks the
+//        non-throwing casts; test.hpp relies on exceptions, so failures
+//        are reported through the exit status instead
+// where: tested with g++ 12 -fno-exceptions
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "boost/any_ref.hpp"
+#include "boost/bounded_dynamic_any.hpp"
+#include "boost/dynamic_any.hpp"
+#include "boost/dynamic_any_algorithm.hpp"
+#include "boost/dynamic_any_collection.hpp"
+#include "boost/dynamic_any_parallel.hpp"
+#include "boost/dynamic_any_queue.hpp"
+#include "boost/dynamic_any_serialization.hpp"
+#include "boost/dynamic_any_stats.hpp"
+#include "boost/dynamic_any_vector.hpp"
+#include "boost/dynamic_any_visit.hpp"
+#include "boost/dynamic_function.hpp"
+#include "boost/dynamic_method_registry.hpp"
+#include "boost/shared_dynamic_any.hpp"
+
+namespace boost
+{
+    // required by boost::throw_exception under BOOST_NO_EXCEPTIONS; no
+    // failed cast below may get here
+    void throw_exception(const std::exception &)
+    {
+        std::fputs("unexpected boost::throw_exception\n", stderr);
+        std::abort();
+    }
+}
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * description)
+    {
+        if(!condition)
+        {
+            std::fprintf(stderr, "failed: %s\n", description);
+            ++failures;
+        }
+    }
+
+    struct base { int a; };
+    struct derived : base { int b; };
+
+    struct twice
+    {
+        int operator()(int & i) const { return 2 * i; }
+    };
+
+    int unmatched(boost::dynamic_any &)
+    {
+        return -1;
+    }
+}
+
+BOOST_DYNAMIC_ANY_BASES(derived, base)
+
+int main()
+{
+    using namespace boost;
+
+    dynamic_any text = std::string("text"), number = 42, object = derived();
+    check(try_cast<std::string>(text)->size() == 4, "try_cast to held type");
+    check(!try_cast<int>(text), "try_cast miss");
+    check(try_cast<base>(object).is_initialized(), "try_cast to base");
+    check(dynamic_any_cast<double>(&number) == 0, "pointer cast miss");
+
+    int x = 7;
+    any_ref r = x;
+    check(&*try_cast<int>(r) == &x, "any_ref try_cast");
+    check(!try_cast<long>(r), "any_ref try_cast miss");
+
+    check(visit<int>(number, twice(), unmatched) == 84, "visit");
+    check(visit<int>(text, twice(), unmatched) == -1, "visit fallback");
+
+    dynamic_any_vector values;
+    values.push_back(number);
+    values.push_back(1);
+    check(dynamic_any_cast<int>(&values, 1) != 0, "vector");
+
+    dynamic_any_collection grouped;
+    grouped.insert(1);
+    grouped.insert(2);
+    check(grouped.count<int>() == 2, "collection");
+
+    const dynamic_any range[] = { number, text, 1 };
+    check(filter<int>(range, range + 3).size() == 2, "filter");
+
+    parallel_executor executor(2);
+    std::vector<dynamic_any> many(3000, number);
+    check(parallel_reduce<int>(executor, many.begin(), many.end(), 0, twice(), std::plus<int>()) == 3000 * 84,
+          "parallel_reduce");
+
+    dynamic_any_queue queue(2);
+    dynamic_any popped;
+    check(queue.try_push(number) && queue.try_pop(popped) && dynamic_any_cast<int>(popped) == 42,
+          "queue");
+    check(!queue.try_pop(popped), "empty queue");
+
+    shared_dynamic_any shared = std::string("shared"), copy = shared;
+    check(try_cast<std::string>(static_cast<const shared_dynamic_any &>(copy))->size() == 6,
+          "shared try_cast");
+    check(dynamic_any_cast<int>(&copy) == 0 && shared.use_count() == 2, "shared cast miss");
+
+    bounded_dynamic_any<int, derived> bounded = derived();
+    check(try_cast<base>(bounded).is_initialized(), "bounded try_cast to base");
+    check(dynamic_any_cast<int>(&bounded) == 0, "bounded cast miss");
+
+    const dynamic_function doubled = twice();
+    const any_ref args[] = { any_ref(x) };
+    check(dynamic_any_cast<int>(doubled(args, 1)) == 14, "dynamic_function");
+    check(!doubled.accepts(args, 0), "dynamic_function arity mismatch");
+
+    dynamic_method_registry methods;
+    const dynamic_method_registry::method_id id = methods.add("twice", doubled);
+    check(methods.find("twice") == id, "registry find");
+    check(methods.resolve(id, args, 0) == 0, "registry resolution miss");
+
+    std::printf("%d failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+// what:  unit tests for boost::shared_dynamic_any
+// who:   modelled on the boost::any tests contributed by Kevlin Henney
+// where: tested with g++ 12
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/shared_dynamic_any.hpp"
+#include "test.hpp"
+
+namespace any_tests
+{
+    typedef test<const char *, void (*)()> test_case;
+    typedef const test_case * test_case_iterator;
+
+    extern const test_case_iterator begin, end;
+}
+
+int main()
+{
+    using namespace any_tests;
+    tester<test_case_iterator> test_suite(begin, end);
+    return test_suite() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace any_tests // test suite
+{
+    void test_default_ctor();
+    void test_converting_ctor();
+    void test_copy_shares();
+    void test_copy_on_write();
+    void test_unique_write();
+    void test_written_value_stays_private();
+    void test_failed_cast_keeps_sharing();
+    void test_dynamic_cast();
+    void test_assignment();
+    void test_concurrent_readers();
+
+    const test_case test_cases[] =
+    {
+        { "default construction",           test_default_ctor              },
+        { "single argument construction",   test_converting_ctor           },
+        { "copies share the value",         test_copy_shares               },
+        { "copy on write",                  test_copy_on_write             },
+        { "unshared value is not copied",   test_unique_write              },
+        { "written value stays private",    test_written_value_stays_private },
+        { "failed cast keeps sharing",      test_failed_cast_keeps_sharing },
+        { "dynamic cast",                   test_dynamic_cast              },
+        { "assignment",                     test_assignment                },
+        { "concurrent readers",             test_concurrent_readers        }
+    };
+
+    const test_case_iterator begin = test_cases;
+    const test_case_iterator end =
+        test_cases + (sizeof test_cases / sizeof *test_cases);
+}
+
+namespace any_tests // test definitions
+{
+    using namespace boost;
+    using boost::typeindex::type_id;
+
+    struct base
+    {
+        int a;
+    };
+
+    struct base1
+    {
+        int a1;
+    };
+
+    struct derived : base, base1
+    {
+        int b;
+    };
+
+    struct other {};
+
+    struct copy_counter
+    {
+        copy_counter() : value(0) {}
+        copy_counter(const copy_counter & other) : value(other.value) { ++copies; }
+        int value;
+        static int copies;
+    };
+
+    int copy_counter::copies = 0;
+}
+
+BOOST_DYNAMIC_ANY_BASES(any_tests::derived, any_tests::base, any_tests::base1)
+
+namespace any_tests
+{
+    void test_default_ctor()
+    {
+        const shared_dynamic_any value;
+
+        check_true(value.empty(), "empty");
+        check_equal(value.use_count(), 0u, "use_count");
+        check_equal(value.type(), type_id<void>(), "type");
+        check_null(dynamic_any_cast<int>(&value), "dynamic_any_cast<int>");
+    }
+
+    void test_converting_ctor()
+    {
+        std::string text = "test message";
+        shared_dynamic_any value = text;
+
+        check_false(value.empty(), "empty");
+        check_true(value.unique(), "unique");
+        check_equal(value.type(), type_id<std::string>(), "type");
+        check_equal(dynamic_any_cast<std::string>(value), text, "comparing cast copy against original text");
+        check_null(dynamic_any_cast<int>(&value), "cast to other type");
+    }
+
+    void test_copy_shares()
+    {
+        copy_counter::copies = 0;
+        const shared_dynamic_any original = copy_counter();
+        const int constructed = copy_counter::copies;
+
+        const std::vector<shared_dynamic_any> copies(10, original);
+
+        check_equal(copy_counter::copies, constructed, "copies do not copy the value");
+        check_equal(original.use_count(), 11u, "use_count");
+        {
+            const std::vector<shared_dynamic_any> more(copies);
+            check_equal(original.use_count(), 21u, "use_count of copied copies");
+        }
+        check_equal(original.use_count(), 11u, "use_count once the copies are gone");
+        check_equal(dynamic_any_cast<copy_counter>(&copies[3]),
+                    dynamic_any_cast<copy_counter>(&original), "copies refer to the same value");
+
+    }
+
+    void test_copy_on_write()
+    {
+        copy_counter::copies = 0;
+        shared_dynamic_any original = copy_counter();
+        shared_dynamic_any copy = original;
+        const int constructed = copy_counter::copies;
+
+        dynamic_any_cast<copy_counter &>(copy).value = 7;
+
+        check_equal(copy_counter::copies, constructed + 1, "value copied once on write");
+        check_true(copy.unique(), "written copy has its own value");
+        check_true(original.unique(), "original is no longer shared");
+        check_equal(dynamic_any_cast<const copy_counter &>(original).value, 0, "original unchanged");
+        check_equal(dynamic_any_cast<const copy_counter &>(copy).value, 7, "copy changed");
+    }
+
+    void test_unique_write()
+    {
+        copy_counter::copies = 0;
+        shared_dynamic_any value = copy_counter();
+        const int constructed = copy_counter::copies;
+        const copy_counter * before = dynamic_any_cast<copy_counter>(
+            static_cast<const shared_dynamic_any *>(&value));
+
+        copy_counter * after = dynamic_any_cast<copy_counter>(&value);
+
+        check_equal(copy_counter::copies, constructed, "no copy");
+        check_equal(static_cast<const copy_counter *>(after), before, "same value");
+    }
+
+    void test_written_value_stays_private()
+    {
+        shared_dynamic_any a = std::string("text");
+        std::string & r = dynamic_any_cast<std::string &>(a);
+
+        shared_dynamic_any b = a;
+        check_false(a.use_count() == 2u, "copy does not share a written value");
+        r = "x";
+        check_equal(dynamic_any_cast<const std::string &>(b), std::string("text"),
+            "copy unchanged by an earlier reference");
+
+        shared_dynamic_any c;
+        c = a;
+        r = "y";
+        check_equal(dynamic_any_cast<const std::string &>(c), std::string("x"),
+            "assigned copy unchanged by an earlier reference");
+
+        std::string & placed = a.emplace<std::string>(3u, 'z');
+        shared_dynamic_any d = a;
+        placed = "w";
+        check_equal(dynamic_any_cast<const std::string &>(d), std::string("zzz"),
+            "copy unchanged by the reference emplace returned");
+
+        a = std::string("new");
+        shared_dynamic_any e = a;
+        check_equal(a.use_count(), 2u, "a newly assigned value is shared again");
+        check_equal(dynamic_any_cast<std::string>(e), std::string("new"), "copy by value");
+        check_equal(a.use_count(), 2u, "copying the value out keeps it shared");
+    }
+
+    void test_failed_cast_keeps_sharing()
+    {
+        shared_dynamic_any original = std::string("text");
+        shared_dynamic_any copy = original;
+
+        check_null(dynamic_any_cast<int>(&copy), "cast to other type");
+        check_equal(original.use_count(), 2u, "still shared");
+
+        const shared_dynamic_any & ccopy = copy;
+        check_equal(*try_cast<std::string>(ccopy), std::string("text"), "try_cast");
+        check_equal(original.use_count(), 2u, "still shared after reading");
+    }
+
+    void test_dynamic_cast()
+    {
+        derived d;
+        d.a = 1;
+        d.a1 = 2;
+        shared_dynamic_any original = d;
+        shared_dynamic_any copy = original;
+
+        check_equal(dynamic_any_cast<const base1 &>(original).a1, 2, "const base");
+        check_equal(original.use_count(), 2u, "const base cast does not copy");
+
+        dynamic_any_cast<base1 &>(copy).a1 = 3;
+        check_equal(dynamic_any_cast<const base1 &>(original).a1, 2, "original base unchanged");
+        check_equal(dynamic_any_cast<const derived &>(copy).a1, 3, "base of private copy changed");
+
+        TEST_CHECK_THROW(
+            dynamic_any_cast<other &>(copy),
+            bad_dynamic_any_cast,
+            "dynamic_any_cast to incorrect reference type");
+    }
+
+    void test_assignment()
+    {
+        shared_dynamic_any value = 1;
+        shared_dynamic_any copy;
+        copy = value;
+        check_equal(value.use_count(), 2u, "copy assignment shares");
+
+        copy = std::string("text");
+        check_true(value.unique(), "converting assignment releases the shared value");
+        check_equal(dynamic_any_cast<std::string>(copy), std::string("text"), "assigned value");
+
+        std::string & text = copy.emplace<std::string>(3u, 'x');
+        check_equal(text, std::string("xxx"), "emplace");
+
+        value = std::move(copy);
+        check_true(copy.empty(), "moved-from is empty");
+        check_equal(dynamic_any_cast<std::string>(value), std::string("xxx"), "moved value");
+
+        value.clear();
+        check_true(value.empty(), "empty after clear");
+    }
+
+    void test_concurrent_readers()
+    {
+        const shared_dynamic_any original = std::vector<int>(1000, 1);
+        const unsigned threads = 8;
+        std::vector<int> sums(threads);
+        std::vector<std::thread> readers;
+
+        for(unsigned t = 0; t != threads; ++t)
+            readers.push_back(std::thread([&original, &sums, t]() {
+                for(int round = 0; round != 1000; ++round)
+                {
+                    const shared_dynamic_any copy = original;
+                    const std::vector<int> & v = dynamic_any_cast<const std::vector<int> &>(copy);
+                    sums[t] += v[round];
+                }
+            }));
+        for(unsigned t = 0; t != threads; ++t)
+            readers[t].join();
+
+        for(unsigned t = 0; t != threads; ++t)
+            check_equal(sums[t], 1000, "reader saw the shared value");
+        check_true(original.unique(), "all copies released");
+    }
+}
+
+// Copyright Kevlin Henney, 2000, 2001. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//